@@ -0,0 +1,292 @@
+// Microbenchmarks for the engine's hot paths.
+// Each benchmark runs its operation until at least MIN_TIME has passed and reports the time and the number of
+// operator new calls per operation.  Allocations made directly with malloc, e.g. inside stb_image, are not counted.
+// Run from the repository root so the resources are found.  An optional argument runs only the benchmarks whose
+// name contains it.
+
+#include "window.h"
+#include "matrixstack.h"
+#include "camera.h"
+#include "shaders.h"
+#include "shadercache.h"
+#include "image.h"
+#include "audiomanager.h"
+#include "openassetimportmesh.h"
+#include "jobsystem.h"
+
+using Clock = std::chrono::steady_clock;
+
+static std::atomic<uint64_t> s_allocations{0};
+
+void* operator new(std::size_t size)
+{
+    s_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size != 0 ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+// Results are written here so the compiler can't drop the work that produced them
+static volatile float s_sink;
+
+static const std::chrono::milliseconds MIN_TIME{200};
+static const uint64_t MAX_ITERATIONS = 1ull << 30;
+
+static std::string s_filter;
+
+// Times an operation, doubling the iteration count until the run is long enough to trust
+template <typename Operation>
+static void Run(const char* name, Operation&& operation)
+{
+    if (!s_filter.empty() && std::string_view(name).find(s_filter) == std::string_view::npos)
+        return;
+
+    // The first call pays for lazy initialisation and cold caches
+    operation();
+
+    for (uint64_t iterations = 1; ; iterations *= 2) {
+        uint64_t allocations = s_allocations.load(std::memory_order_relaxed);
+        auto start = Clock::now();
+        for (uint64_t i = 0; i < iterations; i++)
+            operation();
+        auto elapsed = Clock::now() - start;
+        allocations = s_allocations.load(std::memory_order_relaxed) - allocations;
+
+        if (elapsed >= MIN_TIME || iterations >= MAX_ITERATIONS) {
+            double ns = std::chrono::duration<double, std::nano>(elapsed).count();
+            std::printf("%-45s %14.1f ns/op %10.2f allocs/op %12llu iterations\n", name, ns / iterations,
+                        static_cast<double>(allocations) / iterations, static_cast<unsigned long long>(iterations));
+            return;
+        }
+    }
+}
+
+static void Skip(const char* name, const char* reason)
+{
+    std::printf("%-45s skipped: %s\n", name, reason);
+}
+
+// Drops everything written to std::cout while it exists, for operations that log each time they run.  Errors still
+// reach std::cerr.
+class QuietStdout
+{
+public:
+    QuietStdout() : m_pBuffer(std::cout.rdbuf(nullptr)) {}
+    ~QuietStdout() { std::cout.rdbuf(m_pBuffer); }  // Also clears the bad bit the dropped writes set
+
+private:
+    std::streambuf* m_pBuffer;
+};
+
+static void BenchmarkMatrixStack()
+{
+    glutil::MatrixStack stack;
+    stack.SetIdentity();
+
+    // The sequence Game::Render runs for every object
+    Run("MatrixStack Push/Translate/Rotate/Scale/Pop", [&] {
+        stack.Push();
+        stack.Translate(glm::vec3{100.0f, 0.0f, 0.0f});
+        stack.Rotate(glm::vec3{0.0f, 1.0f, 0.0f}, 180.0f);
+        stack.Scale(2.5f);
+        s_sink = stack.Top()[3][0];
+        stack.Pop();
+    });
+
+    Run("MatrixStack LookAt", [&] {
+        stack.SetIdentity();
+        stack.LookAt(glm::vec3{0.0f, 30.0f, 300.0f}, glm::vec3{0.0f, 0.0f, 0.0f}, glm::vec3{0.0f, 1.0f, 0.0f});
+        s_sink = stack.Top()[3][2];
+    });
+}
+
+static void BenchmarkCamera()
+{
+    CCamera camera;
+    glm::mat4 modelView = glm::lookAt(glm::vec3{0.0f, 30.0f, 300.0f}, glm::vec3{0.0f}, glm::vec3{0.0f, 1.0f, 0.0f});
+    modelView = glm::scale(modelView, glm::vec3{2.5f});
+
+    Run("CCamera::ComputeNormalMatrix", [&] {
+        s_sink = camera.ComputeNormalMatrix(modelView)[0][0];
+    });
+}
+
+static void BenchmarkSetUniform()
+{
+    CShader vertexShader, fragmentShader;
+    if (!vertexShader.LoadShader("resources/shaders/textShader.vert", GL_VERTEX_SHADER) ||
+        !fragmentShader.LoadShader("resources/shaders/textShader.frag", GL_FRAGMENT_SHADER)) {
+        Skip("CShaderProgram::SetUniform", "text shader failed to compile");
+        return;
+    }
+
+    CShaderProgram program;
+    program.CreateProgram();
+    program.AddShaderToProgram(&vertexShader);
+    program.AddShaderToProgram(&fragmentShader);
+    if (!program.LinkProgram()) {
+        Skip("CShaderProgram::SetUniform", "text shader failed to link");
+        return;
+    }
+    program.UseProgram();
+
+    glm::mat4 matrix{1.0f};
+    glm::vec4 colour{0.5f};
+
+    // Every run changes the value each time so the upload is never skipped as redundant
+    Run("CShaderProgram::SetUniform mat4", [&] {
+        matrix[3][0] += 1.0f;
+        program.SetUniform("textModelViewMatrix", matrix);
+    });
+
+    Run("CShaderProgram::SetUniform vec4", [&] {
+        colour.x += 1.0f;
+        program.SetUniform("vColour", colour);
+    });
+
+    CShaderProgram::Uniform<glm::mat4> modelView = program.GetUniform<glm::mat4>("textModelViewMatrix");
+    Run("CShaderProgram::SetUniform mat4 handle", [&] {
+        matrix[3][0] += 1.0f;
+        program.SetUniform(modelView, matrix);
+    });
+
+    // glFinish keeps the driver's queue from growing without bound while the benchmark runs
+    glFinish();
+    program.DeleteProgram();
+}
+
+// Stores a linked program and loads it back, which must hit.  Returns false if it doesn't, so a cache that never
+// hits fails the run instead of only making startup slower.
+static bool BenchmarkShaderCache()
+{
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "OpenGLTemplateBenchShaderCache";
+    CShaderCache cache(directory);
+    if (!cache.IsEnabled()) {
+        Skip("CShaderCache::Load", "the driver can't save program binaries");
+        return true;
+    }
+
+    CShader vertexShader, fragmentShader;
+    if (!vertexShader.LoadShader("resources/shaders/placeholder.vert", GL_VERTEX_SHADER) ||
+        !fragmentShader.LoadShader("resources/shaders/placeholder.frag", GL_FRAGMENT_SHADER)) {
+        Skip("CShaderCache::Load", "placeholder shader failed to compile");
+        return true;
+    }
+
+    CShaderProgram program;
+    program.CreateProgram();
+    program.AddShaderToProgram(&vertexShader);
+    program.AddShaderToProgram(&fragmentShader);
+    glProgramParameteri(program.GetProgramID(), GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    if (!program.LinkProgram()) {
+        Skip("CShaderCache::Load", "placeholder shader failed to link");
+        return true;
+    }
+
+    const uint64_t key = CShaderCache::AddToKey(cache.BeginKey(), "bench");
+    cache.Store(key, program.GetProgramID());
+
+    GLuint loaded = glCreateProgram();
+    bool bHit = cache.Load(key, loaded);
+    if (!bHit) {
+        std::cerr << "Error! CShaderCache::Load missed a binary it has just stored" << std::endl;
+    } else {
+        Run("CShaderCache::Load", [&] {
+            s_sink = cache.Load(key, loaded) ? 1.0f : 0.0f;
+        });
+    }
+
+    glDeleteProgram(loaded);
+    program.DeleteProgram();
+    std::error_code error;
+    std::filesystem::remove_all(directory, error);
+    return bHit;
+}
+
+static void BenchmarkImage()
+{
+    const char* path = "resources/textures/grassfloor01.jpg";
+    if (!std::filesystem::exists(path)) {
+        Skip("Image decode", "texture not found");
+        return;
+    }
+
+    Run("Image decode grassfloor01.jpg", [&] {
+        Image image{path};
+        s_sink = image.width;
+    });
+}
+
+static void BenchmarkLoadWav()
+{
+    const char* path = "resources/audio/Boing.wav";
+    if (!std::filesystem::exists(path)) {
+        Skip("CAudioManager::LoadWav", "sound not found");
+        return;
+    }
+
+    Run("CAudioManager::LoadWav Boing.wav", [&] {
+        uint8_t channels, bitsPerSample;
+        int32_t sampleRate;
+        std::vector<char> samples = CAudioManager::LoadWav(path, channels, sampleRate, bitsPerSample);
+        s_sink = static_cast<float>(samples.size());
+    });
+}
+
+static void BenchmarkMeshImport()
+{
+    const char* path = "resources/models/Horse/horse2.obj";
+    if (!std::filesystem::exists(path)) {
+        Skip("COpenAssetImportMesh::Load", "model not found");
+        return;
+    }
+
+    // Includes decoding the materials' textures and copying the geometry into the arena, as at startup.  Each mesh
+    // gives its ranges back when it is destroyed, so the arena doesn't grow between iterations.
+    CGeometryArena geometry;
+    geometry.Create<Vertex>(64 * 1024, 256 * 1024);
+    Run("COpenAssetImportMesh::Load horse2.obj", [&] {
+        QuietStdout quiet;
+        COpenAssetImportMesh mesh;
+        s_sink = mesh.Load(path, geometry) ? 1.0f : 0.0f;
+    });
+
+    // The same with the vertices compressed before they are copied
+    CGeometryArena compactGeometry;
+    compactGeometry.Create<CompactVertex>(64 * 1024, 256 * 1024);
+    Run("COpenAssetImportMesh::Load horse2.obj compact", [&] {
+        QuietStdout quiet;
+        COpenAssetImportMesh mesh;
+        s_sink = mesh.Load(path, compactGeometry) ? 1.0f : 0.0f;
+    });
+}
+
+int main(int argc, char** argv)
+{
+    if (argc > 1)
+        s_filter = argv[1];
+
+    // The GL benchmarks need a context, a hidden window provides one
+    Window window{"OpenGLTemplateBench", {64, 64}, {}, true};
+    JobSystem jobs;
+
+    BenchmarkMatrixStack();
+    BenchmarkCamera();
+    BenchmarkSetUniform();
+    bool bPassed = BenchmarkShaderCache();
+    BenchmarkImage();
+    BenchmarkLoadWav();
+    BenchmarkMeshImport();
+
+    return bPassed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
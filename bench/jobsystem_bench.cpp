@@ -0,0 +1,102 @@
+// Stress test and scaling benchmark for the job system.
+// Runs the same workloads with 1 to N threads and reports the time and speedup relative to a single thread.
+
+#include "jobsystem.h"
+
+using Clock = std::chrono::steady_clock;
+
+static double ElapsedMs(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Data-parallel workload: an expensive per-element transform split with ParallelFor
+static double RunParallelFor(JobSystem& jobs, std::vector<float>& data)
+{
+    auto start = Clock::now();
+    jobs.ParallelFor(static_cast<uint32_t>(data.size()), 4096, [&data](uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; i++) {
+            float x = static_cast<float>(i) * 0.001f;
+            for (int k = 0; k < 16; k++)
+                x = std::sqrt(x * x + 1.0f) * 0.5f + std::sin(x);
+            data[i] = x;
+        }
+    });
+    return ElapsedMs(start);
+}
+
+// Task-graph workload: many small jobs, each fanning out into continuations joined by a final job
+static double RunTaskGraph(JobSystem& jobs, uint32_t roots, uint32_t fanOut, std::atomic<uint32_t>& counter)
+{
+    auto start = Clock::now();
+
+    std::vector<JobHandle> joins;
+    joins.reserve(roots);
+    for (uint32_t r = 0; r < roots; r++) {
+        auto root = jobs.Schedule([&counter] { counter.fetch_add(1, std::memory_order_relaxed); });
+
+        std::vector<JobHandle> children;
+        children.reserve(fanOut);
+        for (uint32_t c = 0; c < fanOut; c++) {
+            children.push_back(jobs.Then(root, [&counter] {
+                volatile float x = 1.0f;
+                for (int k = 0; k < 256; k++)
+                    x = x * 1.0001f + 0.5f;
+                counter.fetch_add(1, std::memory_order_relaxed);
+            }));
+        }
+
+        joins.push_back(jobs.Schedule([&counter] { counter.fetch_add(1, std::memory_order_relaxed); }, children));
+    }
+
+    jobs.Wait(joins);
+    return ElapsedMs(start);
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    if (argc > 1)
+        maxThreads = std::max(1, std::atoi(argv[1]));
+
+    const uint32_t roots = 2000;
+    const uint32_t fanOut = 32;
+    const uint32_t expectedJobs = roots * (fanOut + 2);
+    const int repeats = 5;
+
+    std::vector<float> data(1 << 22);
+    double baseParallelFor = 0.0;
+    double baseTaskGraph = 0.0;
+    bool failed = false;
+
+    std::cout << "threads  parallel_for(ms)  speedup  task_graph(ms)  speedup  jobs/s" << std::endl;
+
+    for (uint32_t threads = 1; threads <= maxThreads; threads++) {
+        JobSystem jobs{ threads };
+
+        // Take the best of several runs to filter out scheduling noise
+        double parallelFor = std::numeric_limits<double>::max();
+        double taskGraph = std::numeric_limits<double>::max();
+        for (int i = 0; i < repeats; i++) {
+            parallelFor = std::min(parallelFor, RunParallelFor(jobs, data));
+
+            std::atomic<uint32_t> counter{ 0 };
+            taskGraph = std::min(taskGraph, RunTaskGraph(jobs, roots, fanOut, counter));
+            if (counter != expectedJobs) {
+                std::cerr << "ERROR: task graph ran " << counter << " jobs, expected " << expectedJobs << std::endl;
+                failed = true;
+            }
+        }
+
+        if (threads == 1) {
+            baseParallelFor = parallelFor;
+            baseTaskGraph = taskGraph;
+        }
+
+        std::printf("%7u  %16.2f  %7.2fx  %14.2f  %7.2fx  %.0f\n",
+                    threads, parallelFor, baseParallelFor / parallelFor,
+                    taskGraph, baseTaskGraph / taskGraph, expectedJobs / (taskGraph / 1000.0));
+    }
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -4,16 +4,23 @@
 #include <fstream>
 #include <iostream>
 #include <sstream>
+#include <iomanip>
 #include <algorithm>
 #include <functional>
 #include <memory>
 #include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
 #include <utility>
 #include <cstdlib>
 #include <cstddef>
 #include <filesystem>
 #include <cstring>
+#include <cerrno>
 #include <string>
+#include <string_view>
 #include <stack>
 #include <deque>
 #include <array>
@@ -26,6 +33,12 @@
 #include <unordered_set>
 #include <optional>
 
+// SIMD, code using it has a scalar fallback
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define USE_SSE2 1
+#include <emmintrin.h>
+#endif
+
 // OPENGL/VULKAN
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
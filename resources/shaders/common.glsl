@@ -0,0 +1,47 @@
+// Declarations shared by every program, included after the #version line
+
+// Structure holding light information:  its position as well as ambient, diffuse, and specular colours
+struct LightInfo
+{
+	vec4 position;
+	vec3 La;
+	vec3 Ld;
+	vec3 Ls;
+};
+
+// Structure holding material information:  its ambient, diffuse, and specular colours, shininess, and which texture
+// slots it has a texture in (bit per MaterialTexture in material.h)
+struct MaterialInfo
+{
+	vec3 Ma;
+	vec3 Md;
+	vec3 Ms;
+	float shininess;
+	uint textures;
+};
+
+// Data that stays the same for the whole frame, shared by all programs.  Must match FrameUniforms in uniforms.h.
+layout (std140) uniform PerFrame
+{
+	mat4 projMatrix;
+	mat4 orthoMatrix;
+	mat4 viewMatrix;
+	LightInfo light1;
+	vec4 clusterScale;		// Tiles per pixel in x and y, then the scale and bias giving the depth slice from log depth
+	uvec4 clusterCount;		// Clusters in x, y and z, then the number of point lights
+};
+
+// Data set for every draw.  Must match DrawUniforms in uniforms.h.
+layout (std140) uniform PerDraw
+{
+	mat4 modelViewMatrix;
+	mat3 normalMatrix;
+	uint materialIndex;		// Into materials
+};
+
+// Every material, uploaded once and shared by all draws.  Must match CMaterialTable in material.h.
+const int MAX_MATERIALS = 256;
+layout (std140) uniform Materials
+{
+	MaterialInfo materials[MAX_MATERIALS];
+};
@@ -0,0 +1,53 @@
+// Lighting of the lit programs, per fragment: the frame's main light plus the point lights of the fragment's
+// cluster.  Must be included after common.glsl.
+
+// Point lights sorted into clusters on the CPU, see CLightClusters
+uniform usamplerBuffer clusterGrid;			// Per cluster: offset into clusterLightIndices and number of lights
+uniform usamplerBuffer clusterLightIndices;	// The lists of all clusters, one after the other
+uniform samplerBuffer clusterLights;		// Per light: position in eye coordinates and radius, then colour
+
+// Diffuse and specular reflection of one light, s is the direction to the light, n the normal and v the direction to the eye.
+// The code is based on the OpenGL 4.0 Shading Language Cookbook, Chapter 2, pp. 62 - 63, with a few tweaks. 
+vec3 Phong(MaterialInfo material, vec3 s, vec3 n, vec3 v, vec3 Ld, vec3 Ls)
+{
+	vec3 r = reflect(-s, n);
+	float sDotN = max(dot(s, n), 0.0f);
+	vec3 diffuse = Ld * material.Md * sDotN;
+	vec3 specular = vec3(0.0f);
+	float eps = 0.000001f; // add eps to shininess below -- pow not defined if second argument is 0 (as described in GLSL documentation)
+	if (sDotN > 0.0f) 
+		specular = Ls * material.Ms * pow(max(dot(r, v), 0.0f), material.shininess + eps);
+	return diffuse + specular;
+}
+
+// Index of the cluster the fragment falls into, eyeDepth is its distance in front of the eye
+int ClusterIndex(float eyeDepth)
+{
+	uvec3 cluster;
+	cluster.xy = uvec2(gl_FragCoord.xy * clusterScale.xy);
+	cluster.z = uint(max(log(eyeDepth) * clusterScale.z + clusterScale.w, 0.0f));
+	cluster = min(cluster, clusterCount.xyz - 1u);
+	return int((cluster.z * clusterCount.y + cluster.y) * clusterCount.x + cluster.x);
+}
+
+// Phong model of all lights reaching a point in eye coordinates with normal n
+vec3 PhongModel(MaterialInfo material, vec3 eyePosition, vec3 n)
+{
+	vec3 v = normalize(-eyePosition);
+	vec3 s = normalize(light1.position.xyz - eyePosition);
+	vec3 colour = light1.La * material.Ma + Phong(material, s, n, v, light1.Ld, light1.Ls);
+
+	uvec2 cluster = texelFetch(clusterGrid, ClusterIndex(-eyePosition.z)).xy;
+	for (uint i = 0u; i < cluster.y; i++) {
+		int light = int(texelFetch(clusterLightIndices, int(cluster.x + i)).r);
+		vec4 positionRadius = texelFetch(clusterLights, 2 * light);
+		vec3 lightColour = texelFetch(clusterLights, 2 * light + 1).rgb;
+
+		// Falls off smoothly to nothing at the radius, which is what the lights are sorted into clusters by
+		vec3 toLight = positionRadius.xyz - eyePosition;
+		float distance = length(toLight);
+		float falloff = clamp(1.0f - distance / positionRadius.w, 0.0f, 1.0f);
+		colour += falloff * falloff * Phong(material, toLight / max(distance, 0.0001f), n, v, lightColour, lightColour);
+	}
+	return colour;
+}
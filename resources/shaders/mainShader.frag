@@ -1,34 +1,39 @@
 #version 400 core
 
-in vec3 vColour;			// Interpolated colour using colour calculated in the vertex shader
-in vec2 vTexCoord;			// Interpolated texture coordinate using texture coordinate from the vertex shader
+#include "common.glsl"
+#include "lighting.glsl"
+
+// Features switched on by the program variant, see mainShader.vert
 
 out vec4 vOutputColour;		// The output colour
 
-uniform sampler2D sampler0;  // The texture sampler
-uniform samplerCube CubeMapTex;
-uniform bool bUseTexture;    // A flag indicating if texture-mapping should be applied
-uniform bool renderSkybox;
+#if defined(SKYBOX)
 in vec3 worldPosition;
+uniform samplerCube CubeMapTex;
+#else
+in vec3 vEyePosition;		// Interpolated position and normal in eye coordinates
+in vec3 vEyeNorm;
+#endif
+
+#if defined(TEXTURED)
+in vec2 vTexCoord;			// Interpolated texture coordinate using texture coordinate from the vertex shader
+uniform sampler2D sampler0;  // The texture sampler
+#endif
 
 
 void main()
 {
-
-
-	if (renderSkybox) {
-		vOutputColour = texture(CubeMapTex, worldPosition);
-
-	} else {
-
-		// Get the texel colour from the texture sampler
-		vec4 vTexColour = texture(sampler0, vTexCoord);	
-
-		if (bUseTexture)
-			vOutputColour = vTexColour*vec4(vColour, 1.0f);	// Combine object colour and texture 
-		else
-			vOutputColour = vec4(vColour, 1.0f);	// Just use the colour instead
-	}
-	
-	
+#if defined(SKYBOX)
+	vOutputColour = texture(CubeMapTex, worldPosition);
+#else
+	// Apply the Phong model to compute the colour
+	vec3 vColour = PhongModel(materials[materialIndex], vEyePosition, normalize(vEyeNorm));
+#if defined(TEXTURED)
+	// Combine object colour and texture 
+	vOutputColour = texture(sampler0, vTexCoord)*vec4(vColour, 1.0f);
+#else
+	// Just use the colour instead
+	vOutputColour = vec4(vColour, 1.0f);
+#endif
+#endif
 }
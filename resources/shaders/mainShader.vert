@@ -1,86 +1,59 @@
 #version 400 core
 
-// Structure for matrices
-uniform struct Matrices
-{
-	mat4 projMatrix;
-	mat4 modelViewMatrix; 
-	mat3 normalMatrix;
-} matrices;
+#include "common.glsl"
 
-// Structure holding light information:  its position as well as ambient, diffuse, and specular colours
-struct LightInfo
-{
-	vec4 position;
-	vec3 La;
-	vec3 Ld;
-	vec3 Ls;
-};
-
-// Structure holding material information:  its ambient, diffuse, and specular colours, and shininess
-struct MaterialInfo
-{
-	vec3 Ma;
-	vec3 Md;
-	vec3 Ms;
-	float shininess;
-};
-
-// Lights and materials passed in as uniform variables from client programme
-uniform LightInfo light1; 
-uniform MaterialInfo material1; 
+// Features switched on by the program variant:
+//   SKYBOX    only passes on the position to look up the cube map with, there is no lighting
+//   TEXTURED  passes on the texture coordinate
+//   COMPACT   reads CompactVertex, whose normals are octahedral-encoded.  Its integer positions are scaled to object
+//             space by the model view matrix.
 
 // Layout of vertex attributes in VBO
 layout (location = 0) in vec3 inPosition;
 layout (location = 1) in vec2 inCoord;
+#if defined(COMPACT)
+layout (location = 2) in vec2 inNormal;
+#else
 layout (location = 2) in vec3 inNormal;
-
-// Vertex colour output to fragment shader -- using Gouraud (interpolated) shading
-out vec3 vColour;	// Colour computed using reflectance model
+#endif
+
+#if defined(SKYBOX)
+out vec3 worldPosition;	// Direction to look up the cube map with
+#else
+// Lighting is done per fragment, see lighting.glsl
+out vec3 vEyePosition;	// Position in eye coordinates
+out vec3 vEyeNorm;		// Normal in eye coordinates
+#endif
+#if defined(TEXTURED)
 out vec2 vTexCoord;	// Texture coordinate
+#endif
 
-out vec3 worldPosition;	// used for skybox
-
-// This function implements the Phong shading model
-// The code is based on the OpenGL 4.0 Shading Language Cookbook, Chapter 2, pp. 62 - 63, with a few tweaks. 
-// Please see Chapter 2 of the book for a detailed discussion.
-vec3 PhongModel(vec4 eyePosition, vec3 eyeNorm)
-{
-	vec3 s = normalize(vec3(light1.position - eyePosition));
-	vec3 v = normalize(-eyePosition.xyz);
-	vec3 r = reflect(-s, eyeNorm);
-	vec3 n = eyeNorm;
-	vec3 ambient = light1.La * material1.Ma;
-	float sDotN = max(dot(s, n), 0.0f);
-	vec3 diffuse = light1.Ld * material1.Md * sDotN;
-	vec3 specular = vec3(0.0f);
-	float eps = 0.000001f; // add eps to shininess below -- pow not defined if second argument is 0 (as described in GLSL documentation)
-	if (sDotN > 0.0f) 
-		specular = light1.Ls * material1.Ms * pow(max(dot(r, v), 0.0f), material1.shininess + eps);
-	
-
-	return ambient + diffuse + specular;
-
-}
+#if defined(COMPACT)
+#include "octahedral.glsl"
+#endif
 
 // This is the entry point into the vertex shader
 void main()
 {	
 
-// Save the world position for rendering the skybox
-	worldPosition = inPosition;
-
 	// Transform the vertex spatial position using 
-	gl_Position = matrices.projMatrix * matrices.modelViewMatrix * vec4(inPosition, 1.0f);
-	
+	gl_Position = projMatrix * modelViewMatrix * vec4(inPosition, 1.0f);
+
+#if defined(SKYBOX)
+	// Save the world position for rendering the skybox
+	worldPosition = inPosition;
+#else
 	// Get the vertex normal and vertex position in eye coordinates
-	vec3 vEyeNorm = normalize(matrices.normalMatrix * inNormal);
-	vec4 vEyePosition = matrices.modelViewMatrix * vec4(inPosition, 1.0f);
-		
-	// Apply the Phong model to compute the vertex colour
-	vColour = PhongModel(vEyePosition, vEyeNorm);
-	
+#if defined(COMPACT)
+	vEyeNorm = normalMatrix * DecodeOctahedral(inNormal);
+#else
+	vEyeNorm = normalMatrix * inNormal;
+#endif
+	vEyePosition = vec3(modelViewMatrix * vec4(inPosition, 1.0f));
+#endif
+
+#if defined(TEXTURED)
 	// Pass through the texture coordinate
 	vTexCoord = inCoord;
+#endif
 } 
-	
\ No newline at end of file
@@ -0,0 +1,11 @@
+// Normals of CompactVertex, which CVertexCompressor::EncodeOctahedral folds onto a square
+
+// Unfolds a normal encoded by CVertexCompressor::EncodeOctahedral
+vec3 DecodeOctahedral(vec2 e)
+{
+	vec3 n = vec3(e, 1.0f - abs(e.x) - abs(e.y));
+	float t = max(-n.z, 0.0f);
+	n.x += n.x >= 0.0f ? -t : t;
+	n.y += n.y >= 0.0f ? -t : t;
+	return normalize(n);
+}
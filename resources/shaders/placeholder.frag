@@ -0,0 +1,11 @@
+#version 400 core
+
+in vec3 vEyeNorm;
+
+out vec4 vOutputColour;
+
+void main()
+{
+	// Flat grey with a little shading from a light at the eye, enough to make out shapes
+	vOutputColour = vec4(vec3(0.4f + 0.4f * abs(normalize(vEyeNorm).z)), 1.0f);
+}
@@ -0,0 +1,27 @@
+#version 400 core
+
+// Drawn in place of programs that are still compiling, it only needs the blocks every program shares.  COMPACT reads
+// CompactVertex, like the main shader's variant of the same name.
+
+#include "common.glsl"
+
+layout (location = 0) in vec3 inPosition;
+#if defined(COMPACT)
+layout (location = 2) in vec2 inNormal;
+
+#include "octahedral.glsl"
+#else
+layout (location = 2) in vec3 inNormal;
+#endif
+
+out vec3 vEyeNorm;
+
+void main()
+{
+	gl_Position = projMatrix * modelViewMatrix * vec4(inPosition, 1.0f);
+#if defined(COMPACT)
+	vEyeNorm = normalize(normalMatrix * DecodeOctahedral(inNormal));
+#else
+	vEyeNorm = normalize(normalMatrix * inNormal);
+#endif
+}
@@ -1,11 +1,8 @@
 #version 400 core
 
-// Structure for matrices
-uniform struct Matrices
-{
-	mat4 projMatrix;
-	mat4 modelViewMatrix;
-} matrices;
+#include "common.glsl"
+
+uniform mat4 textModelViewMatrix;	// Moves the printed text into place, the projection is orthoMatrix from PerFrame
 
 // Layout of vertex attributes in VBO
 layout (location = 0) in vec2 inPosition;
@@ -16,7 +13,7 @@ out vec2 vTexCoord;
 void main()
 {
 	// Transform the point
-	gl_Position = matrices.projMatrix * matrices.modelViewMatrix * vec4(inPosition, 0.0, 1.0);
+	gl_Position = orthoMatrix * textModelViewMatrix * vec4(inPosition, 0.0, 1.0);
 
 	// Pass through the texture coord
 	vTexCoord = inCoord;
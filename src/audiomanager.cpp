@@ -1,5 +1,6 @@
 #include "audiomanager.h"
 #include "audio.h"
+#include "trace.h"
 
 CAudioManager::CAudioManager()
 {}
@@ -37,6 +38,8 @@ void CAudioManager::Destroy() {
 
 void CAudioManager::Update()
 {
+    TRACE_SCOPE("CAudioManager::Update");
+
     for (auto& [path, audio] : m_sounds)
     {
         audio->Update();
@@ -45,6 +48,8 @@ void CAudioManager::Update()
 
 bool CAudioManager::Load(const std::string& path)
 {
+    TRACE_SCOPE("CAudioManager::Load");
+
     if (m_sounds.find(path) != m_sounds.end())
         return false;
 
@@ -18,13 +18,15 @@ public:
     void Stop(const std::string& path);
 	void Update();
 
+    // Reads a PCM WAV file, returning the sample data and filling in its format.  Returns no data on failure.
+    static std::vector<char> LoadWav(const std::string& filename, uint8_t& channels, int32_t& sampleRate, uint8_t& bitsPerSample);
+
 private:
     ALCcontext* context;
     ALCdevice* device;
     std::unordered_map<std::string, CAudio*> m_sounds;
 
     static bool LoadWavHeaderFile(std::ifstream& file, uint8_t& channels, int32_t& sampleRate, uint8_t& bitsPerSample, ALsizei& size);
-    static std::vector<char> LoadWav(const std::string& filename, uint8_t& channels, int32_t& sampleRate, uint8_t& bitsPerSample);
 
     friend class CAudio;
 };
@@ -0,0 +1,148 @@
+#include "benchmark.h"
+#include "camera.h"
+
+// Control points of the fly-through, a closed loop around the horse, the barrel and the sphere
+static const glm::vec3 PATH[] = {
+	{0.0f, 30.0f, 300.0f},
+	{220.0f, 40.0f, 180.0f},
+	{260.0f, 20.0f, -60.0f},
+	{80.0f, 60.0f, -260.0f},
+	{-180.0f, 35.0f, -200.0f},
+	{-260.0f, 15.0f, 40.0f},
+	{-120.0f, 25.0f, 240.0f},
+};
+static const glm::vec3 PATH_TARGET {30.0f, 5.0f, 50.0f};	// The camera keeps looking at the middle of the scene
+
+// Uniform Catmull-Rom segment between p1 and p2
+static glm::vec3 CatmullRom(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3, float t)
+{
+	float t2 = t * t;
+	float t3 = t2 * t;
+	return 0.5f * ((2.0f * p1) + (p2 - p0) * t + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2 + (3.0f * p1 - p0 - 3.0f * p2 + p3) * t3);
+}
+
+CBenchmark::CBenchmark(int frames, int warmupFrames)
+{
+	m_frames = frames;
+	m_warmupFrames = warmupFrames;
+	m_results.resize(frames, {0.0, 0.0, 0, 0, 0, 0});
+}
+
+// The whole loop is flown once over the measured frames, during the warm-up the camera waits at the start
+void CBenchmark::UpdateCamera(CCamera& camera, int frame) const
+{
+	const int count = static_cast<int>(std::size(PATH));
+
+	float t = static_cast<float>(std::max(frame - m_warmupFrames, 0)) / static_cast<float>(m_frames) * count;
+	int segment = static_cast<int>(t);
+	float u = t - static_cast<float>(segment);
+
+	const glm::vec3& p0 = PATH[(segment + count - 1) % count];
+	const glm::vec3& p1 = PATH[segment % count];
+	const glm::vec3& p2 = PATH[(segment + 1) % count];
+	const glm::vec3& p3 = PATH[(segment + 2) % count];
+
+	camera.Set(CatmullRom(p0, p1, p2, p3, u), PATH_TARGET, glm::vec3{0.0f, 1.0f, 0.0f});
+}
+
+CBenchmark::Frame* CBenchmark::GetFrame(int frame)
+{
+	int index = frame - m_warmupFrames;
+	if (index < 0 || index >= m_frames)
+		return nullptr;
+	return &m_results[index];
+}
+
+void CBenchmark::AddCpuTime(int frame, double ms)
+{
+	if (Frame* result = GetFrame(frame))
+		result->cpuTime = ms;
+}
+
+void CBenchmark::AddFrameStats(const std::vector<CRenderThread::FrameStats>& stats)
+{
+	for (const CRenderThread::FrameStats& frameStats : stats) {
+		if (Frame* result = GetFrame(static_cast<int>(frameStats.frame))) {
+			result->gpuTime = frameStats.gpuTime;
+			result->drawCalls = frameStats.drawCalls;
+			result->triangles = frameStats.triangles;
+			result->stateChanges = frameStats.stateChanges;
+			result->filteredStateChanges = frameStats.filteredStateChanges;
+		}
+	}
+}
+
+// Nearest-rank percentiles
+CBenchmark::Summary CBenchmark::Summarise(std::vector<double> values)
+{
+	if (values.empty())
+		return {};
+
+	std::sort(values.begin(), values.end());
+	auto percentile = [&](double p) {
+		size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * values.size()));
+		return values[std::clamp<size_t>(rank, 1, values.size()) - 1];
+	};
+
+	double sum = 0.0;
+	for (double value : values)
+		sum += value;
+
+	return {values.front(), sum / values.size(), percentile(50), percentile(90), percentile(95), percentile(99), values.back()};
+}
+
+void CBenchmark::WriteSummary(std::ostream& out, const char* name, const Summary& summary)
+{
+	out << "\"" << name << "\": {\"min\": " << summary.min << ", \"mean\": " << summary.mean << ", \"p50\": " << summary.p50
+		<< ", \"p90\": " << summary.p90 << ", \"p95\": " << summary.p95 << ", \"p99\": " << summary.p99 << ", \"max\": " << summary.max << "}";
+}
+
+bool CBenchmark::WriteResults(const std::filesystem::path& path) const
+{
+	std::vector<double> cpuTimes, gpuTimes;
+	for (const Frame& frame : m_results) {
+		cpuTimes.push_back(frame.cpuTime);
+		gpuTimes.push_back(frame.gpuTime);
+	}
+	Summary cpu = Summarise(cpuTimes);
+	Summary gpu = Summarise(gpuTimes);
+
+	std::filesystem::path csvPath = path;
+	std::ofstream csv(csvPath.replace_extension(".csv"));
+	csv << std::fixed << std::setprecision(4);
+	csv << "frame,cpu_ms,gpu_ms,draw_calls,triangles,state_changes,filtered_state_changes\n";
+	for (size_t i = 0; i < m_results.size(); i++) {
+		const Frame& frame = m_results[i];
+		csv << i << ',' << frame.cpuTime << ',' << frame.gpuTime << ',' << frame.drawCalls << ',' << frame.triangles << ','
+			<< frame.stateChanges << ',' << frame.filteredStateChanges << '\n';
+	}
+
+	std::filesystem::path jsonPath = path;
+	std::ofstream json(jsonPath.replace_extension(".json"));
+	json << std::fixed << std::setprecision(4);
+	json << "{\n\"frames\": " << m_frames << ",\n\"warmupFrames\": " << m_warmupFrames << ",\n";
+	WriteSummary(json, "cpu", cpu);
+	json << ",\n";
+	WriteSummary(json, "gpu", gpu);
+	json << ",\n\"results\": [\n";
+	for (size_t i = 0; i < m_results.size(); i++) {
+		const Frame& frame = m_results[i];
+		json << "{\"frame\": " << i << ", \"cpu\": " << frame.cpuTime << ", \"gpu\": " << frame.gpuTime
+			 << ", \"drawCalls\": " << frame.drawCalls << ", \"triangles\": " << frame.triangles
+			 << ", \"stateChanges\": " << frame.stateChanges << ", \"filteredStateChanges\": " << frame.filteredStateChanges << "}"
+			 << (i + 1 < m_results.size() ? ",\n" : "\n");
+	}
+	json << "]\n}\n";
+
+	if (!csv || !json) {
+		std::cerr << "Failed to write benchmark results to " << csvPath << " and " << jsonPath << std::endl;
+		return false;
+	}
+
+	std::cout << std::fixed << std::setprecision(3)
+			  << "Benchmark: " << m_frames << " frames after " << m_warmupFrames << " warm-up frames\n"
+			  << "  CPU ms  p50 " << cpu.p50 << "  p95 " << cpu.p95 << "  p99 " << cpu.p99 << "  max " << cpu.max << '\n'
+			  << "  GPU ms  p50 " << gpu.p50 << "  p95 " << gpu.p95 << "  p99 " << gpu.p99 << "  max " << gpu.max << '\n'
+			  << "Results written to " << csvPath << " and " << jsonPath << std::endl;
+	return true;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "renderthread.h"
+
+class CCamera;
+
+// Scripted fly-through used by --benchmark.  The camera follows a fixed spline path through the scene, so every run
+// renders the same sequence of frames.  After the warm-up frames, each frame's CPU time, GPU time, draw calls,
+// triangles and state changes are kept, and at the end they are written out with percentile summaries.
+class CBenchmark
+{
+public:
+	CBenchmark(int frames, int warmupFrames);
+
+	int GetTotalFrames() const { return m_warmupFrames + m_frames; }
+
+	// Places the camera on the path for the given frame
+	void UpdateCamera(CCamera& camera, int frame) const;
+
+	// CPU time is the main thread's time to simulate and record the frame, the rest comes from the render thread
+	void AddCpuTime(int frame, double ms);
+	void AddFrameStats(const std::vector<CRenderThread::FrameStats>& stats);
+
+	// Writes <path>.csv with one row per frame and <path>.json with the summaries and the frames, prints a summary
+	bool WriteResults(const std::filesystem::path& path) const;
+
+private:
+	struct Frame
+	{
+		double cpuTime;
+		double gpuTime;
+		uint32_t drawCalls;
+		uint64_t triangles;
+		uint32_t stateChanges;
+		uint32_t filteredStateChanges;
+	};
+
+	struct Summary
+	{
+		double min, mean, p50, p90, p95, p99, max;
+	};
+
+	int m_frames;
+	int m_warmupFrames;
+	std::vector<Frame> m_results;	// Measured frames only, warm-up frames are dropped
+
+	Frame* GetFrame(int frame);
+	static Summary Summarise(std::vector<double> values);
+	static void WriteSummary(std::ostream& out, const char* name, const Summary& summary);
+};
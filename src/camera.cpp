@@ -8,6 +8,8 @@ CCamera::CCamera()
 	m_position = glm::vec3{0.0f, 10.0f, 100.0f};
 	m_view = glm::vec3{0.0f, 0.0f, 0.0f};
 	m_upVector = glm::vec3{0.0f, 1.0f, 0.0f};
+	m_previousPosition = m_position;
+	m_previousView = m_view;
 	m_speed = 0.025f;
 }
 CCamera::~CCamera()
@@ -19,6 +21,8 @@ void CCamera::Set(const glm::vec3 &position, const glm::vec3 &viewpoint, const g
 	m_position = position;
 	m_view = viewpoint;
 	m_upVector = upVector;
+	m_previousPosition = m_position;
+	m_previousView = m_view;
 }
 
 // Respond to mouse movement
@@ -92,6 +96,10 @@ void CCamera::Advance(double direction)
 // Update the camera to respond to mouse motion for rotations and keyboard for translation
 void CCamera::Update(double dt)
 {
+	// Keep the state from before this step so rendering can interpolate towards the new one
+	m_previousPosition = m_position;
+	m_previousView = m_view;
+
 	glm::vec3 vector = glm::cross(m_view - m_position, m_upVector);
 	m_strafeVector = glm::normalize(vector);
 
@@ -142,6 +150,18 @@ glm::vec3 CCamera::GetStrafeVector() const
 	return m_strafeVector;
 }
 
+// Return the camera position interpolated between the previous and current simulation step
+glm::vec3 CCamera::GetInterpolatedPosition(float alpha) const
+{
+	return glm::mix(m_previousPosition, m_position, alpha);
+}
+
+// Return the camera view point interpolated between the previous and current simulation step
+glm::vec3 CCamera::GetInterpolatedView(float alpha) const
+{
+	return glm::mix(m_previousView, m_view, alpha);
+}
+
 // Return the camera perspective projection matrix
 glm::mat4* CCamera::GetPerspectiveProjectionMatrix()
 {
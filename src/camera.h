@@ -13,6 +13,10 @@ public:
 	glm::mat4* GetOrthographicProjectionMatrix();	// Gets the camera orthographic projection matrix
 	glm::mat4 GetViewMatrix();						// Gets the camera view matrix - note this is not stored in the class but returned using glm::lookAt() in GetViewMatrix()
 
+	// Gets the position and view point blended between the previous and current simulation step (alpha in [0, 1])
+	glm::vec3 GetInterpolatedPosition(float alpha) const;
+	glm::vec3 GetInterpolatedView(float alpha) const;
+
 	// Set the camera position, viewpoint, and up vector
 	void Set(const glm::vec3 &position, const glm::vec3 &viewpoint, const glm::vec3 &upVector);
 	
@@ -46,6 +50,9 @@ private:
 	glm::vec3 m_upVector;			// The camera's up vector
 	glm::vec3 m_strafeVector;		// The camera's strafe vector
 
+	glm::vec3 m_previousPosition;	// The position at the start of the last simulation step
+	glm::vec3 m_previousView;		// The viewpoint at the start of the last simulation step
+
 	float m_speed;					// How fast the camera moves
 
 	glm::mat4 m_perspectiveProjectionMatrix;		// Perspective projection matrix
@@ -1,27 +1,39 @@
 #include "cubemap.h"
+#include "glstatecache.h"
 #include "image.h"
+#include "jobsystem.h"
+#include "renderqueue.h"
+#include "trace.h"
 
-// Binds a texture for rendering
-void CCubemap::Bind(int iTextureUnit)
+// Returns how to bind the texture in a draw packet
+TextureBinding CCubemap::GetBinding(int iTextureUnit) const
 {
-	glActiveTexture(GL_TEXTURE0+iTextureUnit);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, m_uiTexture);
-	glBindSampler(iTextureUnit, m_uiSampler);
+	return {TextureTarget::CubeMap, static_cast<uint32_t>(iTextureUnit), m_uiTexture, m_uiSampler};
 }
 
 // Create the plane, including its geometry, texture mapping, normal, and colour
 void CCubemap::Create(const std::string& sPositiveX, const std::string& sNegativeX, const std::string& sPositiveY, const std::string& sNegativeY, const std::string& sPositiveZ, const std::string& sNegativeZ)
 {
+	TRACE_SCOPE("CCubemap::Create");
+
 	// Generate an OpenGL texture ID for this texture
 	glGenTextures(1, &m_uiTexture);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, m_uiTexture);
-
-	Image positiveX {sPositiveX};
-	Image negativeX {sNegativeX};
-	Image positiveY {sPositiveY};
-	Image negativeY {sNegativeY};
-	Image positiveZ {sPositiveZ};
-	Image negativeZ {sNegativeZ};
+	CGLStateCache::Get().BindTexture(0, GL_TEXTURE_CUBE_MAP, m_uiTexture);
+
+	// Decode the six faces in parallel, the uploads below have to stay on this thread
+	const std::string* sPaths[6] = { &sPositiveX, &sNegativeX, &sPositiveY, &sNegativeY, &sPositiveZ, &sNegativeZ };
+	std::unique_ptr<Image> faces[6];
+	JobSystem::GetInstance().ParallelFor(6, 1, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; i++)
+			faces[i] = std::make_unique<Image>(*sPaths[i]);
+	});
+
+	const Image& positiveX = *faces[0];
+	const Image& negativeX = *faces[1];
+	const Image& positiveY = *faces[2];
+	const Image& negativeY = *faces[3];
+	const Image& positiveZ = *faces[4];
+	const Image& negativeZ = *faces[5];
 
 	glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X, 0, GL_RGB8, positiveX.width, positiveX.height, 0, GL_BGR, GL_UNSIGNED_BYTE, positiveX.pixels);
 	glTexImage2D(GL_TEXTURE_CUBE_MAP_NEGATIVE_X, 0, GL_RGB8, negativeX.width, negativeX.height, 0, GL_BGR, GL_UNSIGNED_BYTE, negativeX.pixels);
@@ -44,6 +56,8 @@ void CCubemap::Create(const std::string& sPositiveX, const std::string& sNegativ
 // Release resources
 void CCubemap::Release()
 {
+	CGLStateCache::Get().ForgetSampler(m_uiSampler);
+	CGLStateCache::Get().ForgetTexture(m_uiTexture);
 	glDeleteSamplers(1, &m_uiSampler);
 	glDeleteTextures(1, &m_uiTexture);
 }
\ No newline at end of file
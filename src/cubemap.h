@@ -8,7 +8,7 @@ class CCubemap
 public:
 	void Create(const std::string& sPositiveX, const std::string& sNegativeX, const std::string& sPositiveY, const std::string& sNegativeY, const std::string& sPositiveZ, const std::string& sNegativeZ);
 	void Release();
-	void Bind(int iTextureUnit = 0);
+	TextureBinding GetBinding(int iTextureUnit = 0) const;
 
 private:
 	GLuint m_uiVAO;
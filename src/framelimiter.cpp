@@ -0,0 +1,63 @@
+#include "framelimiter.h"
+
+static constexpr std::chrono::microseconds MIN_SPIN_MARGIN{ 100 };
+static constexpr std::chrono::microseconds MAX_SPIN_MARGIN{ 4000 };
+
+CFrameLimiter::CFrameLimiter()
+{
+	m_targetFrameRate = 0;
+	m_period = Clock::duration::zero();
+	m_spinMargin = std::chrono::microseconds{ 1000 };
+}
+
+void CFrameLimiter::SetTargetFrameRate(int fps)
+{
+	if (fps == m_targetFrameRate)
+		return;
+
+	m_targetFrameRate = std::max(fps, 0);
+	m_period = m_targetFrameRate > 0
+		? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / m_targetFrameRate))
+		: Clock::duration::zero();
+	Reset();
+}
+
+int CFrameLimiter::GetTargetFrameRate() const
+{
+	return m_targetFrameRate;
+}
+
+void CFrameLimiter::Reset()
+{
+	m_nextFrame = Clock::now() + m_period;
+}
+
+void CFrameLimiter::Wait()
+{
+	if (m_targetFrameRate == 0)
+		return;
+
+	Clock::time_point now = Clock::now();
+
+	// More than a whole frame late: start over from now rather than rushing frames out to catch up
+	if (now > m_nextFrame + m_period) {
+		m_nextFrame = now + m_period;
+		return;
+	}
+
+	// Sleep for the bulk of the wait and learn how far the OS overshoots
+	Clock::time_point wakeUp = m_nextFrame - m_spinMargin;
+	if (now < wakeUp) {
+		std::this_thread::sleep_until(wakeUp);
+
+		Clock::duration overshoot = Clock::now() - wakeUp;
+		m_spinMargin = std::clamp<Clock::duration>(std::max(overshoot * 5 / 4, m_spinMargin * 15 / 16), MIN_SPIN_MARGIN, MAX_SPIN_MARGIN);
+	}
+
+	// Spin for the remainder to hit the deadline precisely
+	while (Clock::now() < m_nextFrame)
+		std::this_thread::yield();
+
+	// Deadlines advance by whole periods so the average rate does not drift
+	m_nextFrame += m_period;
+}
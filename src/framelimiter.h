@@ -0,0 +1,28 @@
+#pragma once
+
+// Paces the game loop to a target frame rate.  It sleeps for most of the frame and spins for the last short
+// stretch, since OS sleeps overshoot by an unpredictable amount.  The spin margin adapts to the overshoot measured
+// on this machine, so it stays short where sleeps are precise and grows where the scheduler is coarse.
+class CFrameLimiter
+{
+public:
+	CFrameLimiter();
+
+	// Sets the number of frames per second to pace to, 0 disables the limiter
+	void SetTargetFrameRate(int fps);
+	int GetTargetFrameRate() const;
+
+	// Restarts pacing from now, e.g. after the loop was blocked waiting for events
+	void Reset();
+
+	// Blocks until the next frame is due
+	void Wait();
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	int m_targetFrameRate;
+	Clock::duration m_period;			// Time between two frames at the target rate
+	Clock::time_point m_nextFrame;		// When the next frame is due
+	Clock::duration m_spinMargin;		// How long before the deadline to stop sleeping and start spinning
+};
@@ -1,4 +1,6 @@
 #include "freetypefont.h"
+#include "glstatecache.h"
+#include "rendercommandbuffer.h"
 
 CFreeTypeFont::CFreeTypeFont()
 {
@@ -56,26 +58,9 @@ void CFreeTypeFont::CreateChar(int index)
 
 	m_newLine = std::max(m_newLine, int(glyph->metrics.height >> 6));
 
-	// Rendering data, texture coordinates are always the same, so now we waste a little memory
-	glm::vec2 vQuad[] = {
-        {0.0f, float(-m_advY[index]+iTH)},
-        {0.0f, float(-m_advY[index])},
-        {float(iTW), float(-m_advY[index]+iTH)},
-        {float(iTW), float(-m_advY[index])}
-	};
-
-	glm::vec2 vTexQuad[] = {
-            {0.0f, 1.0f},
-            {0.0f, 0.0f},
-            {1.0f, 1.0f},
-            {1.0f, 0.0f}
-    };
-
-	// Add this char to VBO
-	for (int i = 0; i < 4; i++) {
-		m_vbo.AddData(&vQuad[i], sizeof(glm::vec2));
-		m_vbo.AddData(&vTexQuad[i], sizeof(glm::vec2));
-	}
+	// Size of the quad the texture is drawn on
+	m_texWidth[index] = iTW;
+	m_texHeight[index] = iTH;
 }
 
 // Loads an entire font with the given path sFile and pixel size iPXSize
@@ -94,10 +79,9 @@ bool CFreeTypeFont::LoadFont(const std::string& file, int ipixelSize)
 	m_loadedPixelSize = ipixelSize;
 
 	glGenVertexArrays(1, &m_vao);
-	glBindVertexArray(m_vao);
+	CGLStateCache::Get().BindVertexArray(m_vao);
 
-	m_vbo.Create();
-	m_vbo.Bind();
+	m_vbo.CreateStreaming(MAX_GLYPHS_PER_FRAME * 4 * sizeof(GlyphVertex));
 
 	for (int i = 0; i < 128; i++)
 		CreateChar(i);
@@ -106,25 +90,27 @@ bool CFreeTypeFont::LoadFont(const std::string& file, int ipixelSize)
 	FT_Done_Face(m_ftFace);
 	FT_Done_FreeType(m_ftLib);
 	
-	m_vbo.UploadDataToGPU(GL_STATIC_DRAW);
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2)*2, 0);
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2)*2, (void*)(sizeof(glm::vec2)));
+	SetVertexAttributes<GlyphVertex>();
 
 	return true;
 }
 
-// Prints text at the specified location (x, y) with the given pixel size (iPXSize)
-void CFreeTypeFont::Print(const std::string& text, int x, int y, int pixelSize)
+// Prints text at the specified location (x, y) with the given pixel size (iPXSize).  The glyphs' quads are
+// written relative to (x, y) straight into this frame's region of the streaming buffer.
+void CFreeTypeFont::Print(CRenderCommandBuffer& commands, const std::string& text, int x, int y, int pixelSize)
 {
 	if(!m_isLoaded)
 		return;
 
-	glBindVertexArray(m_vao);
-	m_shaderProgram->SetUniform("sampler0", 0);
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	GLint firstVertex = 0;
+	GlyphVertex* pVertices = m_vbo.Allocate<GlyphVertex>(text.size() * 4, firstVertex);
+	if (pVertices == nullptr)
+		return;
+
+	commands.BindVertexArray(m_vao);
+	commands.SetUniform("sampler0", 0);
+	commands.SetUniform("textModelViewMatrix", glm::translate(glm::mat4{1}, glm::vec3{float(x), float(y), 0.0f}));
+	commands.SetBlendMode(BlendMode::Alpha);
 	int iCurX = x, iCurY = y;
 	if (pixelSize == -1)
 		pixelSize = m_loadedPixelSize;
@@ -140,22 +126,30 @@ void CFreeTypeFont::Print(const std::string& text, int x, int y, int pixelSize)
 		}
 		iCurX += m_bearingX[i] * pixelSize / m_loadedPixelSize;
 		if(i != ' ') {
-			m_charTextures[i].Bind();
-			glm::mat4 mModelView = glm::translate(glm::mat4{ 1 }, glm::vec3{float(iCurX), float(iCurY), 0.0f});
-			mModelView = glm::scale(mModelView, glm::vec3{fScale});
-			m_shaderProgram->SetUniform("matrices.modelViewMatrix", mModelView);
+			float left = float(iCurX - x);
+			float right = left + fScale * float(m_texWidth[i]);
+			float bottom = float(iCurY - y) - fScale * float(m_advY[i]);
+			float top = bottom + fScale * float(m_texHeight[i]);
+			pVertices[0] = {{left, top}, {0.0f, 1.0f}};
+			pVertices[1] = {{left, bottom}, {0.0f, 0.0f}};
+			pVertices[2] = {{right, top}, {1.0f, 1.0f}};
+			pVertices[3] = {{right, bottom}, {1.0f, 0.0f}};
+
+			m_charTextures[i].Bind(commands);
 			// Draw character
-			glDrawArrays(GL_TRIANGLE_STRIP, i*4, 4);
+			commands.DrawArrays(PrimitiveType::TriangleStrip, firstVertex, 4);
+			pVertices += 4;
+			firstVertex += 4;
 		}
 
 		iCurX += (m_advX[i] - m_bearingX[i])*pixelSize / m_loadedPixelSize;
 	}
-	glDisable(GL_BLEND);
+	commands.SetBlendMode(BlendMode::Opaque);
 }
 
 
 // Print formatted text at the location (x, y) with specified pixel size (iPXSize)
-void CFreeTypeFont::Render(int x, int y, int pixelSize, const char* text, ...)
+void CFreeTypeFont::Render(CRenderCommandBuffer& commands, int x, int y, int pixelSize, const char* text, ...)
 {
     va_list args;
     va_start(args, text);
@@ -165,7 +159,7 @@ void CFreeTypeFont::Render(int x, int y, int pixelSize, const char* text, ...)
 
     // Static buffer large enough?
     if (n < sizeof(buf)) {
-        Print({buf, n}, x, y, pixelSize);
+        Print(commands, {buf, n}, x, y, pixelSize);
         return;
     }
 
@@ -175,7 +169,7 @@ void CFreeTypeFont::Render(int x, int y, int pixelSize, const char* text, ...)
     std::vsnprintf(const_cast<char*>(s.data()), s.size(), text, args);
     va_end(args);
 
-    Print(s, x, y, pixelSize);
+    Print(commands, s, x, y, pixelSize);
 }
 
 // Deletes all font textures
@@ -184,6 +178,7 @@ void CFreeTypeFont::ReleaseFont()
 	for (int i = 0; i <= CHAR_MAX; i++)
 		m_charTextures[i].Release();
 	m_vbo.Release();
+	CGLStateCache::Get().ForgetVertexArray(m_vao);
 	glDeleteVertexArrays(1, &m_vao);
 }
 
@@ -7,6 +7,22 @@
 #include "shaders.h"
 #include "vertexbufferobject.h"
 
+// Corner of a glyph's quad, the inputs of the text shader
+struct GlyphVertex
+{
+	glm::vec2 position;
+	glm::vec2 texCoord;
+};
+
+template <>
+struct VertexLayout<GlyphVertex>
+{
+	static constexpr VertexAttribute ATTRIBUTES[] = {
+		{0, 2, GL_FLOAT, GL_FALSE, offsetof(GlyphVertex, position)},
+		{1, 2, GL_FLOAT, GL_FALSE, offsetof(GlyphVertex, texCoord)},
+	};
+};
+
 // This class is a wrapper for FreeType fonts and their usage with OpenGL
 class CFreeTypeFont
 {
@@ -18,26 +34,32 @@ public:
 
 	int GetTextWidth(const std::string& text, int pixelSize);
 
-	void Print(const std::string& text, int x, int y, int pixelSize = -1);
-	void Render(int x, int y, int pixelSize, const char* text, ...);
+	void Print(CRenderCommandBuffer& commands, const std::string& text, int x, int y, int pixelSize = -1);
+	void Render(CRenderCommandBuffer& commands, int x, int y, int pixelSize, const char* text, ...);
 
 	void ReleaseFont();
 
 	void SetShaderProgram(CShaderProgram* shaderProgram);
 
+	// Text is written into this buffer every frame, it has to be added to the render thread
+	CVertexBufferObject* GetVertexBuffer() { return &m_vbo; }
+
 private:
+	static const size_t MAX_GLYPHS_PER_FRAME = 4096;
+
 	void CreateChar(int index);
 
     CTexture m_charTextures[UCHAR_MAX+1];
 	int m_advX[UCHAR_MAX+1], m_advY[UCHAR_MAX+1];
 	int m_bearingX[UCHAR_MAX+1], m_bearingY[UCHAR_MAX+1];
 	int m_charWidth[UCHAR_MAX+1], m_charHeight[UCHAR_MAX+1];
+	int m_texWidth[UCHAR_MAX+1], m_texHeight[UCHAR_MAX+1];
 	int m_loadedPixelSize, m_newLine;
 
 	bool m_isLoaded;
 
 	GLuint m_vao;
-	CVertexBufferObject m_vbo;
+	CVertexBufferObject m_vbo;		// Streamed, holds the quads of the text printed this frame
 
 	FT_Library m_ftLib;
 	FT_Face m_ftFace;
@@ -36,29 +36,67 @@ Source code drawn from a number of sources and examples, including contributions
 #include "skybox.h"
 #include "plane.h"
 #include "shaders.h"
+#include "shadercache.h"
+#include "shadercompiler.h"
+#include "shaderpermutations.h"
+#include "shaderwatcher.h"
 #include "freetypefont.h"
 #include "sphere.h"
 #include "matrixstack.h"
 #include "openassetimportmesh.h"
 #include "audiomanager.h"
+#include "jobsystem.h"
+#include "renderthread.h"
+#include "renderqueue.h"
+#include "material.h"
+#include "geometryarena.h"
+#include "lightclusters.h"
+#include "glstatecache.h"
+#include "framelimiter.h"
+#include "profiler.h"
+#include "trace.h"
+#include "benchmark.h"
+
+Game::Options Game::options;
 
 // Constructor
-Game::Game() : m_window {"OpenGL Template", {1280, 720}}
+Game::Game() : m_window {"OpenGL Template", {1280, 720}, {}, options.headless}
 {
     Input::Init(m_window);
 
 	m_pSkybox = nullptr;
 	m_pCamera = nullptr;
 	m_pShaderPrograms = nullptr;
+	m_pShaderCache = nullptr;
+	m_pShaderCompiler = nullptr;
+	m_pMainShaders = nullptr;
+	m_pPlaceholderShaders = nullptr;
+	m_pShaderWatcher = nullptr;
 	m_pPlanarTerrain = nullptr;
 	m_pFtFont = nullptr;
 	m_pBarrelMesh = nullptr;
 	m_pHorseMesh = nullptr;
 	m_pSphere = nullptr;
     m_pAudioManager = nullptr;
-
-	m_dt = 0.0;
+	m_pJobSystem = nullptr;
+	m_pRenderThread = nullptr;
+	m_pRenderQueue = nullptr;
+	m_pMaterials = nullptr;
+	m_pGeometry = nullptr;
+	m_pCompactGeometry = nullptr;
+	m_pLightClusters = nullptr;
+	m_pPointLights = nullptr;
+	m_pFrameLimiter = nullptr;
+	m_pProfiler = nullptr;
+	m_pBenchmark = nullptr;
+
+	m_dt = 1.0 / TICK_RATE;
+	m_frameTime = 0.0;
+	m_alpha = 0.0f;
+	m_simulationTime = 0.0;
 	m_framesPerSecond = 0;
+	m_showProfiler = false;
+	m_sphereMaterial = 0;
 	m_frameCount = 0;
 	m_elapsedTime = 0.0f;
 }
@@ -66,6 +104,12 @@ Game::Game() : m_window {"OpenGL Template", {1280, 720}}
 // Destructor
 Game::~Game() 
 { 
+	// Make sure the GL context is back on this thread before releasing GL resources
+	delete m_pRenderThread;
+
+	// The profiler owns GPU query objects, so it goes while the context is current
+	delete m_pProfiler;
+
 	//game objects
 	delete m_pCamera;
 	delete m_pSkybox;
@@ -74,15 +118,32 @@ Game::~Game()
 	delete m_pBarrelMesh;
 	delete m_pHorseMesh;
 	delete m_pSphere;
+	delete m_pFrameLimiter;
+	delete m_pBenchmark;
+	delete m_pRenderQueue;
+	delete m_pMaterials;
+	delete m_pLightClusters;
+	delete m_pPointLights;
+	// After the objects, which give their ranges back when they are deleted
+	delete m_pGeometry;
+	delete m_pCompactGeometry;
 
     m_pAudioManager->Destroy();
 	delete m_pAudioManager;
 
+	delete m_pMainShaders;
+	delete m_pPlaceholderShaders;
 	if (m_pShaderPrograms != nullptr) {
 		for (auto & m_pShaderProgram : *m_pShaderPrograms)
 			delete m_pShaderProgram;
 	}
 	delete m_pShaderPrograms;
+	delete m_pShaderCache;
+	delete m_pShaderWatcher;
+	delete m_pShaderCompiler;
+
+	// Stop the worker threads last, after every object that might have scheduled jobs is gone
+	delete m_pJobSystem;
 }
 
 // Initialisation:  This method only runs once at startup
@@ -92,6 +153,27 @@ void Game::Initialise()
     glClearColor(0.5f, 0.5f, 0.5f, 1.0f);
     glClearDepth(1.0f);
 
+    // Start recording before anything else so asset loading shows up in the trace
+    if (!options.trace.empty()) {
+        Trace::SetThreadName("Main");
+        Trace::Enable(true);
+        if (!Trace::IsEnabled())
+            std::cerr << "Tracing was disabled at build time, no trace will be written" << std::endl;
+    }
+
+    // Input can come from a previous recording, which makes the camera path identical from run to run
+    if (!options.replay.empty()) {
+        Input::StartReplay(options.replay);
+    } else if (!options.record.empty()) {
+        Input::StartRecording(options.record);
+    }
+
+    // Start the worker threads first so asset loading below can spread its CPU work across them
+    m_pJobSystem = new JobSystem;
+
+    // Create the profiler before anything that might open a scope
+    m_pProfiler = new CProfiler;
+
     /// Create objects
     m_pCamera = new CCamera;
     m_pSkybox = new CSkybox;
@@ -102,69 +184,117 @@ void Game::Initialise()
     m_pHorseMesh = new COpenAssetImportMesh;
     m_pSphere = new CSphere;
     m_pAudioManager = new CAudioManager;
+    m_pRenderThread = new CRenderThread;
+    m_pRenderQueue = new CRenderQueue;
+    m_pMaterials = new CMaterialTable;
+    m_pGeometry = new CGeometryArena;
+    m_pCompactGeometry = new CGeometryArena;
+    m_pLightClusters = new CLightClusters;
+    m_pPointLights = new std::vector<PointLight>(options.lights);
+    m_pFrameLimiter = new CFrameLimiter;
+
+    // Pace frames to FPS, unlimited rendering can be switched on at runtime.  Headless runs go as fast as possible.
+    m_pFrameLimiter->SetTargetFrameRate(m_window.Headless() ? 0 : FPS);
+
+    // A benchmark measures how fast frames can be made, so nothing may hold them back
+    if (options.benchmark) {
+        m_pBenchmark = new CBenchmark(options.frames > 0 ? options.frames : BENCHMARK_FRAMES, BENCHMARK_WARMUP_FRAMES);
+        m_pFrameLimiter->SetTargetFrameRate(0);
+        m_window.SetVSync(false);
+        m_pRenderThread->EnableFrameStats();
+    }
 
     // Set the orthographic and perspective projection matrices based on the image size
     m_pCamera->SetOrthographicProjectionMatrix(m_window.GetWidth(), m_window.GetHeight());
     m_pCamera->SetPerspectiveProjectionMatrix(45.0f, m_window.GetAspect(), 0.5f, 5000.0f);
 
-    // Load shaders
-    std::vector<CShader> shShaders;
-    std::vector<std::string> sShaderFileNames;
-    sShaderFileNames.emplace_back("mainShader.vert");
-    sShaderFileNames.emplace_back("mainShader.frag");
-    sShaderFileNames.emplace_back("textShader.vert");
-    sShaderFileNames.emplace_back("textShader.frag");
-
-    for (auto& sShaderFileName: sShaderFileNames) {
-        std::string sExt = sShaderFileName.substr((int) sShaderFileName.size() - 4, 4);
-        int iShaderType;
-        if (sExt == "vert") iShaderType = GL_VERTEX_SHADER;
-        else if (sExt == "frag") iShaderType = GL_FRAGMENT_SHADER;
-        else if (sExt == "geom") iShaderType = GL_GEOMETRY_SHADER;
-        else if (sExt == "tcnl") iShaderType = GL_TESS_CONTROL_SHADER;
-        else iShaderType = GL_TESS_EVALUATION_SHADER;
-        CShader shader;
-        shader.LoadShader("resources/shaders/" + sShaderFileName, iShaderType);
-        shShaders.push_back(shader);
+    // Programs linked by an earlier run are loaded from the cache instead of being compiled again
+    if (!options.shaderCache.empty()) {
+        m_pShaderCache = new CShaderCache(options.shaderCache);
     }
 
-    // Create the main shader program
-    auto* pMainProgram = new CShaderProgram;
-    pMainProgram->CreateProgram();
-    pMainProgram->AddShaderToProgram(&shShaders[0]);
-    pMainProgram->AddShaderToProgram(&shShaders[1]);
-    pMainProgram->LinkProgram();
-    m_pShaderPrograms->push_back(pMainProgram);
+    // Programs are compiled in the background while the rest of the game loads, and the first frames draw with a
+    // small placeholder program until they are ready.  The placeholders are built right away, as the main shader's
+    // variants ask for them, with the vertex layout of the variant they stand in for.
+    m_pShaderCompiler = new CShaderCompiler;
+    m_pPlaceholderShaders = new CShaderPermutations({"resources/shaders/placeholder.vert", "resources/shaders/placeholder.frag"},
+                                                    {"COMPACT"}, m_pShaderCache, nullptr);
+
+    // Create the variants of the main shader program, one for each kind of object drawn with it.  The untextured one
+    // is for objects that only use their material colour.
+    m_pMainShaders = new CShaderPermutations({"resources/shaders/mainShader.vert", "resources/shaders/mainShader.frag"},
+                                             {"SKYBOX", "TEXTURED", "COMPACT"}, m_pShaderCache, m_pShaderCompiler, m_pPlaceholderShaders);
+    m_pMainShaders->Prepare(SHADER_SKYBOX);
+    m_pMainShaders->Prepare(SHADER_TEXTURED);
+    m_pMainShaders->Prepare(0);
+    if (options.compactMeshes) {
+        m_pMainShaders->Prepare(SHADER_TEXTURED | SHADER_COMPACT);
+    }
 
-    // Create a shader program for fonts
+    // Create a shader program for fonts.  Text is simply left out until it is ready.
     auto* pFontProgram = new CShaderProgram;
-    pFontProgram->CreateProgram();
-    pFontProgram->AddShaderToProgram(&shShaders[2]);
-    pFontProgram->AddShaderToProgram(&shShaders[3]);
-    pFontProgram->LinkProgram();
+    pFontProgram->Build({"resources/shaders/textShader.vert", "resources/shaders/textShader.frag"}, {}, m_pShaderCache, m_pShaderCompiler);
     m_pShaderPrograms->push_back(pFontProgram);
 
+    m_pRenderThread->SetShaderCompiler(m_pShaderCompiler);
+
+    // Edited shaders are rebuilt while the game runs
+    m_pShaderWatcher = new CShaderWatcher(*m_pShaderCompiler);
+    for (CShaderProgram* pProgram : *m_pShaderPrograms) {
+        m_pShaderWatcher->Watch(pProgram);
+    }
+    for (const auto& [features, pProgram] : m_pMainShaders->GetPrograms()) {
+        m_pShaderWatcher->Watch(pProgram);
+    }
+    for (const auto& [features, pProgram] : m_pPlaceholderShaders->GetPrograms()) {
+        m_pShaderWatcher->Watch(pProgram);
+    }
+
     // You can follow this pattern to load additional shaders
 
+    // All static geometry shares one set of buffers, sized for the scene so it rarely has to grow
+    m_pGeometry->Create<Vertex>(GEOMETRY_ARENA_VERTICES, GEOMETRY_ARENA_INDICES);
+    // Imported meshes are compressed unless asked not to, their vertices go in an arena of their own
+    CGeometryArena* pMeshGeometry = m_pGeometry;
+    if (options.compactMeshes) {
+        m_pCompactGeometry->Create<CompactVertex>(COMPACT_GEOMETRY_ARENA_VERTICES, COMPACT_GEOMETRY_ARENA_INDICES);
+        pMeshGeometry = m_pCompactGeometry;
+    }
+
     // Create the skybox
     // Skybox downloaded from http://www.akimbo.in/forum/viewtopic.php?f=10&t=9
-    m_pSkybox->Create(2500.0f);
+    m_pSkybox->Create(*m_pGeometry, 2500.0f);
 
     // Create the planar terrain
-    m_pPlanarTerrain->Create("resources/textures/", "grassfloor01.jpg", 2000.0f, 2000.0f,
+    m_pPlanarTerrain->Create(*m_pGeometry, "resources/textures/", "grassfloor01.jpg", 2000.0f, 2000.0f,
                              50.0f); // Texture downloaded from http://www.psionicgames.com/?page_id=26 on 24 Jan 2013
 
     m_pFtFont->LoadFont("resources/fonts/arial.ttf", 32);
     m_pFtFont->SetShaderProgram(pFontProgram);
+    m_pRenderThread->AddStreamingBuffer(m_pFtFont->GetVertexBuffer());
 
     // Load some meshes in OBJ format
-    m_pBarrelMesh->Load("resources/models/Barrel/barrel02.obj");  // Downloaded from http://www.psionicgames.com/?page_id=24 on 24 Jan 2013
-    m_pHorseMesh->Load("resources/models/Horse/horse2.obj");  // Downloaded from http://opengameart.org/content/horse-lowpoly on 24 Jan 2013
+    m_pBarrelMesh->Load("resources/models/Barrel/barrel02.obj", *pMeshGeometry, m_pMaterials);  // Downloaded from http://www.psionicgames.com/?page_id=24 on 24 Jan 2013
+    m_pHorseMesh->Load("resources/models/Horse/horse2.obj", *pMeshGeometry, m_pMaterials);  // Downloaded from http://opengameart.org/content/horse-lowpoly on 24 Jan 2013
 
     // Create a sphere
-    m_pSphere->Create("resources/textures/", "dirtpile01.jpg", 25,
+    m_pSphere->Create(*m_pGeometry, "resources/textures/", "dirtpile01.jpg", 25,
                       25);  // Texture downloaded from http://www.psionicgames.com/?page_id=26 on 24 Jan 2013
-    glEnable(GL_CULL_FACE);
+    CGLStateCache::Get().SetEnabled(GL_CULL_FACE, true);
+
+    // Diffuse and specular material for the sphere, the skybox and terrain use the default full ambient one
+    Material sphereMaterial;
+    sphereMaterial.ambient = glm::vec3{0.5f};
+    sphereMaterial.diffuse = glm::vec3{0.5f};
+    sphereMaterial.specular = glm::vec3{1.0f};
+    sphereMaterial.shininess = 15.0f;
+    m_sphereMaterial = m_pMaterials->Add(sphereMaterial);
+
+    // Every material has been added, upload the table before the render thread takes the context
+    m_pMaterials->Upload();
+
+    // Buffers for the point lights' cluster lists, refilled every frame
+    m_pLightClusters->Create();
 
     // Initialise audio and play background music
     m_pAudioManager->Initialise();
@@ -174,124 +304,170 @@ void Game::Initialise()
 }
 
 // Render method runs repeatedly in a loop
+// Nothing here talks to GL directly: the frame is recorded into a command buffer that the render thread replays
 void Game::Render()
 {
+	CRenderCommandBuffer& commands = m_pRenderThread->GetCommandBuffer();
+	PROFILE_GPU_SCOPE(commands, "Frame");
+
 	// Clear the buffers and enable depth testing (z-buffering)
-	glClear (GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	glEnable(GL_DEPTH_TEST);
+	commands.SetViewport(0, 0, m_window.GetWidth(), m_window.GetHeight());
+	commands.SetPolygonMode(m_window.Wireframe());
+	commands.Clear(CLEAR_COLOUR | CLEAR_DEPTH);
+	commands.Enable(RenderState::DepthTest);
 
 	// Set up a matrix stack
 	glutil::MatrixStack modelViewMatrixStack;
 	modelViewMatrixStack.SetIdentity();
 
-	// Use the main shader program 
-	CShaderProgram *pMainProgram = (*m_pShaderPrograms)[0];
-	pMainProgram->UseProgram();
-	pMainProgram->SetUniform("bUseTexture", true);
-	pMainProgram->SetUniform("sampler0", 0);
+	// Each kind of object is drawn with the variant of the main shader program made for it
+	CShaderProgram *pSkyboxProgram = m_pMainShaders->Get(SHADER_SKYBOX);
+	CShaderProgram *pTexturedProgram = m_pMainShaders->Get(SHADER_TEXTURED);
+	CShaderProgram *pMeshProgram = m_pMainShaders->Get(SHADER_TEXTURED | (options.compactMeshes ? static_cast<uint32_t>(SHADER_COMPACT) : 0u));
 	// Note: cubemap and non-cubemap textures should not be mixed in the same texture unit.  Setting unit 10 to be a cubemap texture.
 	int cubeMapTextureUnit = 10; 
-	pMainProgram->SetUniform("CubeMapTex", cubeMapTextureUnit);
 	
 
-	// Set the projection matrix
-	pMainProgram->SetUniform("matrices.projMatrix", m_pCamera->GetPerspectiveProjectionMatrix());
+	// The camera is simulated at a fixed rate, so blend its last two states to get the pose for this frame
+	glm::vec3 vEye = m_pCamera->GetInterpolatedPosition(m_alpha);
+	glm::vec3 vView = m_pCamera->GetInterpolatedView(m_alpha);
 
 	// Call LookAt to create the view matrix and put this on the modelViewMatrix stack. 
-	// Store the view matrix and the normal matrix associated with the view matrix for later (they're useful for lighting -- since lighting is done in eye coordinates)
-	modelViewMatrixStack.LookAt(m_pCamera->GetPosition(), m_pCamera->GetView(), m_pCamera->GetUpVector());
+	// Store the view matrix for later (it's useful for lighting -- since lighting is done in eye coordinates)
+	modelViewMatrixStack.LookAt(vEye, vView, m_pCamera->GetUpVector());
 	glm::mat4 viewMatrix = modelViewMatrixStack.Top();
-	glm::mat3 viewNormalMatrix = m_pCamera->ComputeNormalMatrix(viewMatrix);
 
-	
-	// Set light and materials in main shader program
+	// Set the projection matrices and the light for every program drawn this frame
+	FrameUniforms frame{};
+	frame.projMatrix = *m_pCamera->GetPerspectiveProjectionMatrix();
+	frame.orthoMatrix = *m_pCamera->GetOrthographicProjectionMatrix();
+	frame.viewMatrix = viewMatrix;
 	glm::vec4 lightPosition1 = glm::vec4{-100, 100, -100, 1}; // Position of light source *in world coordinates*
-	pMainProgram->SetUniform("light1.position", viewMatrix*lightPosition1); // Position of light source *in eye coordinates*
-	pMainProgram->SetUniform("light1.La", glm::vec3{1.0f});		// Ambient colour of light
-	pMainProgram->SetUniform("light1.Ld", glm::vec3{1.0f});		// Diffuse colour of light
-	pMainProgram->SetUniform("light1.Ls", glm::vec3{1.0f});		// Specular colour of light
-	pMainProgram->SetUniform("material1.Ma", glm::vec3{1.0f});	// Ambient material reflectance
-	pMainProgram->SetUniform("material1.Md", glm::vec3{0.0f});	// Diffuse material reflectance
-	pMainProgram->SetUniform("material1.Ms", glm::vec3{0.0f});	// Specular material reflectance
-	pMainProgram->SetUniform("material1.shininess", 15.0f);		// Shininess material property
-		
-
-	// Render the skybox and terrain with full ambient reflectance 
+	frame.light1.position = viewMatrix*lightPosition1;	// Position of light source *in eye coordinates*
+	frame.light1.La = glm::vec3{1.0f};		// Ambient colour of light
+	frame.light1.Ld = glm::vec3{1.0f};		// Diffuse colour of light
+	frame.light1.Ls = glm::vec3{1.0f};		// Specular colour of light
+
+	// Sort the point lights into the clusters of this view
+	{
+		PROFILE_SCOPE("Light clusters");
+		AnimatePointLights(m_simulationTime + m_alpha * m_dt);
+		m_pLightClusters->Assign(*m_pPointLights, viewMatrix, frame.projMatrix);
+		m_pLightClusters->SetUniforms(frame, m_window.GetWidth(), m_window.GetHeight());
+	}
+	commands.SetUniformBlock(frame);
+
+	// Texture units are program state that doesn't change between draws, so they are set once up front
+	pSkyboxProgram->UseProgram(commands);
+	commands.SetUniform("CubeMapTex", cubeMapTextureUnit);
+	for (CShaderProgram* pProgram : {pTexturedProgram, pMeshProgram}) {
+		pProgram->UseProgram(commands);
+		commands.SetUniform("sampler0", 0);
+		commands.SetUniform("clusterGrid", LIGHT_CLUSTER_TEXTURE_UNIT);
+		commands.SetUniform("clusterLightIndices", LIGHT_CLUSTER_TEXTURE_UNIT + 1);
+		commands.SetUniform("clusterLights", LIGHT_CLUSTER_TEXTURE_UNIT + 2);
+	}
+	m_pLightClusters->Record(commands, LIGHT_CLUSTER_TEXTURE_UNIT);
+
+	// Objects are submitted to the render queue, which sorts them to save state changes before they are recorded
+	CRenderQueue& queue = *m_pRenderQueue;
+	queue.Reset();
+
+	// Every draw picks its material from the table by index
+	commands.BindUniformBuffer(UniformBlock::Materials, m_pMaterials->GetBuffer(), CMaterialTable::GetBufferSize());
+
+	// Per-draw matrices.  The packet's depth is the distance of the object's origin from the eye.  Objects that
+	// don't bring their own materials, like the meshes do, are drawn with the one given here.
+	auto makePacket = [&](RenderPass pass, const CShaderProgram* pProgram, const glm::mat4& modelView,
+						  uint32_t material = CMaterialTable::DEFAULT_MATERIAL) {
+		DrawUniforms draw{};
+		draw.modelViewMatrix = modelView;
+		draw.normalMatrix = glm::mat3x4{m_pCamera->ComputeNormalMatrix(modelView)};
+		DrawPacket packet;
+		packet.pass = pass;
+		packet.depth = glm::length(glm::vec3{modelView[3]});
+		packet.program = pProgram->GetDrawProgram();
+		packet.drawUniforms = queue.AddDrawUniforms(draw);
+		packet.material = material;
+		return packet;
+	};
+
+
+	// Submit the skybox and terrain with full ambient reflectance 
 	modelViewMatrixStack.Push();
-		pMainProgram->SetUniform("renderSkybox", true);
 		// Translate the modelview matrix to the camera eye point so skybox stays centred around camera
-		glm::vec3 vEye = m_pCamera->GetPosition();
 		modelViewMatrixStack.Translate(vEye);
-		pMainProgram->SetUniform("matrices.modelViewMatrix", modelViewMatrixStack.Top());
-		pMainProgram->SetUniform("matrices.normalMatrix", m_pCamera->ComputeNormalMatrix(modelViewMatrixStack.Top()));
-		m_pSkybox->Render(cubeMapTextureUnit);
-		pMainProgram->SetUniform("renderSkybox", false);
+		m_pSkybox->Submit(queue, makePacket(RenderPass::Background, pSkyboxProgram, modelViewMatrixStack.Top()), cubeMapTextureUnit);
 	modelViewMatrixStack.Pop();
 
-	// Render the planar terrain
+	// Submit the planar terrain
 	modelViewMatrixStack.Push();
-		pMainProgram->SetUniform("matrices.modelViewMatrix", modelViewMatrixStack.Top());
-		pMainProgram->SetUniform("matrices.normalMatrix", m_pCamera->ComputeNormalMatrix(modelViewMatrixStack.Top()));
-		m_pPlanarTerrain->Render();
+		m_pPlanarTerrain->Submit(queue, makePacket(RenderPass::Opaque, pTexturedProgram, modelViewMatrixStack.Top()));
 	modelViewMatrixStack.Pop();
 
 
-	// Turn on diffuse + specular materials
-	pMainProgram->SetUniform("material1.Ma", glm::vec3{0.5f});	// Ambient material reflectance
-	pMainProgram->SetUniform("material1.Md", glm::vec3{0.5f});	// Diffuse material reflectance
-	pMainProgram->SetUniform("material1.Ms", glm::vec3{1.0f});	// Specular material reflectance
-
+	// Submit the meshes
 
-	// Render the horse 
+	// Submit the horse 
 	modelViewMatrixStack.Push();
 		modelViewMatrixStack.Translate(glm::vec3{0.0f, 0.0f, 0.0f});
 		modelViewMatrixStack.Rotate(glm::vec3{0.0f, 1.0f, 0.0f}, 180.0f);
 		modelViewMatrixStack.Scale(2.5f);
-		pMainProgram->SetUniform("matrices.modelViewMatrix", modelViewMatrixStack.Top());
-		pMainProgram->SetUniform("matrices.normalMatrix", m_pCamera->ComputeNormalMatrix(modelViewMatrixStack.Top()));
-		m_pHorseMesh->Render();
+		modelViewMatrixStack *= m_pHorseMesh->GetPositionTransform();
+		m_pHorseMesh->Submit(queue, makePacket(RenderPass::Opaque, pMeshProgram, modelViewMatrixStack.Top()));
 	modelViewMatrixStack.Pop();
 
-	// Render the barrel 
+	// Submit the barrel 
 	modelViewMatrixStack.Push();
 		modelViewMatrixStack.Translate(glm::vec3{100.0f, 0.0f, 0.0f});
 		modelViewMatrixStack.Scale(5.0f);
-		pMainProgram->SetUniform("matrices.modelViewMatrix", modelViewMatrixStack.Top());
-		pMainProgram->SetUniform("matrices.normalMatrix", m_pCamera->ComputeNormalMatrix(modelViewMatrixStack.Top()));
-		m_pBarrelMesh->Render();
+		modelViewMatrixStack *= m_pBarrelMesh->GetPositionTransform();
+		m_pBarrelMesh->Submit(queue, makePacket(RenderPass::Opaque, pMeshProgram, modelViewMatrixStack.Top()));
 	modelViewMatrixStack.Pop();
 
-	// Render the sphere
+	// Submit the sphere
 	modelViewMatrixStack.Push();
 		modelViewMatrixStack.Translate(glm::vec3{0.0f, 2.0f, 150.0f});
 		modelViewMatrixStack.Scale(2.0f);
-		pMainProgram->SetUniform("matrices.modelViewMatrix", modelViewMatrixStack.Top());
-		pMainProgram->SetUniform("matrices.normalMatrix", m_pCamera->ComputeNormalMatrix(modelViewMatrixStack.Top()));
-		// To turn off texture mapping and use the sphere colour only (currently white material), uncomment the next line
-		//pMainProgram->SetUniform("bUseTexture", false);
-		m_pSphere->Render();
+		// To turn off texture mapping and use the sphere colour only (currently white material), pass m_pMainShaders->Get(0) instead
+		m_pSphere->Submit(queue, makePacket(RenderPass::Opaque, pTexturedProgram, modelViewMatrixStack.Top(), m_sphereMaterial));
 	modelViewMatrixStack.Pop();
 
-    CShaderProgram *fontProgram = (*m_pShaderPrograms)[1];
+	{
+	PROFILE_GPU_SCOPE(commands, "Scene");
+	queue.Execute(commands);
+	}
 
-    // Use the font shader program and render the text
-    fontProgram->UseProgram();
-    glDisable(GL_DEPTH_TEST);
-    fontProgram->SetUniform("matrices.modelViewMatrix", glm::mat4{ 1 });
-    fontProgram->SetUniform("matrices.projMatrix", m_pCamera->GetOrthographicProjectionMatrix());
-    fontProgram->SetUniform("vColour", glm::vec4{1.0f, 1.0f, 1.0f, 1.0f});
+    PROFILE_GPU_SCOPE(commands, "Text");
+    CShaderProgram *fontProgram = (*m_pShaderPrograms)[0];
 
-    m_pFtFont->Render(20, 20, 20, "Press TAB to lock mouse and use camera");
-    m_pFtFont->Render(20, 50, 20, "Press ESC to exit");
-    m_pFtFont->Render(20, 80, 20, "Press F1 to enable wiremode renderer");
+    // Use the font shader program and render the text
+    fontProgram->UseProgram(commands);
+    commands.Disable(RenderState::DepthTest);
+    commands.SetUniform("vColour", glm::vec4{1.0f, 1.0f, 1.0f, 1.0f});
+
+    m_pFtFont->Render(commands, 20, 20, 20, "Press TAB to lock mouse and use camera");
+    m_pFtFont->Render(commands, 20, 50, 20, "Press ESC to exit");
+    m_pFtFont->Render(commands, 20, 80, 20, "Press F1 to enable wiremode renderer");
+    m_pFtFont->Render(commands, 20, 110, 20, "Press F2 to toggle the %d FPS frame limiter", FPS);
+    m_pFtFont->Render(commands, 20, 140, 20, "Press F3 to show the profiler");
+    if (Trace::IsEnabled()) {
+        m_pFtFont->Render(commands, 20, 170, 20, "Press F4 to write the trace");
+    }
 
 	// Draw the 2D graphics after the 3D graphics
 	DisplayFrameRate();
+
+	if (m_showProfiler) {
+		DisplayProfiler(commands);
+	}
 }
 
 // Update method runs repeatedly with the Render method
 void Game::Update()
 {
+    PROFILE_SCOPE("Update");
+
     if (Input::GetKeyDown(GLFW_KEY_ESCAPE)) {
         m_window.ShouldClose(true);
     }
@@ -304,18 +480,59 @@ void Game::Update()
         m_window.ToggleWireframe();
     }
 
+    if (Input::GetKeyDown(GLFW_KEY_F2)) {
+        m_pFrameLimiter->SetTargetFrameRate(m_pFrameLimiter->GetTargetFrameRate() == 0 ? FPS : 0);
+    }
+
+    if (Input::GetKeyDown(GLFW_KEY_F3)) {
+        m_showProfiler = !m_showProfiler;
+    }
+
+    if (Input::GetKeyDown(GLFW_KEY_F4) && Trace::IsEnabled()) {
+        Trace::Write(options.trace);
+    }
+
     m_pAudioManager->Play("resources/audio/fsm-team-escp-paradox.wav", m_pCamera->GetPosition());
 
-	// Update the camera using the amount of time that has elapsed to avoid framerate dependent motion
-	m_pCamera->Update(m_dt);
+	// Update the camera with the fixed simulation timestep so motion does not depend on the frame rate.  In a
+	// benchmark the camera follows the benchmark's path instead.
+	if (m_pBenchmark == nullptr) {
+		m_pCamera->Update(m_dt);
+	}
+	m_simulationTime += m_dt;
 
 	m_pAudioManager->Update();
 }
 
+// Moves the point lights around the scene on circles of different radius, height and speed.  Every light's path
+// follows from its index alone, so runs are repeatable.
+void Game::AnimatePointLights(double time)
+{
+	std::vector<PointLight>& lights = *m_pPointLights;
+	for (size_t i = 0; i < lights.size(); i++) {
+		// Hash of the light's index and a salt, mapped to [0, 1)
+		auto random = [i](uint32_t salt) {
+			uint32_t h = static_cast<uint32_t>(i + 1) * 2654435761u ^ salt * 2246822519u;
+			h ^= h >> 15;
+			h *= 2246822519u;
+			h ^= h >> 13;
+			return static_cast<float>(h & 0xFFFFFF) / 16777216.0f;
+		};
+
+		float orbit = 40.0f + 360.0f * random(1);
+		float height = 3.0f + 30.0f * random(2);
+		float speed = (0.1f + 0.4f * random(3)) * (random(4) < 0.5f ? -1.0f : 1.0f);
+		float angle = 6.2831853f * random(5) + speed * static_cast<float>(time);
+		lights[i].position = glm::vec3{orbit * std::cos(angle), height, orbit * std::sin(angle)};
+		lights[i].radius = 30.0f + 50.0f * random(6);
+		lights[i].colour = glm::vec3{0.2f} + 0.8f * glm::vec3{random(7), random(8), random(9)};
+	}
+}
+
 void Game::DisplayFrameRate()
 {
 	// Increase the elapsed time and frame counter
-	m_elapsedTime += m_dt;
+	m_elapsedTime += m_frameTime;
 	m_frameCount++;
 
 	// Now we want to subtract the current time by the last time that was stored
@@ -330,30 +547,126 @@ void Game::DisplayFrameRate()
     }
 
 	if (m_framesPerSecond > 0) {
-		m_pFtFont->Render(20, m_window.GetHeight() - 20, 20, "FPS: %d", m_framesPerSecond);
+		m_pFtFont->Render(m_pRenderThread->GetCommandBuffer(), 20, m_window.GetHeight() - 20, 20, "FPS: %d", m_framesPerSecond);
+	}
+}
+
+// Draws the profiler's statistics below the frame rate, one line per scope with nested scopes indented
+void Game::DisplayProfiler(CRenderCommandBuffer& commands)
+{
+	const int size = 16;
+	const int lineHeight = 20;
+	int y = m_window.GetHeight() - 50;
+
+	m_pFtFont->Render(commands, 20, y, size, "Scope");
+	m_pFtFont->Render(commands, 260, y, size, "CPU ms min / avg / p99");
+	m_pFtFont->Render(commands, 500, y, size, "GPU ms min / avg / p99");
+
+	for (const CProfiler::ScopeReport& scope : m_pProfiler->GetReport()) {
+		y -= lineHeight;
+		if (scope.thread == 0) {
+			m_pFtFont->Render(commands, 20 + 16 * scope.depth, y, size, "%s", scope.name.c_str());
+		} else {
+			m_pFtFont->Render(commands, 20 + 16 * scope.depth, y, size, "%s (thread %u)", scope.name.c_str(), scope.thread);
+		}
+		if (scope.cpu.samples > 0) {
+			m_pFtFont->Render(commands, 260, y, size, "%.2f / %.2f / %.2f", scope.cpu.min, scope.cpu.avg, scope.cpu.p99);
+		}
+		if (scope.gpu.samples > 0) {
+			m_pFtFont->Render(commands, 500, y, size, "%.2f / %.2f / %.2f", scope.gpu.min, scope.gpu.avg, scope.gpu.p99);
+		}
 	}
 }
 
 // The game loop runs repeatedly until game over
+// The simulation advances in fixed steps of m_dt driven by an integer tick clock, while rendering runs once per frame
+// and interpolates between the last two simulation states using the leftover time in the accumulator
 void Game::Run()
 {
-    float currentTime = static_cast<float>(glfwGetTime());
-    float previousTime = currentTime;
+    const uint64_t frequency = glfwGetTimerFrequency();
+    const uint64_t stepTicks = frequency / TICK_RATE;
+    const uint64_t maxFrameTicks = frequency * MAX_FRAME_TIME_MS / 1000;
+
+    uint64_t previousTicks = glfwGetTimerValue();
+    uint64_t accumulator = 0;
+
+    int frameNumber = 0;
+    const int frameLimit = m_pBenchmark ? m_pBenchmark->GetTotalFrames() : options.frames;
+
+    // From here on the GL context belongs to the render thread
+    m_pRenderThread->Start(m_window);
 
     while (!m_window.ShouldClose()) {
-        currentTime = static_cast<float>(glfwGetTime());
-        m_dt = currentTime - previousTime;
-        previousTime = currentTime;
+        // Nothing is visible while minimised, so sleep until an event arrives and don't simulate the time spent away
+        if (m_window.Iconified()) {
+            m_window.WaitEvents();
+            previousTicks = glfwGetTimerValue();
+            m_pFrameLimiter->Reset();
+            continue;
+        }
+
+        uint64_t currentTicks = glfwGetTimerValue();
+        uint64_t frameTicks = std::min(currentTicks - previousTicks, maxFrameTicks);
+        previousTicks = currentTicks;
+
+        m_frameTime = static_cast<double>(frameTicks) / static_cast<double>(frequency);
+        accumulator += frameTicks;
+
+        while (accumulator >= stepTicks) {
+            Update();
+
+            // Reset input data so key presses and mouse motion are consumed by a single simulation step
+            Input::Update();
+
+            accumulator -= stepTicks;
+        }
+
+        m_alpha = static_cast<float>(static_cast<double>(accumulator) / static_cast<double>(stepTicks));
+
+        if (m_pBenchmark) {
+            m_pBenchmark->UpdateCamera(*m_pCamera, frameNumber);
+        }
+
+        // Edited shaders are read and preprocessed here, the render thread only hands them to the driver
+        m_pShaderWatcher->Poll();
 
-        Update();
         Render();
 
-        // Reset input data
-        Input::Update();
+        if (m_pBenchmark) {
+            double cpuTime = static_cast<double>(glfwGetTimerValue() - currentTicks) / static_cast<double>(frequency);
+            m_pBenchmark->AddCpuTime(frameNumber, cpuTime * 1000.0);
+        }
+
+        // Hand the recorded frame to the render thread, which replays it and swaps buffers while we start on the next one
+        m_pRenderThread->Submit();
+
+        if (frameLimit > 0 && ++frameNumber >= frameLimit) {
+            m_window.ShouldClose(true);
+        }
+
+        if (m_window.Headless() || m_pBenchmark) {
+            // A hidden window never has focus, but there is nobody to save power for, and benchmarks must not be throttled
+            m_window.PollEvents();
+        } else if (m_window.Focused()) {
+            m_window.PollEvents();
+            m_pFrameLimiter->Wait();
+        } else {
+            // Out of focus: block in the event queue and only redraw at a low rate, input still wakes us up immediately
+            m_window.WaitEvents(1.0 / IDLE_FPS);
+        }
+    }
+
+    m_pRenderThread->Stop();
+
+    Input::StopRecording();
 
-        // Swap buffers to show the rendered image
-        m_window.SwapBuffers();
-        m_window.PollEvents();
+    if (m_pBenchmark) {
+        m_pBenchmark->AddFrameStats(m_pRenderThread->TakeFrameStats());
+        m_pBenchmark->WriteResults(options.benchmarkOutput);
+    }
+
+    if (Trace::IsEnabled()) {
+        Trace::Write(options.trace);
     }
 }
 
@@ -363,7 +676,63 @@ Game& Game::GetInstance()
 	return instance;
 }
 
+// Parses the command line into Game::options, printing usage and returning false on unknown arguments
+bool Game::ParseCommandLine(int argc, char** argv)
+{
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--headless") {
+            options.headless = true;
+        } else if (arg == "--frames" && i + 1 < argc) {
+            options.frames = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--trace" && i + 1 < argc) {
+            options.trace = argv[++i];
+        } else if (arg == "--record" && i + 1 < argc) {
+            options.record = argv[++i];
+        } else if (arg == "--replay" && i + 1 < argc) {
+            options.replay = argv[++i];
+        } else if (arg == "--benchmark") {
+            options.benchmark = true;
+        } else if (arg == "--benchmark-output" && i + 1 < argc) {
+            options.benchmarkOutput = argv[++i];
+        } else if (arg == "--shader-cache" && i + 1 < argc) {
+            options.shaderCache = argv[++i];
+        } else if (arg == "--no-shader-cache") {
+            options.shaderCache.clear();
+        } else if (arg == "--no-compact-meshes") {
+            options.compactMeshes = false;
+        } else if (arg == "--lights" && i + 1 < argc) {
+            options.lights = std::clamp(std::atoi(argv[++i]), 0, static_cast<int>(CLightClusters::MAX_LIGHTS));
+        } else {
+            std::cerr << "Unknown argument: " << arg << '\n'
+                      << "Usage: " << argv[0] << " [--headless] [--frames N] [--trace FILE] [--record FILE | --replay FILE] [--benchmark [--benchmark-output PATH]]\n"
+                      << "       [--shader-cache DIR | --no-shader-cache] [--lights N] [--no-compact-meshes]\n"
+                      << "  --headless      render offscreen without a visible window and with vsync off\n"
+                      << "  --frames N      exit after N frames\n"
+                      << "  --trace FILE    record a Chrome trace, written to FILE at exit or when F4 is pressed\n"
+                      << "  --record FILE   record all keyboard and mouse input to FILE\n"
+                      << "  --replay FILE   replay input recorded with --record in place of the keyboard and mouse\n"
+                      << "  --benchmark     fly the camera along a fixed path, measuring N frames (default " << BENCHMARK_FRAMES << ") after a warm-up\n"
+                      << "  --benchmark-output PATH\n"
+                      << "                  write the benchmark results to PATH.csv and PATH.json (default benchmark)\n"
+                      << "  --shader-cache DIR\n"
+                      << "                  cache linked shader programs in DIR (default " << Options{}.shaderCache << ")\n"
+                      << "  --no-shader-cache\n"
+                      << "                  compile every shader from source\n"
+                      << "  --lights N      animate N point lights around the scene (up to " << CLightClusters::MAX_LIGHTS << ")\n"
+                      << "  --no-compact-meshes\n"
+                      << "                  import meshes with full precision vertices and no position quantisation" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
 int main(int args, char** argv) {
+    if (!Game::ParseCommandLine(args, argv)) {
+        return EXIT_FAILURE;
+    }
+
     Game& game = Game::GetInstance();
     try {
         game.Initialise();
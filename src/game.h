@@ -11,11 +11,26 @@ class CCamera;
 class CSkybox;
 class CShader;
 class CShaderProgram;
+class CShaderCache;
+class CShaderCompiler;
+class CShaderPermutations;
+class CShaderWatcher;
 class CPlane;
 class CFreeTypeFont;
 class CSphere;
 class COpenAssetImportMesh;
 class CAudioManager;
+class JobSystem;
+class CRenderThread;
+class CFrameLimiter;
+class CProfiler;
+class CBenchmark;
+class CRenderCommandBuffer;
+class CRenderQueue;
+class CMaterialTable;
+class CGeometryArena;
+class CLightClusters;
+struct PointLight;
 
 class Game {
 private:
@@ -28,26 +43,84 @@ private:
 	CSkybox *m_pSkybox;
 	CCamera *m_pCamera;
 	std::vector<CShaderProgram *> *m_pShaderPrograms;
+	CShaderCache *m_pShaderCache;
+	CShaderCompiler *m_pShaderCompiler;
+	CShaderPermutations *m_pMainShaders;
+	CShaderPermutations *m_pPlaceholderShaders;
+	CShaderWatcher *m_pShaderWatcher;
 	CPlane *m_pPlanarTerrain;
 	CFreeTypeFont *m_pFtFont;
 	COpenAssetImportMesh *m_pBarrelMesh;
 	COpenAssetImportMesh *m_pHorseMesh;
 	CSphere *m_pSphere;
 	CAudioManager *m_pAudioManager;
+	JobSystem *m_pJobSystem;
+	CRenderThread *m_pRenderThread;
+	CRenderQueue *m_pRenderQueue;
+	CMaterialTable *m_pMaterials;
+	CGeometryArena *m_pGeometry;
+	CGeometryArena *m_pCompactGeometry;
+	CLightClusters *m_pLightClusters;
+	std::vector<PointLight> *m_pPointLights;
+	CFrameLimiter *m_pFrameLimiter;
+	CProfiler *m_pProfiler;
+	CBenchmark *m_pBenchmark;
 
 	// Some other member variables
-	double m_dt;
+	double m_dt;				// Fixed simulation timestep in seconds
+	double m_frameTime;			// Wall-clock duration of the last rendered frame in seconds
+	float m_alpha;				// Interpolation factor between the previous and current simulation states
+	double m_simulationTime;	// Seconds simulated so far, advanced by m_dt per step
 	int m_framesPerSecond;
+	bool m_showProfiler;		// Draw the profiler overlay, toggled with F3
+	uint32_t m_sphereMaterial;	// Index in the material table
 
 public:
 	Game();
 	~Game();
 	static Game& GetInstance();
 
+	// Options that can be set from the command line, they must be parsed before the game instance is created
+	struct Options
+	{
+		bool headless = false;	// Render offscreen with no visible window and no vsync, e.g. on build machines
+		int frames = 0;			// Number of frames to run before exiting, 0 runs until the window is closed
+		std::string trace;		// Record a trace and write it to this file at exit, F4 also writes it at any time
+		std::string record;		// Record all input to this file
+		std::string replay;		// Replay input recorded with --record instead of reading the keyboard and mouse
+		bool benchmark = false;	// Fly the camera along a fixed path and write frame statistics, frames sets the measured frames
+		std::string benchmarkOutput = "benchmark";	// Results go to this path with .csv and .json extensions
+		std::string shaderCache = "shadercache";	// Directory linked program binaries are cached in, empty disables the cache
+		int lights = 0;			// Number of animated point lights, shaded with clustered lighting
+		bool compactMeshes = true;	// Import meshes as CompactVertex, half the size of full precision vertices
+	};
+	static bool ParseCommandLine(int argc, char** argv);
+
 private:
-	static const int FPS = 60;
+	static const int FPS = 60;				// Frame rate the limiter paces to while it is enabled
+	static const int IDLE_FPS = 10;			// Redraw rate while the window is out of focus
+	static const int TICK_RATE = 120;		// Simulation steps per second, independent of the display rate
+	static const int MAX_FRAME_TIME_MS = 250;	// Clamp on a single frame's time to avoid a spiral of death after a stall
+	static const int BENCHMARK_FRAMES = 2000;	// Measured frames in a benchmark run unless --frames is given
+	static const int BENCHMARK_WARMUP_FRAMES = 200;	// Frames rendered before measuring starts, while caches and drivers settle
+	static const int LIGHT_CLUSTER_TEXTURE_UNIT = 1;	// First of the three units the light cluster lists are bound to
+	static const uint32_t GEOMETRY_ARENA_VERTICES = 256 * 1024;	// Initial size of the shared static geometry buffers
+	static const uint32_t GEOMETRY_ARENA_INDICES = 1024 * 1024;
+	static const uint32_t COMPACT_GEOMETRY_ARENA_VERTICES = 64 * 1024;	// The same for the imported meshes, when compressed
+	static const uint32_t COMPACT_GEOMETRY_ARENA_INDICES = 256 * 1024;
+	// Features of the main shader program's variants, see CShaderPermutations
+	enum MainShaderFeature : uint32_t
+	{
+		SHADER_SKYBOX = 1 << 0,		// Cube map lookup without lighting
+		SHADER_TEXTURED = 1 << 1,	// Lit colour modulated by a 2D texture
+		SHADER_COMPACT = 1 << 2,	// Reads CompactVertex instead of Vertex
+	};
+
+	void AnimatePointLights(double time);
 	void DisplayFrameRate();
+	void DisplayProfiler(CRenderCommandBuffer& commands);
 	void Run();
+	static Options options;
 	Window m_window;
 	int m_frameCount;
 	double m_elapsedTime;
@@ -0,0 +1,250 @@
+#include "geometryarena.h"
+#include "glstatecache.h"
+
+CRangeAllocator::CRangeAllocator()
+{
+	m_capacity = 0;
+	m_freeCount = 0;
+}
+
+void CRangeAllocator::Reset(uint32_t capacity)
+{
+	m_free.clear();
+	m_capacity = capacity;
+	m_freeCount = capacity;
+	if (capacity > 0)
+		m_free[0] = capacity;
+}
+
+uint32_t CRangeAllocator::Allocate(uint32_t count, uint32_t alignment)
+{
+	if (count == 0)
+		return 0;
+
+	for (auto it = m_free.begin(); it != m_free.end(); ++it) {
+		const uint32_t offset = (it->first + alignment - 1) / alignment * alignment;
+		const uint32_t padding = offset - it->first;
+		if (it->second < padding + count)
+			continue;
+
+		// Take the aligned front of the free range and keep the rest, including the padding before it
+		const uint32_t start = it->first;
+		const uint32_t remaining = it->second - padding - count;
+		m_free.erase(it);
+		if (padding > 0)
+			m_free[start] = padding;
+		if (remaining > 0)
+			m_free[offset + count] = remaining;
+		m_freeCount -= count;
+		return offset;
+	}
+	return INVALID;
+}
+
+void CRangeAllocator::Free(uint32_t offset, uint32_t count)
+{
+	if (count == 0)
+		return;
+	assert(offset + count <= m_capacity && "Freeing a range outside the allocator");
+
+	auto next = m_free.lower_bound(offset);
+	assert((next == m_free.end() || offset + count <= next->first) && "Freeing a range that is already free");
+
+	// Merge with the free range that ends where this one starts
+	if (next != m_free.begin()) {
+		auto previous = std::prev(next);
+		assert(previous->first + previous->second <= offset && "Freeing a range that is already free");
+		if (previous->first + previous->second == offset) {
+			offset = previous->first;
+			count += previous->second;
+			m_freeCount -= previous->second;
+			m_free.erase(previous);
+		}
+	}
+
+	// And with the one that starts where it ends
+	if (next != m_free.end() && next->first == offset + count) {
+		count += next->second;
+		m_freeCount -= next->second;
+		m_free.erase(next);
+	}
+
+	m_free[offset] = count;
+	m_freeCount += count;
+}
+
+void CRangeAllocator::Grow(uint32_t capacity)
+{
+	if (capacity <= m_capacity)
+		return;
+
+	uint32_t oldCapacity = m_capacity;
+	m_capacity = capacity;
+	Free(oldCapacity, capacity - oldCapacity);
+}
+
+// 16-bit units of the index buffer taken by one index
+static uint32_t IndexUnits(IndexType type)
+{
+	return type == IndexType::UnsignedShort ? 1 : 2;
+}
+
+CGeometryArena::CGeometryArena()
+{
+	m_format = VertexFormat::Full;
+	m_vertexSize = sizeof(Vertex);
+	m_setVertexAttributes = &SetVertexAttributes<Vertex>;
+	m_vao = 0;
+	m_vertexBuffer = 0;
+	m_indexBuffer = 0;
+}
+
+CGeometryArena::~CGeometryArena()
+{
+	Release();
+}
+
+// Creates the buffers and the vertex array drawing from them
+void CGeometryArena::Create(VertexFormat format, size_t vertexSize, void (*setVertexAttributes)(GLintptr), uint32_t vertexCapacity,
+							uint32_t indexCapacity)
+{
+	Release();
+
+	m_format = format;
+	m_vertexSize = vertexSize;
+	m_setVertexAttributes = setVertexAttributes;
+
+	glGenVertexArrays(1, &m_vao);
+	glGenBuffers(1, &m_vertexBuffer);
+	glGenBuffers(1, &m_indexBuffer);
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, m_vertexBuffer);
+	glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(vertexCapacity * m_vertexSize), nullptr, GL_STATIC_DRAW);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, m_indexBuffer);
+	glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(indexCapacity) * sizeof(uint16_t), nullptr, GL_STATIC_DRAW);
+
+	m_vertices.Reset(vertexCapacity);
+	m_indices.Reset(indexCapacity);
+	BindBuffers();
+}
+
+void CGeometryArena::Release()
+{
+	if (m_vao == 0)
+		return;
+
+	CGLStateCache::Get().ForgetVertexArray(m_vao);
+	glDeleteVertexArrays(1, &m_vao);
+	glDeleteBuffers(1, &m_vertexBuffer);
+	glDeleteBuffers(1, &m_indexBuffer);
+	m_vao = 0;
+	m_vertexBuffer = 0;
+	m_indexBuffer = 0;
+	m_vertices.Reset(0);
+	m_indices.Reset(0);
+}
+
+// Points the vertex array at the current buffers.  The element buffer binding is vertex array state, so the vertex
+// array is bound first.
+void CGeometryArena::BindBuffers()
+{
+	CGLStateCache::Get().BindVertexArray(m_vao);
+	glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+	m_setVertexAttributes(0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
+}
+
+GeometryRange CGeometryArena::Add(const void* pVertices, uint32_t vertexCount, const std::vector<uint32_t>& indices)
+{
+	assert(m_vao != 0 && "Geometry added before the arena was created");
+
+	GeometryRange range;
+	range.vertexCount = vertexCount;
+	range.indexCount = static_cast<uint32_t>(indices.size());
+	if (range.vertexCount == 0)
+		return {};
+
+	// Every index is below the vertex count, so it fits in 16 bits if the count does
+	std::vector<uint16_t> shortIndices;
+	const void* pIndices = indices.data();
+	if (range.vertexCount <= MAX_SHORT_INDEX_VERTICES) {
+		range.indexType = IndexType::UnsignedShort;
+		shortIndices.assign(indices.begin(), indices.end());
+		pIndices = shortIndices.data();
+	}
+	const uint32_t indexUnits = IndexUnits(range.indexType);
+
+	range.firstVertex = m_vertices.Allocate(range.vertexCount);
+	if (range.firstVertex == CRangeAllocator::INVALID) {
+		GrowBuffer(m_vertexBuffer, "vertex", m_vertexSize, m_vertices, range.vertexCount);
+		range.firstVertex = m_vertices.Allocate(range.vertexCount);
+	}
+	// Indices must start at a multiple of their size, the padding in front of them goes back to the free list
+	uint32_t indexOffset = m_indices.Allocate(range.indexCount * indexUnits, indexUnits);
+	if (indexOffset == CRangeAllocator::INVALID) {
+		GrowBuffer(m_indexBuffer, "index", sizeof(uint16_t), m_indices, range.indexCount * indexUnits + indexUnits - 1);
+		indexOffset = m_indices.Allocate(range.indexCount * indexUnits, indexUnits);
+	}
+	range.firstIndex = indexOffset / indexUnits;
+
+	// Uploaded through the copy target, which doesn't touch the vertex array's bindings
+	glBindBuffer(GL_COPY_WRITE_BUFFER, m_vertexBuffer);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(range.firstVertex * m_vertexSize),
+					static_cast<GLsizeiptr>(range.vertexCount * m_vertexSize), pVertices);
+	if (range.indexCount > 0) {
+		glBindBuffer(GL_COPY_WRITE_BUFFER, m_indexBuffer);
+		glBufferSubData(GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(indexOffset) * sizeof(uint16_t),
+						static_cast<GLsizeiptr>(range.indexCount) * indexUnits * sizeof(uint16_t), pIndices);
+	}
+
+	return range;
+}
+
+void CGeometryArena::Remove(const GeometryRange& range)
+{
+	// The arena may already be gone when the objects using it are destroyed
+	if (m_vao == 0)
+		return;
+
+	const uint32_t indexUnits = IndexUnits(range.indexType);
+	m_vertices.Free(range.firstVertex, range.vertexCount);
+	m_indices.Free(range.firstIndex * indexUnits, range.indexCount * indexUnits);
+}
+
+void CGeometryArena::SetDrawRange(DrawPacket& packet, const GeometryRange& range) const
+{
+	packet.vertexArray = m_vao;
+	packet.indexed = range.indexCount > 0;
+	if (packet.indexed) {
+		packet.indexType = range.indexType;
+		packet.first = range.firstIndex * IndexUnits(range.indexType) * static_cast<uint32_t>(sizeof(uint16_t));
+		packet.count = range.indexCount;
+		packet.baseVertex = static_cast<int32_t>(range.firstVertex);
+	} else {
+		packet.first = range.firstVertex;
+		packet.count = range.vertexCount;
+		packet.baseVertex = 0;
+	}
+}
+
+// Replaces the buffer with one at least twice the size holding the same data, so every range stays valid
+void CGeometryArena::GrowBuffer(GLuint& buffer, const char* name, size_t elementSize, CRangeAllocator& allocator, uint32_t needed)
+{
+	const uint32_t oldCapacity = allocator.GetCapacity();
+	const uint32_t capacity = std::max(oldCapacity * 2, oldCapacity + needed);
+	// The arena is sized for the scene up front, so having to grow it is worth a warning
+	std::cerr << "Growing the geometry arena's " << name << " buffer to "
+			  << capacity << " elements" << std::endl;
+
+	GLuint newBuffer = 0;
+	glGenBuffers(1, &newBuffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, newBuffer);
+	glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(capacity * elementSize), nullptr, GL_STATIC_DRAW);
+	glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, static_cast<GLsizeiptr>(oldCapacity * elementSize));
+
+	glDeleteBuffers(1, &buffer);
+	buffer = newBuffer;
+	allocator.Grow(capacity);
+	BindBuffers();
+}
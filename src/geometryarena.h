@@ -0,0 +1,96 @@
+#pragma once
+
+#include "renderqueue.h"
+#include "vertexbuilder.h"
+
+// Where a piece of geometry lives in the arena.  Indices count from the range's first vertex, so they are drawn with
+// firstVertex as the base vertex.  firstIndex is counted in indices of the range's own type.
+struct GeometryRange
+{
+	uint32_t firstVertex = 0;
+	uint32_t vertexCount = 0;
+	uint32_t firstIndex = 0;
+	uint32_t indexCount = 0;
+	IndexType indexType = IndexType::UnsignedInt;
+};
+
+// First-fit free list over [0, capacity), in elements.  Freed ranges are merged with free neighbours so the space
+// doesn't fragment into pieces too small to use.
+class CRangeAllocator
+{
+public:
+	static const uint32_t INVALID = ~0u;
+
+	CRangeAllocator();
+
+	void Reset(uint32_t capacity);
+	// Returns the offset, a multiple of alignment, of count free elements, or INVALID if no free range is large enough
+	uint32_t Allocate(uint32_t count, uint32_t alignment = 1);
+	void Free(uint32_t offset, uint32_t count);
+	// Adds the elements from the old capacity to the new one to the free list
+	void Grow(uint32_t capacity);
+
+	uint32_t GetCapacity() const { return m_capacity; }
+	uint32_t GetFreeCount() const { return m_freeCount; }
+
+private:
+	std::map<uint32_t, uint32_t> m_free;	// Offset to length of each free range
+	uint32_t m_capacity;
+	uint32_t m_freeCount;
+};
+
+// One large vertex buffer and index buffer shared by all static geometry of one vertex format, with a single vertex
+// array pointing at them.  Objects get ranges in the buffers instead of buffers of their own, so drawing one after
+// another needs no vertex array or buffer switch.  Geometry is added on the thread that owns the GL context, while
+// loading; the buffers grow by copying when they are full, which keeps every range where it was.
+//
+// Geometry with few enough vertices gets 16-bit indices.  The index buffer holds both sizes, so it is allocated in
+// 16-bit units and 32-bit indices take two.
+class CGeometryArena
+{
+public:
+	static const uint32_t MAX_SHORT_INDEX_VERTICES = 65536;	// Geometry with more vertices keeps 32-bit indices
+
+	CGeometryArena();
+	~CGeometryArena();
+
+	// The arena holds vertices of type VertexType, indexCapacity counts 16-bit indices
+	template <typename VertexType>
+	void Create(uint32_t vertexCapacity, uint32_t indexCapacity)
+	{
+		Create(VertexLayout<VertexType>::FORMAT, sizeof(VertexType), &SetVertexAttributes<VertexType>, vertexCapacity, indexCapacity);
+	}
+	void Release();
+
+	// Copies the geometry into the arena.  Returns an empty range if the geometry is empty.
+	template <typename VertexType>
+	GeometryRange Add(const CVertexBuilder<VertexType>& geometry)
+	{
+		assert(VertexLayout<VertexType>::FORMAT == m_format && "Geometry of another vertex format than the arena's");
+		return Add(geometry.GetVertices().data(), static_cast<uint32_t>(geometry.GetVertices().size()), geometry.GetIndices());
+	}
+	// Gives the range's space back, the geometry must no longer be drawn
+	void Remove(const GeometryRange& range);
+
+	// Points the packet at the range: indexed with a base vertex if the range has indices, otherwise as vertices
+	void SetDrawRange(DrawPacket& packet, const GeometryRange& range) const;
+
+	GLuint GetVertexArray() const { return m_vao; }
+	VertexFormat GetVertexFormat() const { return m_format; }
+
+private:
+	VertexFormat m_format;
+	size_t m_vertexSize;
+	void (*m_setVertexAttributes)(GLintptr);
+	GLuint m_vao;
+	GLuint m_vertexBuffer;
+	GLuint m_indexBuffer;
+	CRangeAllocator m_vertices;
+	CRangeAllocator m_indices;
+
+	void Create(VertexFormat format, size_t vertexSize, void (*setVertexAttributes)(GLintptr), uint32_t vertexCapacity,
+				uint32_t indexCapacity);
+	GeometryRange Add(const void* pVertices, uint32_t vertexCount, const std::vector<uint32_t>& indices);
+	void GrowBuffer(GLuint& buffer, const char* name, size_t elementSize, CRangeAllocator& allocator, uint32_t needed);
+	void BindBuffers();
+};
@@ -0,0 +1,206 @@
+#include "glstatecache.h"
+
+CGLStateCache::CGLStateCache()
+{
+	m_counters = {};
+	Invalidate();
+}
+
+void CGLStateCache::Invalidate()
+{
+	m_program = UNKNOWN;
+	m_vertexArray = UNKNOWN;
+	m_activeTexture = UNKNOWN;
+	for (auto& unit : m_textures) {
+		for (GLuint& texture : unit)
+			texture = UNKNOWN;
+	}
+	for (GLuint& sampler : m_samplers)
+		sampler = UNKNOWN;
+	for (BufferRange& range : m_uniformBuffers)
+		range = {UNKNOWN, 0, 0};
+	for (int& enabled : m_enabled)
+		enabled = -1;
+	m_depthMask = -1;
+	m_blendSource = UNKNOWN;
+	m_blendDestination = UNKNOWN;
+	m_polygonMode = UNKNOWN;
+	m_viewport[0] = m_viewport[1] = m_viewport[2] = m_viewport[3] = -1;
+}
+
+void CGLStateCache::ForgetProgram(GLuint program)
+{
+	if (m_program == program)
+		m_program = UNKNOWN;
+}
+
+void CGLStateCache::ForgetBuffer(GLuint buffer)
+{
+	for (BufferRange& range : m_uniformBuffers) {
+		if (range.buffer == buffer)
+			range.buffer = UNKNOWN;
+	}
+}
+
+void CGLStateCache::ForgetTexture(GLuint texture)
+{
+	for (auto& unit : m_textures) {
+		for (GLuint& bound : unit) {
+			if (bound == texture)
+				bound = UNKNOWN;
+		}
+	}
+}
+
+void CGLStateCache::ForgetSampler(GLuint sampler)
+{
+	for (GLuint& bound : m_samplers) {
+		if (bound == sampler)
+			bound = UNKNOWN;
+	}
+}
+
+void CGLStateCache::ForgetVertexArray(GLuint vertexArray)
+{
+	if (m_vertexArray == vertexArray)
+		m_vertexArray = UNKNOWN;
+}
+
+CGLStateCache& CGLStateCache::Get()
+{
+	static CGLStateCache instance;
+	return instance;
+}
+
+void CGLStateCache::UseProgram(GLuint program)
+{
+	if (Changed(m_program != program)) {
+		glUseProgram(program);
+		m_program = program;
+	}
+}
+
+void CGLStateCache::BindVertexArray(GLuint vertexArray)
+{
+	if (Changed(m_vertexArray != vertexArray)) {
+		glBindVertexArray(vertexArray);
+		m_vertexArray = vertexArray;
+	}
+}
+
+// Only selects the unit when something is bound to it, which most redundant binds never get to
+void CGLStateCache::ActiveTexture(GLuint unit)
+{
+	if (m_activeTexture != unit) {
+		glActiveTexture(GL_TEXTURE0 + unit);
+		m_activeTexture = unit;
+	}
+}
+
+void CGLStateCache::BindTexture(GLuint unit, GLenum target, GLuint texture)
+{
+	int targetIndex;
+	switch (target) {
+		case GL_TEXTURE_2D: targetIndex = TARGET_2D; break;
+		case GL_TEXTURE_CUBE_MAP: targetIndex = TARGET_CUBE_MAP; break;
+		case GL_TEXTURE_BUFFER: targetIndex = TARGET_BUFFER; break;
+		default: targetIndex = -1; break;
+	}
+
+	if (unit >= MAX_TEXTURE_UNITS || targetIndex < 0) {
+		Changed(true);
+		ActiveTexture(unit);
+		glBindTexture(target, texture);
+		return;
+	}
+
+	if (Changed(m_textures[unit][targetIndex] != texture)) {
+		ActiveTexture(unit);
+		glBindTexture(target, texture);
+		m_textures[unit][targetIndex] = texture;
+	}
+}
+
+void CGLStateCache::BindSampler(GLuint unit, GLuint sampler)
+{
+	if (unit >= MAX_TEXTURE_UNITS) {
+		Changed(true);
+		glBindSampler(unit, sampler);
+		return;
+	}
+
+	if (Changed(m_samplers[unit] != sampler)) {
+		glBindSampler(unit, sampler);
+		m_samplers[unit] = sampler;
+	}
+}
+
+void CGLStateCache::BindUniformBuffer(GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size)
+{
+	if (index >= MAX_UNIFORM_BUFFERS) {
+		Changed(true);
+		glBindBufferRange(GL_UNIFORM_BUFFER, index, buffer, offset, size);
+		return;
+	}
+
+	BufferRange& range = m_uniformBuffers[index];
+	if (Changed(range.buffer != buffer || range.offset != offset || range.size != size)) {
+		glBindBufferRange(GL_UNIFORM_BUFFER, index, buffer, offset, size);
+		range = {buffer, offset, size};
+	}
+}
+
+void CGLStateCache::SetEnabled(GLenum capability, bool enabled)
+{
+	int index;
+	switch (capability) {
+		case GL_DEPTH_TEST: index = CAP_DEPTH_TEST; break;
+		case GL_CULL_FACE: index = CAP_CULL_FACE; break;
+		case GL_BLEND: index = CAP_BLEND; break;
+		default:
+			Changed(true);
+			enabled ? glEnable(capability) : glDisable(capability);
+			return;
+	}
+
+	if (Changed(m_enabled[index] != static_cast<int>(enabled))) {
+		enabled ? glEnable(capability) : glDisable(capability);
+		m_enabled[index] = enabled;
+	}
+}
+
+void CGLStateCache::SetDepthMask(bool enabled)
+{
+	if (Changed(m_depthMask != static_cast<int>(enabled))) {
+		glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+		m_depthMask = enabled;
+	}
+}
+
+void CGLStateCache::SetBlendFunc(GLenum source, GLenum destination)
+{
+	if (Changed(m_blendSource != source || m_blendDestination != destination)) {
+		glBlendFunc(source, destination);
+		m_blendSource = source;
+		m_blendDestination = destination;
+	}
+}
+
+void CGLStateCache::SetPolygonMode(GLenum mode)
+{
+	if (Changed(m_polygonMode != mode)) {
+		glPolygonMode(GL_FRONT_AND_BACK, mode);
+		m_polygonMode = mode;
+	}
+}
+
+void CGLStateCache::SetViewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+	if (Changed(m_viewport[0] != x || m_viewport[1] != y || m_viewport[2] != width || m_viewport[3] != height)) {
+		glViewport(x, y, width, height);
+		m_viewport[0] = x;
+		m_viewport[1] = y;
+		m_viewport[2] = width;
+		m_viewport[3] = height;
+	}
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+// Shadows the GL state the render device sets while replaying and drops calls that wouldn't change it.  Everything
+// starts out unknown, so nothing is assumed about state set before the device took over the context, e.g. while
+// loading.  State changed behind the cache's back has to be invalidated.
+class CGLStateCache
+{
+public:
+	CGLStateCache();
+
+	// Forgets the shadowed state, the next change to anything is issued
+	void Invalidate();
+	// Called when an object is deleted, GL may hand its ID out again
+	void ForgetProgram(GLuint program);
+	void ForgetBuffer(GLuint buffer);
+	void ForgetTexture(GLuint texture);
+	void ForgetSampler(GLuint sampler);
+	void ForgetVertexArray(GLuint vertexArray);
+
+	// One cache shadows the context, whichever thread currently owns it
+	static CGLStateCache& Get();
+
+	void UseProgram(GLuint program);
+	void BindVertexArray(GLuint vertexArray);
+	void BindTexture(GLuint unit, GLenum target, GLuint texture);
+	void BindSampler(GLuint unit, GLuint sampler);
+	void BindUniformBuffer(GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+	void SetEnabled(GLenum capability, bool enabled);	// GL_DEPTH_TEST, GL_CULL_FACE or GL_BLEND
+	void SetDepthMask(bool enabled);
+	void SetBlendFunc(GLenum source, GLenum destination);
+	void SetPolygonMode(GLenum mode);
+	void SetViewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+	// Number of state changes passed on to GL and dropped because the state was already set
+	struct Counters
+	{
+		uint32_t issued;
+		uint32_t filtered;
+	};
+	const Counters& GetCounters() const { return m_counters; }
+	void ResetCounters() { m_counters = {}; }
+
+private:
+	static const GLuint UNKNOWN = ~0u;
+	static const GLuint MAX_TEXTURE_UNITS = 16;		// Units above this are always bound, the game uses up to 10
+	static const GLuint MAX_UNIFORM_BUFFERS = 8;
+
+	enum { TARGET_2D, TARGET_CUBE_MAP, TARGET_BUFFER, TARGET_COUNT };
+	enum { CAP_DEPTH_TEST, CAP_CULL_FACE, CAP_BLEND, CAP_COUNT };
+
+	struct BufferRange
+	{
+		GLuint buffer;
+		GLintptr offset;
+		GLsizeiptr size;
+	};
+
+	GLuint m_program;
+	GLuint m_vertexArray;
+	GLuint m_activeTexture;
+	GLuint m_textures[MAX_TEXTURE_UNITS][TARGET_COUNT];
+	GLuint m_samplers[MAX_TEXTURE_UNITS];
+	BufferRange m_uniformBuffers[MAX_UNIFORM_BUFFERS];
+	int m_enabled[CAP_COUNT];		// -1 if unknown
+	int m_depthMask;				// -1 if unknown
+	GLenum m_blendSource;
+	GLenum m_blendDestination;
+	GLenum m_polygonMode;
+	GLint m_viewport[4];
+	Counters m_counters;
+
+	// Counts the change and returns true if it has to be issued
+	bool Changed(bool changed)
+	{
+		if (changed)
+			m_counters.issued++;
+		else
+			m_counters.filtered++;
+		return changed;
+	}
+
+	void ActiveTexture(GLuint unit);
+};
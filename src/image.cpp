@@ -1,10 +1,14 @@
 #include "image.h"
+#include "trace.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
-Image::Image(const std::string& path, bool flip) {
-    stbi_set_flip_vertically_on_load(flip);
+Image::Image(const std::string& path, bool flip) : path{path} {
+    TRACE_SCOPE("Image::Image");
+
+    // The per-thread flag keeps concurrent decodes on the job system from racing on stb's global setting
+    stbi_set_flip_vertically_on_load_thread(flip);
     pixels = stbi_load(path.c_str(), &width, &height, &channels, 0);
     if (!pixels) {
         std::cerr << "Failed to load image: \"" << path << "\" - " << stbi_failure_reason();
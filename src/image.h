@@ -5,7 +5,11 @@ struct Image {
     int width;
     int height;
     int channels;
+    std::string path;     // The file the image was decoded from, for diagnostics
 
     Image(const std::string& path, bool flip = true);
     ~Image();
+
+    Image(const Image&) = delete;
+    Image& operator=(const Image&) = delete;
 };
\ No newline at end of file
@@ -6,6 +6,13 @@ uint32_t Input::current{};
 glm::vec2 Input::delta{};
 glm::vec2 Input::scroll{};
 glm::vec2 Input::position{};
+bool Input::recording{};
+std::filesystem::path Input::recordingPath{};
+std::vector<Input::Event> Input::events{};
+size_t Input::replayNext{};
+bool Input::resyncCursor{};
+
+static const char INPUT_FILE_MAGIC[4] = {'I', 'N', 'P', '1'};
 
 void Input::Init(const Window& window) {
     glfwSetKeyCallback(window, KeyCallback);
@@ -40,6 +47,9 @@ void Input::Update() {
     current++;
     delta = {};
     scroll = {};
+
+    if (Replaying())
+        ApplyReplay();
 }
 
 glm::vec2& Input::MousePosition() {
@@ -54,34 +64,137 @@ glm::vec2& Input::MouseScroll() {
     return scroll;
 }
 
+void Input::StartRecording(const std::filesystem::path& path) {
+    recording = true;
+    recordingPath = path;
+    events.clear();
+}
+
+// Writes the recorded events, a magic number followed by the raw event records
+bool Input::StopRecording() {
+    if (!recording)
+        return false;
+    recording = false;
+
+    std::ofstream file(recordingPath, std::ios::binary);
+    file.write(INPUT_FILE_MAGIC, sizeof(INPUT_FILE_MAGIC));
+    file.write(reinterpret_cast<const char*>(events.data()), static_cast<std::streamsize>(events.size() * sizeof(Event)));
+    if (!file) {
+        std::cerr << "Failed to write input recording: \"" << recordingPath.string() << "\"" << std::endl;
+        return false;
+    }
+
+    std::cout << "Recorded " << events.size() << " input events to " << recordingPath.string() << std::endl;
+    events.clear();
+    return true;
+}
+
+bool Input::StartReplay(const std::filesystem::path& path) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        std::cerr << "Failed to open input recording: \"" << path.string() << "\"" << std::endl;
+        return false;
+    }
+
+    auto size = static_cast<size_t>(file.tellg());
+    char magic[sizeof(INPUT_FILE_MAGIC)] = {};
+    file.seekg(0);
+    file.read(magic, sizeof(magic));
+    if (!file || std::memcmp(magic, INPUT_FILE_MAGIC, sizeof(magic)) != 0 || (size - sizeof(magic)) % sizeof(Event) != 0) {
+        std::cerr << "Not an input recording: \"" << path.string() << "\"" << std::endl;
+        return false;
+    }
+
+    recording = false;
+    events.resize((size - sizeof(magic)) / sizeof(Event));
+    file.read(reinterpret_cast<char*>(events.data()), static_cast<std::streamsize>(events.size() * sizeof(Event)));
+
+    // Replays always start from the first simulation step
+    std::fill(std::begin(keys), std::end(keys), false);
+    current = 0;
+    position = delta = scroll = {};
+    resyncCursor = false;
+    replayNext = 0;
+    ApplyReplay();
+    return true;
+}
+
+bool Input::Replaying() {
+    return replayNext < events.size() && !recording;
+}
+
+// Applies the recorded events that belong to the current step, and hands input back to the user at the end
+void Input::ApplyReplay() {
+    while (replayNext < events.size() && events[replayNext].step <= current)
+        Apply(events[replayNext++]);
+
+    if (replayNext == events.size()) {
+        std::cout << "Input replay finished" << std::endl;
+        events.clear();
+        replayNext = 0;
+
+        // Don't leave keys that were held at the end of the recording stuck down
+        std::fill(std::begin(keys), std::end(keys), false);
+
+        // The position is where the recording left the cursor, not where the real one is, so measuring the first live
+        // event against it would jump the camera
+        resyncCursor = true;
+    }
+}
+
+// Live events from GLFW are dropped during a replay so the recording is the only source of input
+void Input::Dispatch(const Event& event) {
+    if (Replaying())
+        return;
+
+    if (recording)
+        events.push_back(event);
+
+    Apply(event);
+}
+
+void Input::Apply(const Event& event) {
+    switch (event.type) {
+        case EventType::CursorPosition: {
+            glm::vec2 mouse {event.x, event.y};
+            if (!resyncCursor)
+                delta += mouse - position;
+            resyncCursor = false;
+            position = mouse;
+            break;
+        }
+        case EventType::Scroll:
+            scroll = {event.x, event.y};
+            break;
+        case EventType::Key:
+        case EventType::MouseButton: {
+            int key = event.type == EventType::MouseButton ? MOUSE_BUTTONS + event.code : event.code;
+            if (key < 0 || key >= static_cast<int>(std::size(keys)))
+                break;
+            if (event.action == GLFW_PRESS) {
+                keys[key] = true;
+                frames[key] = current;
+            } else if (event.action == GLFW_RELEASE) {
+                keys[key] = false;
+                frames[key] = current;
+            }
+            break;
+        }
+    }
+}
+
 void Input::CursorPositionCallback(GLFWwindow* window, double mouseX, double mouseY) {
-    glm::vec2 mouse {mouseX, mouseY};
-    delta += mouse - position;
-    position = mouse;
+    Dispatch({current, EventType::CursorPosition, 0, 0, static_cast<float>(mouseX), static_cast<float>(mouseY)});
 }
 
 void Input::ScrollCallback(GLFWwindow* window, double offsetX, double offsetY) {
-    glm::vec2 offset {offsetX, offsetY};
-    scroll = offset;
+    Dispatch({current, EventType::Scroll, 0, 0, static_cast<float>(offsetX), static_cast<float>(offsetY)});
 }
 
 void Input::MouseButtonCallback(GLFWwindow* window, int button, int action, int mode) {
-    int key = MOUSE_BUTTONS + button;
-    if (action == GLFW_PRESS) {
-        keys[key] = true;
-        frames[key] = current;
-    } else if (action == GLFW_RELEASE) {
-        keys[key] = false;
-        frames[key] = current;
-    }
+    Dispatch({current, EventType::MouseButton, static_cast<uint8_t>(action), static_cast<int16_t>(button), 0.0f, 0.0f});
 }
 
 void Input::KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mode) {
-    if (action == GLFW_PRESS) {
-        keys[key] = true;
-        frames[key] = current;
-    } else if (action == GLFW_RELEASE) {
-        keys[key] = false;
-        frames[key] = current;
-    }
-}
\ No newline at end of file
+    Dispatch({current, EventType::Key, static_cast<uint8_t>(action), static_cast<int16_t>(key), 0.0f, 0.0f});
+}
@@ -6,6 +6,18 @@
 
 class Input {
 private:
+    enum class EventType : uint8_t { Key, MouseButton, CursorPosition, Scroll };
+
+    // One input event as stored in a recording, stamped with the simulation step that consumes it
+    struct Event {
+        uint32_t step;
+        EventType type;
+        uint8_t action;
+        int16_t code;
+        float x, y;
+    };
+    static_assert(sizeof(Event) == 16, "recorded events are written as raw 16 byte records");
+
     static bool keys[512];
     static uint32_t frames[512];
     static uint32_t current;
@@ -13,6 +25,12 @@ private:
     static glm::vec2 scroll;
     static glm::vec2 position;
 
+    static bool recording;
+    static std::filesystem::path recordingPath;
+    static std::vector<Event> events;       // Events being recorded, or the recording being replayed
+    static size_t replayNext;
+    static bool resyncCursor;               // The next cursor event only sets the position, e.g. after a replay moved it
+
 public:
     static void Init(const Window& window);
     static void Update();
@@ -27,7 +45,19 @@ public:
     static glm::vec2& MouseDelta();
     static glm::vec2& MouseScroll();
 
+    // A recording captures every input event and writes it to a compact binary file when it stops.  A replay feeds a
+    // recording back in place of the GLFW callbacks.  Events are stamped with the simulation step that consumed them,
+    // so replaying gives the simulation exactly the same input on every step, however long each frame takes.
+    static void StartRecording(const std::filesystem::path& path);
+    static bool StopRecording();
+    static bool StartReplay(const std::filesystem::path& path);
+    static bool Replaying();
+
 private:
+    static void Dispatch(const Event& event);
+    static void Apply(const Event& event);
+    static void ApplyReplay();
+
     static void CursorPositionCallback(GLFWwindow* window, double mouseX, double mouseY);
     static void ScrollCallback(GLFWwindow* window, double offsetX, double offsetY);
     static void MouseButtonCallback(GLFWwindow* window, int button, int action, int mode);
@@ -0,0 +1,234 @@
+#include "jobsystem.h"
+#include "trace.h"
+
+JobSystem* JobSystem::instance;
+
+// Worker threads remember which job system they belong to and which queue they own
+static thread_local const JobSystem* t_jobSystem = nullptr;
+static thread_local uint32_t t_queueIndex = 0;
+
+JobSystem::JobSystem(uint32_t numThreads)
+{
+    if (numThreads == 0)
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+
+    for (uint32_t i = 0; i < numThreads; i++)
+        m_queues.push_back(std::make_unique<WorkQueue>());
+
+    // The owner thread takes queue 0, the other queues get a dedicated worker each
+    for (uint32_t i = 1; i < numThreads; i++)
+        m_workers.emplace_back(&JobSystem::WorkerLoop, this, i);
+
+    if (instance == nullptr) {
+        instance = this;
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_running = false;
+    }
+    m_wakeCondition.notify_all();
+
+    for (auto& worker : m_workers)
+        worker.join();
+
+    if (instance == this) {
+        instance = nullptr;
+    }
+}
+
+JobHandle JobSystem::Schedule(std::function<void()> function, std::initializer_list<JobHandle> dependencies)
+{
+    auto job = std::make_shared<Job>();
+    job->function = std::move(function);
+
+    for (auto& dependency : dependencies)
+        AddDependency(job, dependency);
+
+    Release(job);
+    return job;
+}
+
+JobHandle JobSystem::Schedule(std::function<void()> function, const std::vector<JobHandle>& dependencies)
+{
+    auto job = std::make_shared<Job>();
+    job->function = std::move(function);
+
+    for (auto& dependency : dependencies)
+        AddDependency(job, dependency);
+
+    Release(job);
+    return job;
+}
+
+JobHandle JobSystem::Then(const JobHandle& job, std::function<void()> function)
+{
+    return Schedule(std::move(function), { job });
+}
+
+void JobSystem::Wait(const JobHandle& job)
+{
+    while (!IsDone(job)) {
+        if (!TryExecute())
+            std::this_thread::yield();
+    }
+}
+
+void JobSystem::Wait(const std::vector<JobHandle>& jobs)
+{
+    for (auto& job : jobs)
+        Wait(job);
+}
+
+void JobSystem::ParallelFor(uint32_t count, uint32_t grainSize, const std::function<void(uint32_t, uint32_t)>& function)
+{
+    if (count == 0)
+        return;
+
+    grainSize = std::max(1u, grainSize);
+
+    // A single range is not worth the scheduling overhead
+    if (count <= grainSize || m_queues.size() == 1) {
+        function(0, count);
+        return;
+    }
+
+    std::vector<JobHandle> jobs;
+    jobs.reserve((count + grainSize - 1) / grainSize);
+
+    for (uint32_t begin = 0; begin < count; begin += grainSize) {
+        uint32_t end = std::min(begin + grainSize, count);
+        jobs.push_back(Schedule([&function, begin, end] { function(begin, end); }));
+    }
+
+    Wait(jobs);
+}
+
+// Registers the job as a continuation of the dependency, unless the dependency has already finished
+void JobSystem::AddDependency(const JobHandle& job, const JobHandle& dependency)
+{
+    if (!dependency)
+        return;
+
+    std::lock_guard<std::mutex> lock(dependency->mutex);
+    if (dependency->finished.load(std::memory_order_acquire))
+        return;
+
+    job->pendingDependencies.fetch_add(1, std::memory_order_relaxed);
+    dependency->continuations.push_back(job);
+}
+
+// Drops one pending dependency and queues the job once none are left
+void JobSystem::Release(const JobHandle& job)
+{
+    if (job->pendingDependencies.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        Submit(job);
+}
+
+void JobSystem::Submit(const JobHandle& job)
+{
+    {
+        // Count the job before it becomes visible so the counter never drops below the number of queued jobs,
+        // and take the sleep mutex so the increment cannot slip between a worker's check and its wait
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_queuedJobs.fetch_add(1, std::memory_order_release);
+    }
+
+    auto& queue = *m_queues[GetQueueIndex()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs.push_back(job);
+    }
+    m_wakeCondition.notify_one();
+}
+
+void JobSystem::Finish(const JobHandle& job)
+{
+    // Release the function's captures before the job is published as finished, so their destructors have run by
+    // the time Wait returns
+    job->function = nullptr;
+
+    std::vector<JobHandle> continuations;
+    {
+        std::lock_guard<std::mutex> lock(job->mutex);
+        job->finished.store(true, std::memory_order_release);
+        continuations.swap(job->continuations);
+    }
+
+    for (auto& continuation : continuations)
+        Release(continuation);
+}
+
+// Takes the most recently pushed job from the thread's own queue
+bool JobSystem::Pop(uint32_t index, JobHandle& job)
+{
+    auto& queue = *m_queues[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.jobs.empty())
+        return false;
+
+    job = std::move(queue.jobs.back());
+    queue.jobs.pop_back();
+    return true;
+}
+
+// Takes the oldest job from another thread's queue, starting with the next one along to spread contention
+bool JobSystem::Steal(uint32_t index, JobHandle& job)
+{
+    auto numQueues = static_cast<uint32_t>(m_queues.size());
+    for (uint32_t i = 1; i < numQueues; i++) {
+        auto& queue = *m_queues[(index + i) % numQueues];
+        std::unique_lock<std::mutex> lock(queue.mutex, std::try_to_lock);
+        if (!lock.owns_lock() || queue.jobs.empty())
+            continue;
+
+        job = std::move(queue.jobs.front());
+        queue.jobs.pop_front();
+        return true;
+    }
+    return false;
+}
+
+bool JobSystem::TryExecute()
+{
+    uint32_t index = GetQueueIndex();
+
+    JobHandle job;
+    if (!Pop(index, job) && !Steal(index, job))
+        return false;
+
+    m_queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+
+    job->function();
+    Finish(job);
+    return true;
+}
+
+void JobSystem::WorkerLoop(uint32_t index)
+{
+    t_jobSystem = this;
+    t_queueIndex = index;
+    Trace::SetThreadName(("Worker " + std::to_string(index)).c_str());
+
+    while (true) {
+        if (TryExecute())
+            continue;
+
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_wakeCondition.wait(lock, [this] {
+            return !m_running || m_queuedJobs.load(std::memory_order_acquire) > 0;
+        });
+
+        if (!m_running)
+            break;
+    }
+}
+
+// Threads that are not workers of this job system (the owner, or any other thread) share queue 0
+uint32_t JobSystem::GetQueueIndex() const
+{
+    return t_jobSystem == this ? t_queueIndex : 0;
+}
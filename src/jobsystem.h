@@ -0,0 +1,76 @@
+#pragma once
+
+// A unit of work scheduled on the job system.  A job runs once all the jobs it depends on have finished,
+// and any continuations attached to it are released when it finishes.
+struct Job
+{
+    std::function<void()> function;
+    std::atomic<uint32_t> pendingDependencies{ 1 };	// Unfinished dependencies, plus one while the job is being scheduled
+    std::atomic<bool> finished{ false };
+
+    std::mutex mutex;								// Guards continuations against a racing finish
+    std::vector<std::shared_ptr<Job>> continuations;	// Jobs waiting for this one to finish
+};
+
+using JobHandle = std::shared_ptr<Job>;
+
+// A work-stealing job scheduler.  Every worker thread owns a deque: it pushes and pops its own jobs at the back
+// (LIFO, cache friendly) while idle workers steal from the front of other deques (FIFO, oldest and largest work first).
+// The thread that creates the job system owns deque 0 and helps executing jobs whenever it waits on one.
+class JobSystem
+{
+public:
+    explicit JobSystem(uint32_t numThreads = 0);	// Total threads including the calling one, 0 uses every hardware thread
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    static JobSystem& GetInstance() { return *instance; }
+
+    // Schedules a job that runs after all the given dependencies have finished
+    JobHandle Schedule(std::function<void()> function, std::initializer_list<JobHandle> dependencies = {});
+    JobHandle Schedule(std::function<void()> function, const std::vector<JobHandle>& dependencies);
+
+    // Schedules a continuation that runs once the job has finished
+    JobHandle Then(const JobHandle& job, std::function<void()> function);
+
+    // Blocks until the job has finished, executing other jobs in the meantime
+    void Wait(const JobHandle& job);
+    void Wait(const std::vector<JobHandle>& jobs);
+    static bool IsDone(const JobHandle& job) { return job->finished.load(std::memory_order_acquire); }
+
+    // Splits [0, count) into ranges of at most grainSize elements, runs them in parallel and waits for all of them
+    void ParallelFor(uint32_t count, uint32_t grainSize, const std::function<void(uint32_t begin, uint32_t end)>& function);
+
+    uint32_t GetThreadCount() const { return static_cast<uint32_t>(m_queues.size()); }
+
+private:
+    struct WorkQueue
+    {
+        std::mutex mutex;
+        std::deque<JobHandle> jobs;
+    };
+
+    std::vector<std::unique_ptr<WorkQueue>> m_queues;	// One per thread, index 0 belongs to the owner thread
+    std::vector<std::thread> m_workers;
+
+    std::mutex m_sleepMutex;
+    std::condition_variable m_wakeCondition;
+    std::atomic<uint32_t> m_queuedJobs{ 0 };
+    std::atomic<bool> m_running{ true };
+
+    void Submit(const JobHandle& job);
+    void Finish(const JobHandle& job);
+    void AddDependency(const JobHandle& job, const JobHandle& dependency);
+    void Release(const JobHandle& job);
+
+    bool Pop(uint32_t index, JobHandle& job);
+    bool Steal(uint32_t index, JobHandle& job);
+    bool TryExecute();
+    void WorkerLoop(uint32_t index);
+
+    uint32_t GetQueueIndex() const;
+
+    static JobSystem* instance;
+};
@@ -0,0 +1,251 @@
+#include "lightclusters.h"
+#include "glstatecache.h"
+#include "jobsystem.h"
+
+CLightClusters::CLightClusters()
+{
+	for (int i = 0; i < BUFFER_COUNT; i++) {
+		m_buffers[i] = 0;
+		m_textures[i] = 0;
+	}
+	m_projMatrix = glm::mat4{0.0f};
+	m_zNear = 0.0f;
+	m_zFar = 0.0f;
+	m_sliceScale = 0.0f;
+	m_sliceBias = 0.0f;
+	m_grid.resize(CLUSTER_COUNT, glm::uvec2{0});
+	m_reportedLightOverflow = false;
+	m_reportedIndexOverflow = false;
+}
+
+CLightClusters::~CLightClusters()
+{
+	Release();
+}
+
+// Sizes and texel formats of the grid, the index lists and the lights
+static const GLenum FORMATS[] = {GL_RG32UI, GL_R16UI, GL_RGBA32F};
+static const size_t CAPACITIES[] = {CLightClusters::CLUSTER_COUNT * sizeof(glm::uvec2), CLightClusters::MAX_LIGHT_INDICES * sizeof(uint16_t),
+									CLightClusters::MAX_LIGHTS * 2 * sizeof(glm::vec4)};
+
+void CLightClusters::Create()
+{
+	Release();
+
+	glGenBuffers(BUFFER_COUNT, m_buffers);
+	glGenTextures(BUFFER_COUNT, m_textures);
+	for (int i = 0; i < BUFFER_COUNT; i++) {
+		glBindBuffer(GL_TEXTURE_BUFFER, m_buffers[i]);
+		glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(CAPACITIES[i]), nullptr, GL_STREAM_DRAW);
+		CGLStateCache::Get().BindTexture(0, GL_TEXTURE_BUFFER, m_textures[i]);
+		glTexBuffer(GL_TEXTURE_BUFFER, FORMATS[i], m_buffers[i]);
+	}
+}
+
+void CLightClusters::Release()
+{
+	if (m_buffers[0] == 0)
+		return;
+
+	for (int i = 0; i < BUFFER_COUNT; i++)
+		CGLStateCache::Get().ForgetTexture(m_textures[i]);
+	glDeleteTextures(BUFFER_COUNT, m_textures);
+	glDeleteBuffers(BUFFER_COUNT, m_buffers);
+	for (int i = 0; i < BUFFER_COUNT; i++) {
+		m_buffers[i] = 0;
+		m_textures[i] = 0;
+	}
+}
+
+// Cluster bounds only depend on the projection.  Slices are spaced exponentially between the near and far planes, so
+// clusters are roughly as deep as they are wide on screen.
+void CLightClusters::BuildClusterBounds(const glm::mat4& projMatrix)
+{
+	m_projMatrix = projMatrix;
+
+	// Recover the planes of a glm::perspective matrix
+	m_zNear = projMatrix[3][2] / (projMatrix[2][2] - 1.0f);
+	m_zFar = projMatrix[3][2] / (projMatrix[2][2] + 1.0f);
+	m_sliceScale = GRID_Z / std::log(m_zFar / m_zNear);
+	m_sliceBias = -m_sliceScale * std::log(m_zNear);
+
+	std::array<float, GRID_Z + 1> sliceDepths;
+	for (uint32_t z = 0; z <= GRID_Z; z++)
+		sliceDepths[z] = m_zNear * std::pow(m_zFar / m_zNear, static_cast<float>(z) / GRID_Z);
+
+	// A tile's edges in eye coordinates lie on lines through the eye, so the extremes are at the near or far depth
+	auto eyeRange = [](float ndcMin, float ndcMax, float nearDepth, float farDepth, float projScale) {
+		return glm::vec2{std::min(ndcMin * nearDepth, ndcMin * farDepth) / projScale, std::max(ndcMax * nearDepth, ndcMax * farDepth) / projScale};
+	};
+
+	m_clusterMin.resize(CLUSTER_COUNT);
+	m_clusterMax.resize(CLUSTER_COUNT);
+	for (uint32_t z = 0; z < GRID_Z; z++) {
+		float nearDepth = sliceDepths[z];
+		float farDepth = sliceDepths[z + 1];
+		for (uint32_t y = 0; y < GRID_Y; y++) {
+			glm::vec2 rangeY = eyeRange(-1.0f + 2.0f * y / GRID_Y, -1.0f + 2.0f * (y + 1) / GRID_Y, nearDepth, farDepth, projMatrix[1][1]);
+			for (uint32_t x = 0; x < GRID_X; x++) {
+				glm::vec2 rangeX = eyeRange(-1.0f + 2.0f * x / GRID_X, -1.0f + 2.0f * (x + 1) / GRID_X, nearDepth, farDepth, projMatrix[0][0]);
+				uint32_t cluster = (z * GRID_Y + y) * GRID_X + x;
+				m_clusterMin[cluster] = glm::vec3{rangeX.x, rangeY.x, -farDepth};
+				m_clusterMax[cluster] = glm::vec3{rangeX.y, rangeY.y, -nearDepth};
+			}
+		}
+	}
+}
+
+int CLightClusters::GetSlice(float depth) const
+{
+	int slice = static_cast<int>(std::floor(std::log(depth) * m_sliceScale + m_sliceBias));
+	return std::clamp(slice, 0, static_cast<int>(GRID_Z) - 1);
+}
+
+void CLightClusters::Assign(const std::vector<PointLight>& lights, const glm::mat4& viewMatrix, const glm::mat4& projMatrix)
+{
+	if (projMatrix != m_projMatrix)
+		BuildClusterBounds(projMatrix);
+
+	size_t lightCount = lights.size();
+	if (lightCount > MAX_LIGHTS) {
+		if (!m_reportedLightOverflow)
+			std::cerr << "Error! Only the first " << MAX_LIGHTS << " of " << lightCount << " point lights are used" << std::endl;
+		m_reportedLightOverflow = true;
+		lightCount = MAX_LIGHTS;
+	}
+
+	// Move the lights into eye coordinates and find the depth slices each one reaches into
+	m_eyeLights.resize(lightCount);
+	m_lightSlices.resize(lightCount);
+	m_lightData.resize(lightCount * 2);
+	for (size_t i = 0; i < lightCount; i++) {
+		const PointLight& light = lights[i];
+		glm::vec3 eyePosition = glm::vec3{viewMatrix * glm::vec4{light.position, 1.0f}};
+		m_eyeLights[i] = glm::vec4{eyePosition, light.radius};
+		m_lightData[i * 2] = m_eyeLights[i];
+		m_lightData[i * 2 + 1] = glm::vec4{light.colour, 0.0f};
+
+		float depth = -eyePosition.z;
+		if (depth + light.radius < m_zNear || depth - light.radius > m_zFar)
+			m_lightSlices[i] = glm::ivec2{1, 0};
+		else
+			m_lightSlices[i] = glm::ivec2{GetSlice(std::max(depth - light.radius, m_zNear)), GetSlice(std::min(depth + light.radius, m_zFar))};
+	}
+
+	m_indices.clear();
+	if (lightCount == 0) {
+		std::fill(m_grid.begin(), m_grid.end(), glm::uvec2{0});
+		return;
+	}
+
+	// Slices don't share any clusters, so each job fills in its own slice's part of the grid
+	JobSystem::GetInstance().ParallelFor(GRID_Z, 1, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t slice = begin; slice < end; slice++)
+			AssignSlice(slice);
+	});
+
+	// Join the slices' lists, moving the offsets from the slice's list to the joined one
+	for (uint32_t slice = 0; slice < GRID_Z; slice++) {
+		const std::vector<uint16_t>& sliceIndices = m_slices[slice].clusterIndices;
+		for (uint32_t cluster = slice * GRID_X * GRID_Y; cluster < (slice + 1) * GRID_X * GRID_Y; cluster++) {
+			glm::uvec2& entry = m_grid[cluster];
+			uint32_t count = std::min<uint32_t>(entry.y, MAX_LIGHT_INDICES - static_cast<uint32_t>(m_indices.size()));
+			if (count < entry.y && !m_reportedIndexOverflow) {
+				std::cerr << "Error! Too many lights per cluster, some are left out" << std::endl;
+				m_reportedIndexOverflow = true;
+			}
+
+			m_indices.insert(m_indices.end(), sliceIndices.begin() + entry.x, sliceIndices.begin() + entry.x + count);
+			entry = glm::uvec2{static_cast<uint32_t>(m_indices.size()) - count, count};
+		}
+	}
+}
+
+void CLightClusters::AssignSlice(uint32_t slice)
+{
+	SliceLights& lights = m_slices[slice];
+	lights.x.clear();
+	lights.y.clear();
+	lights.z.clear();
+	lights.radiusSquared.clear();
+	lights.index.clear();
+	lights.clusterIndices.clear();
+
+	for (size_t i = 0; i < m_eyeLights.size(); i++) {
+		if (m_lightSlices[i].x <= static_cast<int>(slice) && static_cast<int>(slice) <= m_lightSlices[i].y) {
+			const glm::vec4& light = m_eyeLights[i];
+			lights.x.push_back(light.x);
+			lights.y.push_back(light.y);
+			lights.z.push_back(light.z);
+			lights.radiusSquared.push_back(light.w * light.w);
+			lights.index.push_back(static_cast<uint16_t>(i));
+		}
+	}
+
+	// A negative radius fails the test whatever the distance
+	while (lights.index.size() % 4 != 0) {
+		lights.x.push_back(0.0f);
+		lights.y.push_back(0.0f);
+		lights.z.push_back(0.0f);
+		lights.radiusSquared.push_back(-1.0f);
+		lights.index.push_back(0);
+	}
+
+	for (uint32_t cluster = slice * GRID_X * GRID_Y; cluster < (slice + 1) * GRID_X * GRID_Y; cluster++) {
+		auto offset = static_cast<uint32_t>(lights.clusterIndices.size());
+		for (size_t first = 0; first < lights.index.size(); first += 4) {
+			uint32_t mask = TestLights(m_clusterMin[cluster], m_clusterMax[cluster], lights, first);
+			for (size_t i = 0; i < 4; i++) {
+				if (mask & (1u << i))
+					lights.clusterIndices.push_back(lights.index[first + i]);
+			}
+		}
+		m_grid[cluster] = glm::uvec2{offset, static_cast<uint32_t>(lights.clusterIndices.size()) - offset};
+	}
+}
+
+// Returns a bit for each of the four lights from first whose sphere overlaps the cluster's box
+uint32_t CLightClusters::TestLights(const glm::vec3& clusterMin, const glm::vec3& clusterMax, const SliceLights& lights, size_t first)
+{
+#if USE_SSE2
+	const __m128 zero = _mm_setzero_ps();
+	auto axisDistance = [&](const float* centres, float boxMin, float boxMax) {
+		__m128 centre = _mm_loadu_ps(centres);
+		__m128 distance = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_set1_ps(boxMin), centre), _mm_sub_ps(centre, _mm_set1_ps(boxMax))), zero);
+		return _mm_mul_ps(distance, distance);
+	};
+
+	__m128 distanceSquared = _mm_add_ps(_mm_add_ps(axisDistance(&lights.x[first], clusterMin.x, clusterMax.x),
+												   axisDistance(&lights.y[first], clusterMin.y, clusterMax.y)),
+										axisDistance(&lights.z[first], clusterMin.z, clusterMax.z));
+	return static_cast<uint32_t>(_mm_movemask_ps(_mm_cmple_ps(distanceSquared, _mm_loadu_ps(&lights.radiusSquared[first]))));
+#else
+	uint32_t mask = 0;
+	for (size_t i = 0; i < 4; i++) {
+		glm::vec3 centre{lights.x[first + i], lights.y[first + i], lights.z[first + i]};
+		glm::vec3 distance = glm::max(glm::max(clusterMin - centre, centre - clusterMax), glm::vec3{0.0f});
+		if (glm::dot(distance, distance) <= lights.radiusSquared[first + i])
+			mask |= 1u << i;
+	}
+	return mask;
+#endif
+}
+
+void CLightClusters::SetUniforms(FrameUniforms& frame, int viewportWidth, int viewportHeight) const
+{
+	frame.clusterScale = glm::vec4{static_cast<float>(GRID_X) / std::max(viewportWidth, 1), static_cast<float>(GRID_Y) / std::max(viewportHeight, 1),
+								   m_sliceScale, m_sliceBias};
+	frame.clusterCount = glm::uvec4{GRID_X, GRID_Y, GRID_Z, GetLightCount()};
+}
+
+void CLightClusters::Record(CRenderCommandBuffer& commands, int firstTextureUnit) const
+{
+	commands.UpdateBuffer(m_buffers[GRID], CAPACITIES[GRID], m_grid.data(), m_grid.size() * sizeof(glm::uvec2));
+	if (!m_indices.empty())
+		commands.UpdateBuffer(m_buffers[INDICES], CAPACITIES[INDICES], m_indices.data(), m_indices.size() * sizeof(uint16_t));
+	if (!m_lightData.empty())
+		commands.UpdateBuffer(m_buffers[LIGHTS], CAPACITIES[LIGHTS], m_lightData.data(), m_lightData.size() * sizeof(glm::vec4));
+
+	for (int i = 0; i < BUFFER_COUNT; i++)
+		commands.BindTexture(TextureTarget::Buffer, firstTextureUnit + i, m_textures[i], 0);
+}
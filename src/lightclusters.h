@@ -0,0 +1,85 @@
+#pragma once
+
+#include "rendercommandbuffer.h"
+
+// A point light whose influence falls off to nothing at its radius
+struct PointLight
+{
+	glm::vec3 position;		// In world coordinates
+	float radius;
+	glm::vec3 colour;
+};
+
+// Clustered forward lighting.  The view frustum is split into a grid of clusters, screen tiles by exponentially
+// spaced depth slices, and each cluster gets the list of point lights reaching into it.  Fragments find their
+// cluster from their window position and depth and only loop over its lights, see lighting.glsl.
+// Lights are assigned on the CPU: one depth slice per job, testing a cluster against four lights at a time with SSE.
+// The lists go to the GPU through buffer textures, since GLSL 4.00 has no storage buffers.
+class CLightClusters
+{
+public:
+	static const uint32_t GRID_X = 16;
+	static const uint32_t GRID_Y = 9;
+	static const uint32_t GRID_Z = 24;
+	static const uint32_t CLUSTER_COUNT = GRID_X * GRID_Y * GRID_Z;
+	static const uint32_t MAX_LIGHTS = 1024;				// Lights beyond this are ignored
+	static const uint32_t MAX_LIGHT_INDICES = 128 * 1024;	// Entries of all clusters' lists together
+
+	CLightClusters();
+	~CLightClusters();
+
+	// Creates the buffers and textures, on the thread that owns the GL context
+	void Create();
+	void Release();
+
+	// Sorts the lights into the clusters of the view, spreading the work over the job system
+	void Assign(const std::vector<PointLight>& lights, const glm::mat4& viewMatrix, const glm::mat4& projMatrix);
+	// Fills in how the shader finds the cluster of a fragment
+	void SetUniforms(FrameUniforms& frame, int viewportWidth, int viewportHeight) const;
+	// Records uploading the lists and binding them to three texture units from firstTextureUnit on, in the order
+	// clusterGrid, clusterLightIndices, clusterLights
+	void Record(CRenderCommandBuffer& commands, int firstTextureUnit) const;
+
+	uint32_t GetLightCount() const { return static_cast<uint32_t>(m_lightData.size() / 2); }
+	uint32_t GetIndexCount() const { return static_cast<uint32_t>(m_indices.size()); }
+
+private:
+	enum { GRID, INDICES, LIGHTS, BUFFER_COUNT };
+
+	// The lights that reach into a depth slice, in eye coordinates and laid out for the SIMD test.  The arrays are
+	// padded to a multiple of four with lights that can't pass.
+	struct SliceLights
+	{
+		std::vector<float> x, y, z, radiusSquared;
+		std::vector<uint16_t> index;
+		std::vector<uint16_t> clusterIndices;	// Lists of the slice's clusters, one after the other
+	};
+
+	GLuint m_buffers[BUFFER_COUNT];
+	GLuint m_textures[BUFFER_COUNT];
+
+	// Cluster bounds in eye coordinates, rebuilt when the projection changes
+	glm::mat4 m_projMatrix;
+	float m_zNear;
+	float m_zFar;
+	float m_sliceScale;			// Depth slice of a distance d from the eye is log(d) * scale + bias
+	float m_sliceBias;
+	std::vector<glm::vec3> m_clusterMin;
+	std::vector<glm::vec3> m_clusterMax;
+
+	// Results of the last Assign, as uploaded
+	std::vector<glm::uvec2> m_grid;			// Per cluster: offset into m_indices, number of lights
+	std::vector<uint16_t> m_indices;
+	std::vector<glm::vec4> m_lightData;		// Per light: eye position and radius, then colour
+
+	std::vector<glm::vec4> m_eyeLights;		// Eye position and radius of the lights being assigned
+	std::vector<glm::ivec2> m_lightSlices;	// First and last depth slice each light reaches into, empty if first > last
+	SliceLights m_slices[GRID_Z];
+	bool m_reportedLightOverflow;		// Each overflow is reported once, the first time it happens
+	bool m_reportedIndexOverflow;
+
+	void BuildClusterBounds(const glm::mat4& projMatrix);
+	void AssignSlice(uint32_t slice);
+	int GetSlice(float depth) const;
+	static uint32_t TestLights(const glm::vec3& clusterMin, const glm::vec3& clusterMax, const SliceLights& lights, size_t first);
+};
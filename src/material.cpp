@@ -0,0 +1,103 @@
+#include "material.h"
+#include "glstatecache.h"
+
+#include <assimp/scene.h>
+
+// OBJ exporters usually write a black ambient colour, and the diffuse colour next to a texture is often just what
+// the modelling tool showed.  The texture supplies the colour in that case and the ambient follows the diffuse.
+Material Material::FromAssimp(const aiMaterial& material, bool hasDiffuseTexture)
+{
+	aiColor3D ambient(0.0f, 0.0f, 0.0f);
+	aiColor3D diffuse(1.0f, 1.0f, 1.0f);
+	aiColor3D specular(0.0f, 0.0f, 0.0f);
+	float shininess = 0.0f;
+	material.Get(AI_MATKEY_COLOR_AMBIENT, ambient);
+	material.Get(AI_MATKEY_COLOR_DIFFUSE, diffuse);
+	material.Get(AI_MATKEY_COLOR_SPECULAR, specular);
+	material.Get(AI_MATKEY_SHININESS, shininess);
+
+	Material result;
+	result.diffuse = hasDiffuseTexture ? glm::vec3{1.0f} : glm::vec3{diffuse.r, diffuse.g, diffuse.b};
+	result.ambient = glm::vec3{ambient.r, ambient.g, ambient.b};
+	if (result.ambient == glm::vec3{0.0f})
+		result.ambient = result.diffuse * 0.5f;
+	result.specular = glm::vec3{specular.r, specular.g, specular.b};
+	result.shininess = shininess;
+	return result;
+}
+
+uint32_t Material::GetTextureMask() const
+{
+	uint32_t mask = 0;
+	for (size_t i = 0; i < std::size(textures); i++) {
+		if (textures[i] != nullptr)
+			mask |= 1u << i;
+	}
+	return mask;
+}
+
+CMaterialTable::CMaterialTable()
+{
+	m_buffer = 0;
+	m_uploadedCount = 0;
+	m_materials.reserve(MAX_MATERIALS);
+	m_materials.emplace_back();
+}
+
+CMaterialTable::~CMaterialTable()
+{
+	Release();
+}
+
+uint32_t CMaterialTable::Add(const Material& material)
+{
+	if (m_materials.size() >= MAX_MATERIALS) {
+		std::cerr << "Error! The material table is full, using the default material" << std::endl;
+		return DEFAULT_MATERIAL;
+	}
+
+	m_materials.push_back(material);
+	return static_cast<uint32_t>(m_materials.size() - 1);
+}
+
+void CMaterialTable::Upload()
+{
+	if (m_buffer == 0) {
+		glGenBuffers(1, &m_buffer);
+		glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+		glBufferData(GL_UNIFORM_BUFFER, static_cast<GLsizeiptr>(GetBufferSize()), nullptr, GL_STATIC_DRAW);
+		m_uploadedCount = 0;
+	}
+
+	if (m_uploadedCount == m_materials.size())
+		return;
+
+	std::vector<MaterialUniforms> uniforms;
+	uniforms.reserve(m_materials.size() - m_uploadedCount);
+	for (size_t i = m_uploadedCount; i < m_materials.size(); i++) {
+		const Material& material = m_materials[i];
+		MaterialUniforms& entry = uniforms.emplace_back();
+		entry = {};
+		entry.Ma = material.ambient;
+		entry.Md = material.diffuse;
+		entry.Ms = material.specular;
+		entry.shininess = material.shininess;
+		entry.textures = material.GetTextureMask();
+	}
+
+	glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+	glBufferSubData(GL_UNIFORM_BUFFER, static_cast<GLintptr>(m_uploadedCount * sizeof(MaterialUniforms)),
+					static_cast<GLsizeiptr>(uniforms.size() * sizeof(MaterialUniforms)), uniforms.data());
+	m_uploadedCount = static_cast<uint32_t>(m_materials.size());
+}
+
+void CMaterialTable::Release()
+{
+	if (m_buffer == 0)
+		return;
+
+	CGLStateCache::Get().ForgetBuffer(m_buffer);
+	glDeleteBuffers(1, &m_buffer);
+	m_buffer = 0;
+	m_uploadedCount = 0;
+}
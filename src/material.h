@@ -0,0 +1,60 @@
+#pragma once
+
+#include "uniforms.h"
+
+class CTexture;
+struct aiMaterial;
+
+// Texture slots of a material.  The main shader only samples the diffuse texture, the others are loaded and flagged
+// in the material table for shaders that can use them.
+enum class MaterialTexture : uint32_t { Diffuse, Normal, Specular, Count };
+
+// Surface properties used by the lighting model, either set up by hand or built from an imported material.  The
+// textures are owned by whoever loaded them, e.g. the mesh.
+struct Material
+{
+	glm::vec3 ambient{1.0f};		// Ambient reflectance
+	glm::vec3 diffuse{0.0f};		// Diffuse reflectance
+	glm::vec3 specular{0.0f};		// Specular reflectance
+	float shininess = 15.0f;
+	const CTexture* textures[static_cast<size_t>(MaterialTexture::Count)] = {};
+
+	const CTexture* GetTexture(MaterialTexture slot) const { return textures[static_cast<size_t>(slot)]; }
+	void SetTexture(MaterialTexture slot, const CTexture* pTexture) { textures[static_cast<size_t>(slot)] = pTexture; }
+	// Bit per slot that has a texture
+	uint32_t GetTextureMask() const;
+
+	// Reads the colours and shininess of an Assimp material, the textures are left to the caller
+	static Material FromAssimp(const aiMaterial& material, bool hasDiffuseTexture);
+};
+
+// All materials live in one uniform buffer and each draw picks its own by index, so changing material between draws
+// doesn't change any GL state.  GLSL 4.00 has no storage buffers, so the table is a fixed size uniform block, which
+// GL guarantees up to 16 KB of, exactly MAX_MATERIALS entries.
+class CMaterialTable
+{
+public:
+	static const uint32_t MAX_MATERIALS = 256;		// Must match MAX_MATERIALS in common.glsl
+	static const uint32_t DEFAULT_MATERIAL = 0;	// Full ambient reflectance only, added by the constructor
+
+	CMaterialTable();
+	~CMaterialTable();
+
+	// Returns the material's index, or DEFAULT_MATERIAL if the table is full
+	uint32_t Add(const Material& material);
+	const Material& Get(uint32_t index) const { return m_materials[index]; }
+	uint32_t GetCount() const { return static_cast<uint32_t>(m_materials.size()); }
+
+	// Copies the materials added since the last call into the buffer.  Must be called on the thread that owns the GL
+	// context, before the buffer is drawn with.
+	void Upload();
+	void Release();
+
+	GLuint GetBuffer() const { return m_buffer; }
+	static size_t GetBufferSize() { return MAX_MATERIALS * sizeof(MaterialUniforms); }
+
+private:
+	std::vector<Material> m_materials;
+	GLuint m_buffer;
+	uint32_t m_uploadedCount;
+};
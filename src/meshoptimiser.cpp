@@ -0,0 +1,321 @@
+#include "meshoptimiser.h"
+
+CMeshOptimiser::Report CMeshOptimiser::Optimise(CVertexBuilder<Vertex>& geometry)
+{
+	Report report;
+	std::vector<uint32_t>& indices = geometry.GetIndices();
+	report.before = AnalyseVertexCache(indices, static_cast<uint32_t>(geometry.GetVertices().size()));
+
+	std::vector<uint32_t> remap;
+	uint32_t vertexCount = GenerateWeldRemap(geometry.GetVertices(), remap);
+	Remap(geometry, remap, vertexCount);
+
+	OptimiseVertexCache(indices, vertexCount);
+	OptimiseOverdraw(indices, geometry.GetVertices());
+
+	vertexCount = GenerateFetchRemap(indices, vertexCount, remap);
+	Remap(geometry, remap, vertexCount);
+
+	report.after = AnalyseVertexCache(indices, vertexCount);
+	return report;
+}
+
+// Moves the vertices to their new places and renames the indices to match
+void CMeshOptimiser::Remap(CVertexBuilder<Vertex>& geometry, const std::vector<uint32_t>& remap, uint32_t vertexCount)
+{
+	std::vector<Vertex>& vertices = geometry.GetVertices();
+	std::vector<Vertex> remapped(vertexCount);
+	for (size_t i = 0; i < vertices.size(); i++) {
+		if (remap[i] != ~0u)
+			remapped[remap[i]] = vertices[i];
+	}
+	vertices.swap(remapped);
+
+	for (uint32_t& index : geometry.GetIndices())
+		index = remap[index];
+}
+
+// Vertices are equal if all their components are, so only exact duplicates are merged.  Importers split vertices per
+// face, which makes a cache order useless until the copies are joined again.
+uint32_t CMeshOptimiser::GenerateWeldRemap(const std::vector<Vertex>& vertices, std::vector<uint32_t>& remap)
+{
+	static_assert(sizeof(Vertex) == 8 * sizeof(float), "Vertex should be eight floats");
+
+	struct Hash
+	{
+		const std::vector<Vertex>* pVertices;
+		size_t operator()(uint32_t index) const
+		{
+			// 64-bit FNV-1a of the components' bits.  Adding zero turns -0 into 0, which compare equal.
+			const auto* components = reinterpret_cast<const float*>(&(*pVertices)[index]);
+			uint64_t hash = 14695981039346656037ull;
+			for (size_t i = 0; i < sizeof(Vertex) / sizeof(float); i++) {
+				uint32_t bits;
+				const float component = components[i] + 0.0f;
+				std::memcpy(&bits, &component, sizeof(bits));
+				for (int byte = 0; byte < 4; byte++)
+					hash = (hash ^ ((bits >> (byte * 8)) & 0xFF)) * 1099511628211ull;
+			}
+			return static_cast<size_t>(hash);
+		}
+	};
+	struct Equal
+	{
+		const std::vector<Vertex>* pVertices;
+		bool operator()(uint32_t a, uint32_t b) const
+		{
+			const Vertex& va = (*pVertices)[a];
+			const Vertex& vb = (*pVertices)[b];
+			return va.m_pos == vb.m_pos && va.m_tex == vb.m_tex && va.m_normal == vb.m_normal;
+		}
+	};
+
+	std::unordered_map<uint32_t, uint32_t, Hash, Equal> unique(vertices.size(), Hash{&vertices}, Equal{&vertices});
+	remap.resize(vertices.size());
+	uint32_t vertexCount = 0;
+	for (uint32_t i = 0; i < vertices.size(); i++) {
+		auto [it, inserted] = unique.try_emplace(i, vertexCount);
+		remap[i] = it->second;
+		if (inserted)
+			vertexCount++;
+	}
+	return vertexCount;
+}
+
+// Tom Forsyth's linear-speed vertex cache optimisation.  Triangles are emitted greedily by a score that favours
+// vertices recently used, kept in a simulated LRU cache, and vertices with few triangles left so none are stranded.
+void CMeshOptimiser::OptimiseVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount)
+{
+	static const int SCORE_CACHE_SIZE = 32;
+	static const float CACHE_DECAY_POWER = 1.5f;
+	static const float LAST_TRIANGLE_SCORE = 0.75f;
+	static const float VALENCE_BOOST_SCALE = 2.0f;
+	static const float VALENCE_BOOST_POWER = 0.5f;
+
+	const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+	if (triangleCount == 0)
+		return;
+
+	// Triangles using each vertex, the still unemitted ones first
+	std::vector<uint32_t> firstTriangle(vertexCount + 1, 0);
+	for (uint32_t index : indices)
+		firstTriangle[index + 1]++;
+	for (uint32_t v = 0; v < vertexCount; v++)
+		firstTriangle[v + 1] += firstTriangle[v];
+	std::vector<uint32_t> remaining(vertexCount);
+	for (uint32_t v = 0; v < vertexCount; v++)
+		remaining[v] = firstTriangle[v + 1] - firstTriangle[v];
+	std::vector<uint32_t> adjacency(indices.size());
+	std::vector<uint32_t> filled(vertexCount, 0);
+	for (uint32_t t = 0; t < triangleCount; t++) {
+		for (int k = 0; k < 3; k++) {
+			uint32_t v = indices[t * 3 + k];
+			adjacency[firstTriangle[v] + filled[v]++] = t;
+		}
+	}
+
+	std::vector<int> cachePosition(vertexCount, -1);
+	auto vertexScore = [&](uint32_t v) {
+		if (remaining[v] == 0)
+			return -1.0f;
+		float score = 0.0f;
+		int position = cachePosition[v];
+		if (position >= 0) {
+			// The last triangle's vertices get a fixed score, so the next triangle doesn't reuse all three of them
+			if (position < 3)
+				score = LAST_TRIANGLE_SCORE;
+			else
+				score = std::pow(1.0f - float(position - 3) / float(SCORE_CACHE_SIZE - 3), CACHE_DECAY_POWER);
+		}
+		return score + VALENCE_BOOST_SCALE * std::pow(float(remaining[v]), -VALENCE_BOOST_POWER);
+	};
+
+	std::vector<float> vertexScores(vertexCount);
+	for (uint32_t v = 0; v < vertexCount; v++)
+		vertexScores[v] = vertexScore(v);
+	std::vector<float> triangleScores(triangleCount);
+	for (uint32_t t = 0; t < triangleCount; t++)
+		triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<uint32_t> output;
+	output.reserve(indices.size());
+
+	uint32_t cache[SCORE_CACHE_SIZE + 3];
+	int cacheCount = 0;
+	uint32_t scanCursor = 0;
+	int64_t best = -1;
+
+	for (uint32_t emittedCount = 0; emittedCount < triangleCount; emittedCount++) {
+		// Nothing in the cache has triangles left, start again from the next triangle not emitted
+		if (best < 0) {
+			while (emitted[scanCursor])
+				scanCursor++;
+			best = scanCursor;
+		}
+
+		const auto triangle = static_cast<uint32_t>(best);
+		emitted[triangle] = true;
+		const uint32_t* corners = &indices[triangle * 3];
+		output.insert(output.end(), corners, corners + 3);
+
+		// Take the triangle out of its vertices' lists of triangles left
+		for (int k = 0; k < 3; k++) {
+			uint32_t v = corners[k];
+			uint32_t* begin = &adjacency[firstTriangle[v]];
+			uint32_t* end = begin + remaining[v];
+			*std::find(begin, end, triangle) = *(end - 1);
+			remaining[v]--;
+		}
+
+		// The triangle's vertices move to the front of the cache, the rest keep their order behind them
+		uint32_t newCache[SCORE_CACHE_SIZE + 3];
+		int newCount = 0;
+		for (int k = 0; k < 3; k++)
+			newCache[newCount++] = corners[k];
+		for (int i = 0; i < cacheCount; i++) {
+			uint32_t v = cache[i];
+			if (v != corners[0] && v != corners[1] && v != corners[2])
+				newCache[newCount++] = v;
+		}
+
+		// Everything that was or is in the cache may have a new score, and so may its triangles
+		for (int i = 0; i < newCount; i++)
+			cachePosition[newCache[i]] = i < SCORE_CACHE_SIZE ? i : -1;
+		float bestScore = -1.0f;
+		best = -1;
+		for (int i = 0; i < newCount; i++) {
+			uint32_t v = newCache[i];
+			float score = vertexScore(v);
+			float change = score - vertexScores[v];
+			vertexScores[v] = score;
+
+			const uint32_t* begin = &adjacency[firstTriangle[v]];
+			for (const uint32_t* t = begin; t != begin + remaining[v]; t++) {
+				triangleScores[*t] += change;
+				if (triangleScores[*t] > bestScore) {
+					bestScore = triangleScores[*t];
+					best = *t;
+				}
+			}
+		}
+
+		cacheCount = std::min(newCount, SCORE_CACHE_SIZE);
+		std::copy(newCache, newCache + cacheCount, cache);
+	}
+
+	indices.swap(output);
+}
+
+// Splits the cache ordered triangles into clusters where the cache starts cold anyway, then draws the clusters facing
+// out from the mesh's centre first.  Those are most likely to hide the rest from any view, and as the splits are at
+// full cache misses the cache order inside each cluster is kept.
+void CMeshOptimiser::OptimiseOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices)
+{
+	const size_t triangleCount = indices.size() / 3;
+	if (triangleCount < 2)
+		return;
+
+	// A triangle missing the cache with all three vertices starts a cluster
+	std::vector<uint32_t> clusterStarts;
+	std::vector<uint32_t> timestamps(vertices.size(), 0);
+	uint32_t time = CACHE_SIZE + 1;
+	for (size_t t = 0; t < triangleCount; t++) {
+		int misses = 0;
+		for (int k = 0; k < 3; k++) {
+			uint32_t v = indices[t * 3 + k];
+			if (time - timestamps[v] > CACHE_SIZE) {
+				timestamps[v] = time++;
+				misses++;
+			}
+		}
+		if (misses == 3 || t == 0)
+			clusterStarts.push_back(static_cast<uint32_t>(t));
+	}
+	if (clusterStarts.size() < 2)
+		return;
+
+	// The centre of the mesh, weighted by area so dense patches don't pull it over
+	glm::vec3 meshCentroid{0.0f};
+	float meshArea = 0.0f;
+	for (size_t t = 0; t < triangleCount; t++) {
+		const glm::vec3& a = vertices[indices[t * 3]].m_pos;
+		const glm::vec3& b = vertices[indices[t * 3 + 1]].m_pos;
+		const glm::vec3& c = vertices[indices[t * 3 + 2]].m_pos;
+		float area = glm::length(glm::cross(b - a, c - a));
+		meshCentroid += (a + b + c) * (area / 3.0f);
+		meshArea += area;
+	}
+	if (meshArea > 0.0f)
+		meshCentroid /= meshArea;
+
+	struct Cluster
+	{
+		uint32_t begin;
+		uint32_t end;
+		float sortKey;
+	};
+	std::vector<Cluster> clusters(clusterStarts.size());
+	for (size_t i = 0; i < clusters.size(); i++) {
+		Cluster& cluster = clusters[i];
+		cluster.begin = clusterStarts[i];
+		cluster.end = i + 1 < clusterStarts.size() ? clusterStarts[i + 1] : static_cast<uint32_t>(triangleCount);
+
+		// The length of the summed cross products is twice the area, their direction the average normal
+		glm::vec3 centroid{0.0f};
+		glm::vec3 normal{0.0f};
+		float area = 0.0f;
+		for (uint32_t t = cluster.begin; t < cluster.end; t++) {
+			const glm::vec3& a = vertices[indices[t * 3]].m_pos;
+			const glm::vec3& b = vertices[indices[t * 3 + 1]].m_pos;
+			const glm::vec3& c = vertices[indices[t * 3 + 2]].m_pos;
+			glm::vec3 cross = glm::cross(b - a, c - a);
+			float triangleArea = glm::length(cross);
+			centroid += (a + b + c) * (triangleArea / 3.0f);
+			normal += cross;
+			area += triangleArea;
+		}
+		if (area > 0.0f)
+			centroid /= area;
+		float normalLength = glm::length(normal);
+		cluster.sortKey = normalLength > 0.0f ? glm::dot(centroid - meshCentroid, normal / normalLength) : 0.0f;
+	}
+
+	std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b) { return a.sortKey > b.sortKey; });
+
+	std::vector<uint32_t> output;
+	output.reserve(indices.size());
+	for (const Cluster& cluster : clusters)
+		output.insert(output.end(), indices.begin() + cluster.begin * 3, indices.begin() + cluster.end * 3);
+	indices.swap(output);
+}
+
+// Numbers the vertices in the order the triangles first use them
+uint32_t CMeshOptimiser::GenerateFetchRemap(const std::vector<uint32_t>& indices, uint32_t vertexCount, std::vector<uint32_t>& remap)
+{
+	remap.assign(vertexCount, ~0u);
+	uint32_t next = 0;
+	for (uint32_t index : indices) {
+		if (remap[index] == ~0u)
+			remap[index] = next++;
+	}
+	return next;
+}
+
+VertexCacheStats CMeshOptimiser::AnalyseVertexCache(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize)
+{
+	VertexCacheStats stats;
+	stats.triangles = static_cast<uint32_t>(indices.size() / 3);
+	stats.vertices = vertexCount;
+
+	// A vertex is in the FIFO while fewer than cacheSize misses have happened since it was loaded
+	std::vector<uint32_t> timestamps(vertexCount, 0);
+	uint32_t time = cacheSize + 1;
+	for (uint32_t index : indices) {
+		if (time - timestamps[index] > cacheSize) {
+			timestamps[index] = time++;
+			stats.misses++;
+		}
+	}
+	return stats;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "vertexbuilder.h"
+
+// How well an index order uses the post-transform vertex cache, simulated as a FIFO
+struct VertexCacheStats
+{
+	uint32_t misses = 0;		// Vertices shaded
+	uint32_t triangles = 0;
+	uint32_t vertices = 0;		// Vertices in the mesh
+
+	// Average cache miss ratio: vertices shaded per triangle, 0.5 at best for a large regular mesh and 3 at worst
+	float GetACMR() const { return triangles > 0 ? float(misses) / float(triangles) : 0.0f; }
+	// Average transformed vertex ratio: times each vertex is shaded, 1 at best
+	float GetATVR() const { return vertices > 0 ? float(misses) / float(vertices) : 0.0f; }
+
+	VertexCacheStats& operator+=(const VertexCacheStats& other)
+	{
+		misses += other.misses;
+		triangles += other.triangles;
+		vertices += other.vertices;
+		return *this;
+	}
+};
+
+// Prepares imported triangle lists for drawing: welds duplicate vertices, orders triangles for the vertex cache and
+// then for less overdraw, and orders vertices by first use so fetches stay local.  Nothing here touches GL, so
+// meshes can be optimised on the job system.
+class CMeshOptimiser
+{
+public:
+	static const uint32_t CACHE_SIZE = 16;		// FIFO entries assumed when measuring
+
+	struct Report
+	{
+		VertexCacheStats before;
+		VertexCacheStats after;
+	};
+
+	// Runs every stage on the geometry and measures it before and after
+	static Report Optimise(CVertexBuilder<Vertex>& geometry);
+
+	// The stages, in the order Optimise runs them.  The remaps map old vertex indices to new ones, ~0u for vertices
+	// no triangle uses, and return the new vertex count.
+	static uint32_t GenerateWeldRemap(const std::vector<Vertex>& vertices, std::vector<uint32_t>& remap);
+	static void OptimiseVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount);
+	static void OptimiseOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices);
+	static uint32_t GenerateFetchRemap(const std::vector<uint32_t>& indices, uint32_t vertexCount, std::vector<uint32_t>& remap);
+
+	static VertexCacheStats AnalyseVertexCache(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize = CACHE_SIZE);
+
+private:
+	static void Remap(CVertexBuilder<Vertex>& geometry, const std::vector<uint32_t>& remap, uint32_t vertexCount);
+};
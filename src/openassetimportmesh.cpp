@@ -17,38 +17,18 @@
 */
 
 #include "openassetimportmesh.h"
+#include "image.h"
+#include "jobsystem.h"
+#include "material.h"
+#include "renderqueue.h"
+#include "trace.h"
+#include "vertexcompressor.h"
 
 COpenAssetImportMesh::MeshEntry::MeshEntry()
 {
-    vbo = INVALID_OGL_VALUE;
-    ibo = INVALID_OGL_VALUE;
-    NumIndices  = 0;
     MaterialIndex = INVALID_MATERIAL;
 };
 
-COpenAssetImportMesh::MeshEntry::~MeshEntry()
-{
-    if (vbo != INVALID_OGL_VALUE)
-        glDeleteBuffers(1, &vbo);
-
-    if (ibo != INVALID_OGL_VALUE)
-        glDeleteBuffers(1, &ibo);
-}
-
-void COpenAssetImportMesh::MeshEntry::Init(const std::vector<Vertex>& Vertices,
-                          const std::vector<uint32_t>& Indices)
-{
-    NumIndices = int(Indices.size());
-
-	glGenBuffers(1, &vbo);
-  	glBindBuffer(GL_ARRAY_BUFFER, vbo);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * Vertices.size(), Vertices.data(), GL_STATIC_DRAW);
-
-    glGenBuffers(1, &ibo);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(uint32_t) * NumIndices, Indices.data(), GL_STATIC_DRAW);
-}
-
 COpenAssetImportMesh::COpenAssetImportMesh()
 {
 }
@@ -63,13 +43,28 @@ void COpenAssetImportMesh::Clear()
     for (auto& m_Texture : m_Textures) {
         SAFE_DELETE(m_Texture);
     }
-	glDeleteVertexArrays(1, &m_vao);
+    for (auto& m_Texture : m_MapTextures) {
+        SAFE_DELETE(m_Texture);
+    }
+    m_MapTextures.clear();
+    SAFE_DELETE(m_pDefaultTexture);
+
+    if (m_pGeometry != nullptr) {
+        for (auto& entry : m_Entries) {
+            m_pGeometry->Remove(entry.Geometry);
+        }
+    }
+    m_Entries.clear();
+    m_positionTransform = glm::mat4(1.0f);
 }
 
-bool COpenAssetImportMesh::Load(const std::filesystem::path& path)
+bool COpenAssetImportMesh::Load(const std::filesystem::path& path, CGeometryArena& geometry, CMaterialTable* pMaterials)
 {
+    TRACE_SCOPE("COpenAssetImportMesh::Load");
+
     // Release the previously loaded mesh (if it exists)
     Clear();
+    m_pGeometry = &geometry;
     
     bool Ret = false;
     Assimp::Importer Importer;
@@ -79,7 +74,7 @@ bool COpenAssetImportMesh::Load(const std::filesystem::path& path)
     m_directory = path.parent_path();
 
     if (pScene) {
-        Ret = InitFromScene(pScene);
+        Ret = InitFromScene(path, pScene, pMaterials);
     }
     else {
         std::cerr << "Error loading mesh model: " << Importer.GetErrorString() << std::endl;
@@ -88,29 +83,74 @@ bool COpenAssetImportMesh::Load(const std::filesystem::path& path)
     return Ret;
 }
 
-bool COpenAssetImportMesh::InitFromScene(const aiScene* pScene)
+bool COpenAssetImportMesh::InitFromScene(const std::filesystem::path& path, const aiScene* pScene, CMaterialTable* pMaterials)
 {  
     m_Entries.resize(pScene->mNumMeshes);
     m_Textures.resize(pScene->mNumMaterials);
+    m_Materials.resize(pScene->mNumMaterials);
+
+    // Build the vertex and index data of all meshes in parallel, then copy them into the arena here where the GL
+    // context is current
+    auto NumMeshes = static_cast<uint32_t>(m_Entries.size());
+    std::vector<CVertexBuilder<Vertex>> Geometry(NumMeshes);
+    std::vector<CMeshOptimiser::Report> Reports(NumMeshes);
+
+    JobSystem::GetInstance().ParallelFor(NumMeshes, 1, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin ; i < end ; i++) {
+            Reports[i] = InitMesh(i, pScene->mMeshes[i], Geometry[i]);
+        }
+    });
+
+    if (m_pGeometry->GetVertexFormat() == VertexFormat::Compact) {
+        // All meshes are quantised against the bounds of the whole scene, so they share one position transform
+        glm::vec3 Minimum, Maximum;
+        CVertexCompressor::MakeEmptyBounds(Minimum, Maximum);
+        for (const auto& MeshGeometry : Geometry) {
+            CVertexCompressor::ExpandBounds(MeshGeometry.GetVertices(), Minimum, Maximum);
+        }
+        const CVertexCompressor::Quantisation Quantisation = CVertexCompressor::Quantise(Minimum, Maximum);
+        m_positionTransform = Quantisation.GetTransform();
 
-	glGenVertexArrays(1, &m_vao); 
-	glBindVertexArray(m_vao);
+        std::vector<CVertexBuilder<CompactVertex>> Compressed(NumMeshes);
+        JobSystem::GetInstance().ParallelFor(NumMeshes, 1, [&](uint32_t begin, uint32_t end) {
+            for (uint32_t i = begin ; i < end ; i++) {
+                CVertexCompressor::Compress(Geometry[i], Quantisation, Compressed[i]);
+            }
+        });
+        for (uint32_t i = 0 ; i < NumMeshes ; i++) {
+            m_Entries[i].Geometry = m_pGeometry->Add(Compressed[i]);
+        }
+    }
+    else {
+        for (uint32_t i = 0 ; i < NumMeshes ; i++) {
+            m_Entries[i].Geometry = m_pGeometry->Add(Geometry[i]);
+        }
+    }
 
-    // Initialize the meshes in the scene one by one
-    for (uint32_t i = 0 ; i < m_Entries.size() ; i++) {
-        const aiMesh* paiMesh = pScene->mMeshes[i];
-        InitMesh(i, paiMesh);
+    CMeshOptimiser::Report Total;
+    for (const auto& Report : Reports) {
+        Total.before += Report.before;
+        Total.after += Report.after;
     }
 
-    return InitMaterials(pScene);
+    // Formatted on its own stream so std::cout keeps its precision
+    std::ostringstream Message;
+    Message << std::fixed << std::setprecision(2) << "Optimised " << path.filename().string() << ": "
+            << Total.before.vertices << " -> " << Total.after.vertices << " vertices, ACMR "
+            << Total.before.GetACMR() << " -> " << Total.after.GetACMR() << ", ATVR "
+            << Total.before.GetATVR() << " -> " << Total.after.GetATVR();
+    std::cout << Message.str() << std::endl;
+
+    return InitMaterials(pScene, pMaterials);
 }
 
-void COpenAssetImportMesh::InitMesh(uint32_t Index, const aiMesh* paiMesh)
+// Converts an Assimp mesh into vertex and index data and optimises it.  Runs on the job system, so it must not
+// touch GL.
+CMeshOptimiser::Report COpenAssetImportMesh::InitMesh(uint32_t Index, const aiMesh* paiMesh, CVertexBuilder<Vertex>& Geometry)
 {
     m_Entries[Index].MaterialIndex = paiMesh->mMaterialIndex;
-    
-    std::vector<Vertex> Vertices;
-    std::vector<uint32_t> Indices;
+
+    Geometry.Reserve(paiMesh->mNumVertices, paiMesh->mNumFaces * 3);
 
     const aiVector3D Zero3D(0.0f, 0.0f, 0.0f);
 
@@ -119,98 +159,135 @@ void COpenAssetImportMesh::InitMesh(uint32_t Index, const aiMesh* paiMesh)
         const aiVector3D& normal   = paiMesh->mNormals[i];
         const aiVector3D& texCoord = paiMesh->HasTextureCoords(0) ? paiMesh->mTextureCoords[0][i] : Zero3D;
 
-        Vertices.emplace_back(
+        Geometry.AddVertex({
                 glm::vec3{pos.x, pos.y, pos.z},
                 glm::vec2{texCoord.x, 1.0f-texCoord.y},
                 glm::vec3{normal.x, normal.y, normal.z}
-        );
+        });
     }
 
     for (uint32_t i = 0 ; i < paiMesh->mNumFaces ; i++) {
         const aiFace& Face = paiMesh->mFaces[i];
         assert(Face.mNumIndices == 3);
-        Indices.push_back(Face.mIndices[0]);
-        Indices.push_back(Face.mIndices[1]);
-        Indices.push_back(Face.mIndices[2]);
+        Geometry.AddTriangle(Face.mIndices[0], Face.mIndices[1], Face.mIndices[2]);
     }
 
-    m_Entries[Index].Init(Vertices, Indices);
+    return CMeshOptimiser::Optimise(Geometry);
+}
+
+// A single white texel, for drawing with the diffuse colour of the material only
+CTexture* COpenAssetImportMesh::CreateWhiteTexture()
+{
+    auto* pTexture = new CTexture();
+    uint8_t data[3] = {255, 255, 255};
+    pTexture->CreateFromData(data, 1, 1, 3, GL_RGB8, GL_RGB, false);
+    return pTexture;
+}
+
+// Returns the path of the material's first texture of the type, empty if it has none
+static std::filesystem::path FindTexture(const aiMaterial* pMaterial, aiTextureType Type, const std::filesystem::path& Directory)
+{
+    aiString str;
+    if (pMaterial->GetTextureCount(Type) == 0 || pMaterial->GetTexture(Type, 0, &str) != AI_SUCCESS)
+        return {};
+    return Directory / str.C_Str();
 }
 
-bool COpenAssetImportMesh::InitMaterials(const aiScene* pScene)
+bool COpenAssetImportMesh::InitMaterials(const aiScene* pScene, CMaterialTable* pMaterials)
 {
     bool Ret = true;
 
-    // Initialize the materials
+    m_pDefaultTexture = CreateWhiteTexture();
+
+    // Find the texture of every slot of every material.  OBJ files give normal maps as bump maps, which Assimp
+    // reports as height maps.
+    const uint32_t NumSlots = static_cast<uint32_t>(MaterialTexture::Count);
+    const uint32_t NumPaths = pScene->mNumMaterials * NumSlots;
+    std::vector<std::filesystem::path> Paths(NumPaths);
     for (uint32_t i = 0 ; i < pScene->mNumMaterials ; i++) {
         const aiMaterial* pMaterial = pScene->mMaterials[i];
+        std::filesystem::path* MaterialPaths = &Paths[i * NumSlots];
+
+        MaterialPaths[static_cast<uint32_t>(MaterialTexture::Diffuse)] = FindTexture(pMaterial, aiTextureType_DIFFUSE, m_directory);
+        MaterialPaths[static_cast<uint32_t>(MaterialTexture::Specular)] = FindTexture(pMaterial, aiTextureType_SPECULAR, m_directory);
+        std::filesystem::path& Normal = MaterialPaths[static_cast<uint32_t>(MaterialTexture::Normal)];
+        Normal = FindTexture(pMaterial, aiTextureType_NORMALS, m_directory);
+        if (Normal.empty())
+            Normal = FindTexture(pMaterial, aiTextureType_HEIGHT, m_directory);
+    }
+
+    // Decode the images in parallel, the GL textures are created from them below
+    std::vector<std::unique_ptr<Image>> Images(NumPaths);
+    JobSystem::GetInstance().ParallelFor(NumPaths, 1, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin ; i < end ; i++) {
+            if (!Paths[i].empty())
+                Images[i] = std::make_unique<Image>(Paths[i].string());
+        }
+    });
+
+    // Creates the texture of one slot of a material, nullptr if it has none or it can't be loaded
+    auto CreateTexture = [&](uint32_t MaterialIndex, MaterialTexture Slot) -> CTexture* {
+        const uint32_t Index = MaterialIndex * NumSlots + static_cast<uint32_t>(Slot);
+        if (!Images[Index])
+            return nullptr;
+
+        auto* pTexture = new CTexture();
+        if (!pTexture->CreateFromImage(*Images[Index], true)) {
+            std::cerr << "Error loading mesh texture: " << Paths[Index] << std::endl;
+            delete pTexture;
+            Ret = false;
+            return nullptr;
+        }
+        std::cout << "Loaded texture: " << Paths[Index] << std::endl;
+        return pTexture;
+    };
 
-        m_Textures[i] = nullptr;
+    // Initialize the materials
+    for (uint32_t i = 0 ; i < pScene->mNumMaterials ; i++) {
+        const aiMaterial* pMaterial = pScene->mMaterials[i];
 
-        if (pMaterial->GetTextureCount(aiTextureType_DIFFUSE) > 0) {
-            aiString str;
+        m_Textures[i] = CreateTexture(i, MaterialTexture::Diffuse);
 
-            // TODO: Load all texture, not only the first one
-			if (pMaterial->GetTexture(aiTextureType_DIFFUSE, 0, &str) == AI_SUCCESS) {
-                std::filesystem::path path = m_directory;
-                path /= str.C_Str();
+        Material material = Material::FromAssimp(*pMaterial, m_Textures[i] != nullptr);
 
-                m_Textures[i] = new CTexture();
-                if (!m_Textures[i]->Load(path, true)) {
-                    std::cerr << "Error loading mesh texture: " << path << std::endl;
+        // Load a single white texel if no texture added, the diffuse colour comes from the material
+        if (!m_Textures[i]) {
+            m_Textures[i] = CreateWhiteTexture();
+        }
+        material.SetTexture(MaterialTexture::Diffuse, m_Textures[i]);
 
-                    delete m_Textures[i];
-                    m_Textures[i] = nullptr;
-                    Ret = false;
-                }
-                else {
-                    std::cout << "Loaded texture: " << path << std::endl;
-                }
+        for (MaterialTexture Slot : {MaterialTexture::Normal, MaterialTexture::Specular}) {
+            if (CTexture* pTexture = CreateTexture(i, Slot)) {
+                m_MapTextures.push_back(pTexture);
+                material.SetTexture(Slot, pTexture);
             }
         }
 
-        // Load a single colour texture matching the diffuse colour if no texture added
-        if (!m_Textures[i]) {
-		
-			aiColor3D color (0.f,0.f,0.f);
-			pMaterial->Get(AI_MATKEY_COLOR_DIFFUSE,color);
-
-			m_Textures[i] = new CTexture();
-			uint8_t data[3];
-			data[0] = (uint8_t) (color[2]*255);
-			data[1] = (uint8_t) (color[1]*255);
-			data[2] = (uint8_t) (color[0]*255);
-			m_Textures[i]->CreateFromData(data, 1, 1, 24, GL_BGR, false);
-        }
+        m_Materials[i] = pMaterials != nullptr ? pMaterials->Add(material) : CMaterialTable::DEFAULT_MATERIAL;
     }
 
     return Ret;
 }
 
-void COpenAssetImportMesh::Render()
+// Submits one packet per mesh entry, with its material and the material's texture
+void COpenAssetImportMesh::Submit(CRenderQueue& queue, const DrawPacket& packet)
 {
-	glBindVertexArray(m_vao);
+    DrawPacket draw = packet;
+    draw.primitive = PrimitiveType::Triangles;
 
     for (auto& entry : m_Entries) {
-		glEnableVertexAttribArray(0);
-		glEnableVertexAttribArray(1);
-		glEnableVertexAttribArray(2);
-        glBindBuffer(GL_ARRAY_BUFFER, entry.vbo);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const GLvoid*)offsetof(Vertex, m_pos));
-        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const GLvoid*)offsetof(Vertex, m_tex));
-        glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const GLvoid*)offsetof(Vertex, m_normal));
-
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, entry.ibo);
+        m_pGeometry->SetDrawRange(draw, entry.Geometry);
 
         const uint32_t MaterialIndex = entry.MaterialIndex;
 
+        // Entries without a valid material are drawn white with the default material, not with the previous entry's
+        draw.texture = m_pDefaultTexture->GetBinding(0);
+        draw.material = CMaterialTable::DEFAULT_MATERIAL;
         if (MaterialIndex < m_Textures.size() && m_Textures[MaterialIndex]) {
-            m_Textures[MaterialIndex]->Bind(0);
+            draw.texture = m_Textures[MaterialIndex]->GetBinding(0);
+            draw.material = m_Materials[MaterialIndex];
         }
 
-        glDrawElements(GL_TRIANGLES, entry.NumIndices, GL_UNSIGNED_INT, 0);
-		glDisableVertexAttribArray(0);
-		glDisableVertexAttribArray(1);
-		glDisableVertexAttribArray(2);
+        queue.Submit(draw);
     }
 }
@@ -5,38 +5,32 @@
 #include <assimp/postprocess.h> // Post processing flags
 
 #include "texture.h"
+#include "geometryarena.h"
+#include "meshoptimiser.h"
 
-#define INVALID_OGL_VALUE 0xFFFFFFFF
-#define SAFE_DELETE(p) if (p) { delete p; p = nullptr; }
-
-struct Vertex
-{
-    glm::vec3 m_pos;
-    glm::vec2 m_tex;
-    glm::vec3 m_normal;
-
-    Vertex() {}
+class CMaterialTable;
 
-    Vertex(const glm::vec3& pos, const glm::vec2& tex, const glm::vec3& normal)
-    {
-        m_pos    = pos;
-        m_tex    = tex;
-        m_normal = normal;
-    }
-};
+#define SAFE_DELETE(p) if (p) { delete p; p = nullptr; }
 
 class COpenAssetImportMesh
 {
 public:
     COpenAssetImportMesh();
     ~COpenAssetImportMesh();
-    bool Load(const std::filesystem::path& path);
-    void Render();
+    // The geometry goes into the arena, compressed if the arena holds compact vertices.  The materials are added to
+    // the table if one is given, otherwise the mesh is drawn with the default material.
+    bool Load(const std::filesystem::path& path, CGeometryArena& geometry, CMaterialTable* pMaterials = nullptr);
+    void Submit(CRenderQueue& queue, const DrawPacket& packet);
+
+    // Takes the stored positions to object space, it must be applied in front of the model matrix.  The identity
+    // unless the mesh is compressed.
+    const glm::mat4& GetPositionTransform() const { return m_positionTransform; }
 
 private:
-    bool InitFromScene(const aiScene* pScene);
-    void InitMesh(uint32_t Index, const aiMesh* paiMesh);
-    bool InitMaterials(const aiScene* pScene);
+    bool InitFromScene(const std::filesystem::path& path, const aiScene* pScene, CMaterialTable* pMaterials);
+    CMeshOptimiser::Report InitMesh(uint32_t Index, const aiMesh* paiMesh, CVertexBuilder<Vertex>& Geometry);
+    bool InitMaterials(const aiScene* pScene, CMaterialTable* pMaterials);
+    static CTexture* CreateWhiteTexture();
     void Clear();
 
 #define INVALID_MATERIAL 0xFFFFFFFF
@@ -44,20 +38,18 @@ private:
     struct MeshEntry {
         MeshEntry();
 
-        ~MeshEntry();
-
-        void Init(const std::vector<Vertex>& Vertices,
-                  const std::vector<uint32_t>& Indices);
-        GLuint vbo;
-        GLuint ibo;
-        uint32_t NumIndices;
+        GeometryRange Geometry;
         uint32_t MaterialIndex;
     };
 
     std::vector<MeshEntry> m_Entries;
-    std::vector<CTexture*> m_Textures;
-    GLuint m_vao;
+    std::vector<CTexture*> m_Textures;  // Diffuse texture of each of the scene's materials
+    std::vector<CTexture*> m_MapTextures;  // The materials' other textures, e.g. normal and specular maps
+    CTexture* m_pDefaultTexture = nullptr;  // Drawn with by entries whose material index is invalid
+    std::vector<uint32_t> m_Materials;  // Index in the material table of each of the scene's materials
     std::filesystem::path m_directory;
+    CGeometryArena* m_pGeometry = nullptr;
+    glm::mat4 m_positionTransform{1.0f};
 };
 
 
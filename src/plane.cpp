@@ -1,17 +1,24 @@
 
 #include "plane.h"
+#include "renderqueue.h"
 
 #define BUFFER_OFFSET(i) ((char *)nullptr + (i))
 
 CPlane::CPlane()
-{}
+{
+	m_pGeometry = nullptr;
+}
 
+// Gives the geometry's range back to the arena, which outlives the objects drawn from it
 CPlane::~CPlane()
-{}
+{
+	if (m_pGeometry != nullptr)
+		m_pGeometry->Remove(m_geometry);
+}
 
 
 // Create the plane, including its geometry, texture mapping, normal, and colour
-void CPlane::Create(const std::string& directory, const std::string& filename, float width, float height, float textureRepeat)
+void CPlane::Create(CGeometryArena& geometry, const std::string& directory, const std::string& filename, float width, float height, float textureRepeat)
 {
 	m_width = width;
 	m_height = height;
@@ -28,14 +35,6 @@ void CPlane::Create(const std::string& directory, const std::string& filename, f
 	m_texture.SetSamplerObjectParameter(GL_TEXTURE_WRAP_S, GL_REPEAT);
 	m_texture.SetSamplerObjectParameter(GL_TEXTURE_WRAP_T, GL_REPEAT);
 
-	// Use VAO to store state associated with vertices
-	glGenVertexArrays(1, &m_vao);
-	glBindVertexArray(m_vao);
-
-	// Create a VBO
-	m_vbo.Create();
-	m_vbo.Bind();
-
 	float halfWidth = m_width / 2.0f;
 	float halfHeight = m_height / 2.0f;
 
@@ -60,42 +59,32 @@ void CPlane::Create(const std::string& directory, const std::string& filename, f
 	// Plane normal
 	glm::vec3 planeNormal = glm::vec3{0.0f, 1.0f, 0.0f};
 
-	// Put the vertex attributes in the VBO
+	// Interleave the vertex attributes
+	CVertexBuilder<Vertex> vertices(4);
 	for (uint32_t i = 0; i < 4; i++) {
-		m_vbo.AddData(&planeVertices[i], sizeof(glm::vec3));
-		m_vbo.AddData(&planeTexCoords[i], sizeof(glm::vec2));
-		m_vbo.AddData(&planeNormal, sizeof(glm::vec3));
+		vertices.AddVertex({planeVertices[i], planeTexCoords[i], planeNormal});
 	}
 
-	// Upload the VBO to the GPU
-	m_vbo.UploadDataToGPU(GL_STATIC_DRAW);
-
-	// Set the vertex attribute locations
-	GLsizei istride = 2*sizeof(glm::vec3)+sizeof(glm::vec2);
-
-	// Vertex positions
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, istride, 0);
-	// Texture coordinates
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, istride, (void*)sizeof(glm::vec3));
-	// Normal vectors
-	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, istride, (void*)(sizeof(glm::vec3)+sizeof(glm::vec2)));
+	// Copy the vertices into the shared geometry buffers
+	m_pGeometry = &geometry;
+	m_geometry = geometry.Add(vertices);
 }
 
-// Render the plane as a triangle strip
-void CPlane::Render()
+// Submits the plane as a triangle strip
+void CPlane::Submit(CRenderQueue& queue, const DrawPacket& packet)
 {
-	glBindVertexArray(m_vao);
-	m_texture.Bind();
-	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+	DrawPacket draw = packet;
+	m_pGeometry->SetDrawRange(draw, m_geometry);
+	draw.texture = m_texture.GetBinding();
+	draw.primitive = PrimitiveType::TriangleStrip;
+	queue.Submit(draw);
 }
 
 // Release resources
 void CPlane::Release()
 {
 	m_texture.Release();
-	glDeleteVertexArrays(1, &m_vao);
-	m_vbo.Release();
+	if (m_pGeometry != nullptr)
+		m_pGeometry->Remove(m_geometry);
+	m_geometry = {};
 }
\ No newline at end of file
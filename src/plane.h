@@ -1,7 +1,7 @@
 #pragma once
 
 #include "texture.h"
-#include "vertexbufferobject.h"
+#include "geometryarena.h"
 
 // Class for generating a xz plane of a given size
 class CPlane
@@ -9,13 +9,13 @@ class CPlane
 public:
 	CPlane();
 	~CPlane();
-	void Create(const std::string& sDirectory, const std::string& sFilename, float fWidth, float fHeight, float fTextureRepeat);
-	void Render();
+	void Create(CGeometryArena& geometry, const std::string& sDirectory, const std::string& sFilename, float fWidth, float fHeight, float fTextureRepeat);
+	void Submit(CRenderQueue& queue, const DrawPacket& packet);
 	void Release();
 
 private:
-	GLuint m_vao;
-	CVertexBufferObject m_vbo;
+	CGeometryArena* m_pGeometry;
+	GeometryRange m_geometry;
 	CTexture m_texture;
 	std::string m_directory;
 	std::string m_filename;
@@ -0,0 +1,234 @@
+#include "profiler.h"
+#include "rendercommandbuffer.h"
+
+CProfiler* CProfiler::instance;
+
+// Nesting depth of the CPU scopes open on this thread
+static thread_local int t_depth = 0;
+
+CProfiler::CProfiler()
+{
+	m_enabled = true;
+	m_gpuFrame = 0;
+	m_gpuClockOffset = 0;
+	m_gpuClockCalibrated = false;
+
+	if (instance == nullptr) {
+		instance = this;
+	}
+}
+
+// Must run with the GL context current, after the render thread has stopped
+CProfiler::~CProfiler()
+{
+	for (auto& frame : m_gpuFrames) {
+		if (!frame.queries.empty())
+			glDeleteQueries(static_cast<GLsizei>(frame.queries.size()), frame.queries.data());
+	}
+
+	if (instance == this) {
+		instance = nullptr;
+	}
+}
+
+// Returns the index of the named scope on the calling thread, registering it on first use.  Names are expected to be
+// string literals.
+uint32_t CProfiler::GetScope(const char* name)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	auto id = std::this_thread::get_id();
+	auto thread = static_cast<uint32_t>(std::find(m_threads.begin(), m_threads.end(), id) - m_threads.begin());
+	if (thread == m_threads.size())
+		m_threads.push_back(id);
+
+	auto it = m_scopeIndices.find({thread, name});
+	if (it != m_scopeIndices.end())
+		return it->second;
+
+	auto index = static_cast<uint32_t>(m_scopes.size());
+	Scope scope;
+	scope.name = name;
+	scope.depth = t_depth;
+	scope.thread = thread;
+	m_scopes.push_back(std::move(scope));
+	m_scopeIndices.emplace(std::make_pair(thread, std::string_view{name}), index);
+	return index;
+}
+
+void CProfiler::AddCpuSample(uint32_t scope, float ms)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	Scope& s = m_scopes[scope];
+	if (s.cpuSamples.size() < SAMPLE_WINDOW)
+		s.cpuSamples.push_back(ms);
+	else
+		s.cpuSamples[s.cpuNext] = ms;
+	s.cpuNext = (s.cpuNext + 1) % SAMPLE_WINDOW;
+}
+
+std::vector<CProfiler::ScopeReport> CProfiler::GetReport()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	std::vector<ScopeReport> report;
+	report.reserve(m_scopes.size());
+	for (auto& scope : m_scopes)
+		report.push_back({scope.name, scope.depth, scope.thread, ComputeStats(scope.cpuSamples), ComputeStats(scope.gpuSamples)});
+	return report;
+}
+
+CProfiler::Stats CProfiler::ComputeStats(const std::vector<float>& samples)
+{
+	if (samples.empty())
+		return {0.0f, 0.0f, 0.0f, 0};
+
+	std::vector<float> sorted = samples;
+	auto p99 = sorted.begin() + (sorted.size() * 99) / 100;
+	std::nth_element(sorted.begin(), p99, sorted.end());
+
+	float sum = 0.0f;
+	for (float sample : samples)
+		sum += sample;
+
+	return {*std::min_element(samples.begin(), samples.end()), sum / samples.size(), *p99, static_cast<uint32_t>(samples.size())};
+}
+
+// Moves on to the next query slot, first collecting the results it holds from GPU_FRAME_LATENCY frames ago
+void CProfiler::BeginGpuFrame()
+{
+	m_gpuFrame = (m_gpuFrame + 1) % GPU_FRAME_LATENCY;
+
+	// Line the GPU clock up with the trace clock so GPU events land under the frames that issued them
+	if (Trace::IsEnabled() && !m_gpuClockCalibrated) {
+		GLint64 gpuTime;
+		glGetInteger64v(GL_TIMESTAMP, &gpuTime);
+		m_gpuClockOffset = static_cast<int64_t>(Trace::Now()) - gpuTime;
+		m_gpuClockCalibrated = true;
+	}
+
+	GpuFrame& frame = m_gpuFrames[m_gpuFrame];
+	ResolveGpuFrame(frame);
+	frame.timestamps.clear();
+}
+
+void CProfiler::WriteGpuTimestamp(uint32_t scope, bool end)
+{
+	GpuFrame& frame = m_gpuFrames[m_gpuFrame];
+
+	size_t index = frame.timestamps.size();
+	if (index == frame.queries.size()) {
+		GLuint query;
+		glGenQueries(1, &query);
+		frame.queries.push_back(query);
+	}
+
+	GLuint query = frame.queries[index];
+	glQueryCounter(query, GL_TIMESTAMP);
+	frame.timestamps.push_back({scope, end, query});
+}
+
+void CProfiler::ResolveGpuFrame(GpuFrame& frame)
+{
+	if (frame.timestamps.empty())
+		return;
+
+	// Queries complete in order, so if the last one is not ready the frame is still in flight.  Drop it rather than stall.
+	GLint available = GL_FALSE;
+	glGetQueryObjectiv(frame.timestamps.back().query, GL_QUERY_RESULT_AVAILABLE, &available);
+	if (available == GL_FALSE)
+		return;
+
+	// Scopes nest, so every end matches the innermost open begin.  A pass drawn several times per frame is summed.
+	std::vector<std::pair<uint32_t, GLuint64>> open;
+	std::vector<std::pair<uint32_t, GLuint64>> durations;
+
+	// Individual begin/end pairs, kept for the trace timeline
+	struct Span { uint32_t scope; GLuint64 begin, end; };
+	std::vector<Span> spans;
+	bool traceGpu = m_gpuClockCalibrated && Trace::IsEnabled();
+
+	for (const GpuTimestamp& timestamp : frame.timestamps) {
+		GLuint64 time;
+		glGetQueryObjectui64v(timestamp.query, GL_QUERY_RESULT, &time);
+
+		if (!timestamp.end) {
+			open.emplace_back(timestamp.scope, time);
+			continue;
+		}
+
+		if (open.empty() || open.back().first != timestamp.scope)
+			continue;
+
+		GLuint64 duration = time - open.back().second;
+		if (traceGpu)
+			spans.push_back({timestamp.scope, open.back().second, time});
+		open.pop_back();
+
+		auto it = std::find_if(durations.begin(), durations.end(), [&](const auto& d) { return d.first == timestamp.scope; });
+		if (it != durations.end())
+			it->second += duration;
+		else
+			durations.emplace_back(timestamp.scope, duration);
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for (auto& [scope, duration] : durations) {
+		Scope& s = m_scopes[scope];
+		float ms = static_cast<float>(duration) / 1000000.0f;
+		if (s.gpuSamples.size() < SAMPLE_WINDOW)
+			s.gpuSamples.push_back(ms);
+		else
+			s.gpuSamples[s.gpuNext] = ms;
+		s.gpuNext = (s.gpuNext + 1) % SAMPLE_WINDOW;
+	}
+
+	for (const Span& span : spans)
+		Trace::AddGpuEvent(m_scopes[span.scope].name, span.begin + m_gpuClockOffset, span.end + m_gpuClockOffset);
+}
+
+CProfiler::CpuScope::CpuScope(const char* name)
+{
+	m_scope = INVALID_SCOPE;
+
+	CProfiler* profiler = CProfiler::Get();
+	if (profiler == nullptr || !profiler->IsEnabled())
+		return;
+
+	m_scope = profiler->GetScope(name);
+	t_depth++;
+	m_start = std::chrono::steady_clock::now();
+}
+
+CProfiler::CpuScope::~CpuScope()
+{
+	if (m_scope == INVALID_SCOPE)
+		return;
+
+	auto elapsed = std::chrono::steady_clock::now() - m_start;
+	t_depth--;
+
+	if (CProfiler* profiler = CProfiler::Get())
+		profiler->AddCpuSample(m_scope, std::chrono::duration<float, std::milli>(elapsed).count());
+}
+
+CProfiler::GpuScope::GpuScope(CRenderCommandBuffer& commands, const char* name)
+	: m_commands{commands}
+	, m_cpuScope{name}
+{
+	m_scope = INVALID_SCOPE;
+
+	CProfiler* profiler = CProfiler::Get();
+	if (profiler == nullptr || !profiler->IsEnabled())
+		return;
+
+	m_scope = profiler->GetScope(name);
+	m_commands.WriteTimestamp(m_scope, false);
+}
+
+CProfiler::GpuScope::~GpuScope()
+{
+	if (m_scope != INVALID_SCOPE)
+		m_commands.WriteTimestamp(m_scope, true);
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "trace.h"
+
+class CRenderCommandBuffer;
+
+// Frame profiler collecting CPU scope timings and GPU pass timings.
+//
+// CPU scopes are measured with a steady clock on whichever thread they run.  GPU scopes are recorded as timestamp
+// commands into the frame's command buffer; the render thread writes them with glQueryCounter(GL_TIMESTAMP) and reads
+// the results back only when the query slot comes round again, several frames later, so the readback never stalls.
+// Each scope keeps a window of recent samples from which min/avg/p99 are reported.  A name used on several threads is
+// kept as one scope per thread, so their samples and nesting depths never mix.
+class CProfiler
+{
+public:
+	struct Stats
+	{
+		float min, avg, p99;	// Milliseconds
+		uint32_t samples;
+	};
+
+	struct ScopeReport
+	{
+		std::string name;
+		int depth;				// Nesting depth of the scope the first time it was seen
+		uint32_t thread;		// Threads are numbered in the order they first opened a scope
+		Stats cpu;
+		Stats gpu;				// samples is 0 for scopes without GPU timing
+	};
+
+	CProfiler();
+	~CProfiler();
+
+	static CProfiler* Get() { return instance; }
+
+	void SetEnabled(bool enabled) { m_enabled = enabled; }
+	bool IsEnabled() const { return m_enabled; }
+
+	// Snapshot of every scope's statistics, in the order scopes were first seen
+	std::vector<ScopeReport> GetReport();
+
+	// Render thread side: called around the replay of each frame and for every recorded timestamp
+	void BeginGpuFrame();
+	void WriteGpuTimestamp(uint32_t scope, bool end);
+
+	// Measures a CPU scope for as long as the object lives
+	class CpuScope
+	{
+	public:
+		explicit CpuScope(const char* name);
+		~CpuScope();
+	private:
+		uint32_t m_scope;
+		std::chrono::steady_clock::time_point m_start;
+	};
+
+	// Measures a pass on both the CPU (recording) and the GPU (execution)
+	class GpuScope
+	{
+	public:
+		GpuScope(CRenderCommandBuffer& commands, const char* name);
+		~GpuScope();
+	private:
+		CRenderCommandBuffer& m_commands;
+		CpuScope m_cpuScope;
+		uint32_t m_scope;
+	};
+
+private:
+	static const uint32_t SAMPLE_WINDOW = 240;		// Samples kept per scope for the statistics
+	static const uint32_t GPU_FRAME_LATENCY = 4;	// Frames between writing a GPU query and reading it back
+	static const uint32_t INVALID_SCOPE = 0xFFFFFFFF;
+
+	struct Scope
+	{
+		const char* name = nullptr;
+		int depth = 0;
+		uint32_t thread = 0;
+		std::vector<float> cpuSamples;	// Ring buffers of the last SAMPLE_WINDOW samples
+		std::vector<float> gpuSamples;
+		uint32_t cpuNext = 0;
+		uint32_t gpuNext = 0;
+	};
+
+	struct GpuTimestamp
+	{
+		uint32_t scope;
+		bool end;
+		GLuint query;
+	};
+
+	struct GpuFrame
+	{
+		std::vector<GLuint> queries;	// Pool of query objects, grown on demand
+		std::vector<GpuTimestamp> timestamps;
+	};
+
+	std::atomic<bool> m_enabled;	// Toggled on the main thread, read by scopes on every thread
+
+	std::mutex m_mutex;				// Guards the scopes, which are fed from the main and the render thread
+	std::vector<Scope> m_scopes;
+	std::vector<std::thread::id> m_threads;
+	std::map<std::pair<uint32_t, std::string_view>, uint32_t> m_scopeIndices;	// Keyed by thread and the literal passed to the scope macros
+
+	GpuFrame m_gpuFrames[GPU_FRAME_LATENCY];	// Only touched on the render thread
+	uint32_t m_gpuFrame;
+	int64_t m_gpuClockOffset;		// Trace clock minus GPU clock in nanoseconds, measured once when tracing starts
+	bool m_gpuClockCalibrated;
+
+	uint32_t GetScope(const char* name);
+	void AddCpuSample(uint32_t scope, float ms);
+	void ResolveGpuFrame(GpuFrame& frame);
+
+	static Stats ComputeStats(const std::vector<float>& samples);
+
+	static CProfiler* instance;
+};
+
+#define PROFILER_CONCAT_IMPL(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_IMPL(a, b)
+
+// Times the enclosing block on the CPU, and adds it to the trace timeline
+#define PROFILE_SCOPE(name) TRACE_SCOPE(name); CProfiler::CpuScope PROFILER_CONCAT(profileScope, __LINE__){ name }
+
+// Times the enclosing block on the CPU and the GPU commands it records into the command buffer.  With tracing on,
+// the GPU time shows up on the trace's GPU track.
+#define PROFILE_GPU_SCOPE(commands, name) TRACE_SCOPE(name); CProfiler::GpuScope PROFILER_CONCAT(profileGpuScope, __LINE__){ commands, name }
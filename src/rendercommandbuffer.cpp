@@ -0,0 +1,195 @@
+#include "rendercommandbuffer.h"
+
+// Clears the recorded commands but keeps the allocated memory for the next frame
+void CRenderCommandBuffer::Reset()
+{
+	m_commands.clear();
+	m_payload.clear();
+	m_blocks.clear();
+}
+
+void CRenderCommandBuffer::Add(RenderCommandType type, uint32_t arg0, uint32_t arg1, uint32_t arg2, uint32_t arg3)
+{
+	m_commands.push_back({type, {arg0, arg1, arg2, arg3}});
+}
+
+// Appends data to the payload and returns its offset.  Entries are padded to 4 bytes so values stay aligned.
+uint32_t CRenderCommandBuffer::AddPayload(const void* data, size_t size)
+{
+	auto offset = static_cast<uint32_t>(m_payload.size());
+	m_payload.resize(offset + ((size + 3) & ~size_t(3)));
+	std::memcpy(m_payload.data() + offset, data, size);
+	return offset;
+}
+
+void CRenderCommandBuffer::AddUniform(UniformName name, UniformType type, const void* data, size_t size, int iCount)
+{
+	uint32_t dataOffset = AddPayload(data, size);
+	Add(RenderCommandType::SetUniform, static_cast<uint32_t>(type), static_cast<uint32_t>(iCount), name.hash, dataOffset);
+}
+
+void CRenderCommandBuffer::SetUniformBlock(UniformBlock block, const void* data, size_t size)
+{
+	auto offset = static_cast<uint32_t>(m_blocks.size());
+	m_blocks.resize(offset + ((size + UNIFORM_BLOCK_ALIGNMENT - 1) & ~(UNIFORM_BLOCK_ALIGNMENT - 1)));
+	std::memcpy(m_blocks.data() + offset, data, size);
+	Add(RenderCommandType::BindUniformBlock, static_cast<uint32_t>(block), static_cast<uint32_t>(size), offset);
+}
+
+void CRenderCommandBuffer::UpdateBuffer(uint32_t buffer, size_t capacity, const void* data, size_t size)
+{
+	assert(size <= capacity && "Buffer update larger than the buffer");
+	uint32_t dataOffset = AddPayload(data, size);
+	Add(RenderCommandType::UpdateBuffer, buffer, static_cast<uint32_t>(capacity), dataOffset, static_cast<uint32_t>(size));
+}
+
+void CRenderCommandBuffer::BindUniformBuffer(UniformBlock block, uint32_t buffer, size_t size)
+{
+	Add(RenderCommandType::BindUniformBuffer, static_cast<uint32_t>(block), buffer, static_cast<uint32_t>(size));
+}
+
+void CRenderCommandBuffer::Clear(uint32_t flags)
+{
+	Add(RenderCommandType::Clear, flags);
+}
+
+void CRenderCommandBuffer::SetViewport(int x, int y, int width, int height)
+{
+	Add(RenderCommandType::SetViewport, x, y, width, height);
+}
+
+void CRenderCommandBuffer::Enable(RenderState state)
+{
+	Add(RenderCommandType::Enable, static_cast<uint32_t>(state));
+}
+
+void CRenderCommandBuffer::Disable(RenderState state)
+{
+	Add(RenderCommandType::Disable, static_cast<uint32_t>(state));
+}
+
+void CRenderCommandBuffer::SetDepthMask(bool enabled)
+{
+	Add(RenderCommandType::SetDepthMask, enabled);
+}
+
+void CRenderCommandBuffer::SetBlendMode(BlendMode mode)
+{
+	Add(RenderCommandType::SetBlendMode, static_cast<uint32_t>(mode));
+}
+
+void CRenderCommandBuffer::SetPolygonMode(bool wireframe)
+{
+	Add(RenderCommandType::SetPolygonMode, wireframe);
+}
+
+void CRenderCommandBuffer::UseProgram(uint32_t program)
+{
+	Add(RenderCommandType::UseProgram, program);
+}
+
+void CRenderCommandBuffer::BindTexture(TextureTarget target, int unit, uint32_t texture, uint32_t sampler)
+{
+	Add(RenderCommandType::BindTexture, static_cast<uint32_t>(target), unit, texture, sampler);
+}
+
+void CRenderCommandBuffer::BindVertexArray(uint32_t vertexArray)
+{
+	Add(RenderCommandType::BindVertexArray, vertexArray);
+}
+
+void CRenderCommandBuffer::DrawArrays(PrimitiveType primitive, int first, int count)
+{
+	Add(RenderCommandType::DrawArrays, static_cast<uint32_t>(primitive), first, count);
+}
+
+void CRenderCommandBuffer::DrawElements(PrimitiveType primitive, int count, IndexType indexType, size_t offset, int baseVertex)
+{
+	Add(RenderCommandType::DrawElements, static_cast<uint32_t>(primitive) | static_cast<uint32_t>(indexType) << 16, count,
+		static_cast<uint32_t>(offset), static_cast<uint32_t>(baseVertex));
+}
+
+void CRenderCommandBuffer::WriteTimestamp(uint32_t scope, bool end)
+{
+	Add(RenderCommandType::WriteTimestamp, scope, end);
+}
+
+// Setting vectors
+
+void CRenderCommandBuffer::SetUniform(UniformName name, const glm::vec2* vVectors, int iCount)
+{
+	AddUniform(name, UniformType::Vec2, vVectors, sizeof(glm::vec2) * iCount, iCount);
+}
+
+void CRenderCommandBuffer::SetUniform(UniformName name, const glm::vec2& vVector)
+{
+	AddUniform(name, UniformType::Vec2, &vVector, sizeof(glm::vec2), 1);
+}
+
+void CRenderCommandBuffer::SetUniform(UniformName name, const glm::vec3* vVectors, int iCount)
+{
+	AddUniform(name, UniformType::Vec3, vVectors, sizeof(glm::vec3) * iCount, iCount);
+}
+
+void CRenderCommandBuffer::SetUniform(UniformName name, const glm::vec3& vVector)
+{
+	AddUniform(name, UniformType::Vec3, &vVector, sizeof(glm::vec3), 1);
+}
+
+void CRenderCommandBuffer::SetUniform(UniformName name, const glm::vec4* vVectors, int iCount)
+{
+	AddUniform(name, UniformType::Vec4, vVectors, sizeof(glm::vec4) * iCount, iCount);
+}
+
+void CRenderCommandBuffer::SetUniform(UniformName name, const glm::vec4& vVector)
+{
+	AddUniform(name, UniformType::Vec4, &vVector, sizeof(glm::vec4), 1);
+}
+
+// Setting floats
+
+void CRenderCommandBuffer::SetUniform(UniformName name, const float* fValues, int iCount)
+{
+	AddUniform(name, UniformType::Float, fValues, sizeof(float) * iCount, iCount);
+}
+
+void CRenderCommandBuffer::SetUniform(UniformName name, const float fValue)
+{
+	AddUniform(name, UniformType::Float, &fValue, sizeof(float), 1);
+}
+
+// Setting 3x3 matrices
+
+void CRenderCommandBuffer::SetUniform(UniformName name, const glm::mat3* mMatrices, int iCount)
+{
+	AddUniform(name, UniformType::Mat3, mMatrices, sizeof(glm::mat3) * iCount, iCount);
+}
+
+void CRenderCommandBuffer::SetUniform(UniformName name, const glm::mat3& mMatrix)
+{
+	AddUniform(name, UniformType::Mat3, &mMatrix, sizeof(glm::mat3), 1);
+}
+
+// Setting 4x4 matrices
+
+void CRenderCommandBuffer::SetUniform(UniformName name, const glm::mat4* mMatrices, int iCount)
+{
+	AddUniform(name, UniformType::Mat4, mMatrices, sizeof(glm::mat4) * iCount, iCount);
+}
+
+void CRenderCommandBuffer::SetUniform(UniformName name, const glm::mat4& mMatrix)
+{
+	AddUniform(name, UniformType::Mat4, &mMatrix, sizeof(glm::mat4), 1);
+}
+
+// Setting integers
+
+void CRenderCommandBuffer::SetUniform(UniformName name, const int* iValues, int iCount)
+{
+	AddUniform(name, UniformType::Int, iValues, sizeof(int) * iCount, iCount);
+}
+
+void CRenderCommandBuffer::SetUniform(UniformName name, const int iValue)
+{
+	AddUniform(name, UniformType::Int, &iValue, sizeof(int), 1);
+}
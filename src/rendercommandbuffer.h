@@ -0,0 +1,114 @@
+#pragma once
+
+#include "uniforms.h"
+
+// Backend-agnostic description of the commands that make up a frame.  Resources are referred to by opaque handles
+// and all state by the enums below, so recording never touches the graphics API and can run on any thread.
+
+enum class RenderCommandType : uint8_t
+{
+	Clear,				// args: ClearFlags
+	SetViewport,		// args: x, y, width, height
+	Enable,				// args: RenderState
+	Disable,			// args: RenderState
+	SetDepthMask,		// args: write enabled
+	SetBlendMode,		// args: BlendMode
+	SetPolygonMode,		// args: wireframe
+	UseProgram,			// args: program handle
+	SetUniform,			// args: UniformType, count, name hash, data offset
+	BindUniformBlock,	// args: UniformBlock, size, block data offset
+	BindUniformBuffer,	// args: UniformBlock, buffer handle, size
+	UpdateBuffer,		// args: buffer handle, capacity, data offset, size
+	BindTexture,		// args: TextureTarget, unit, texture handle, sampler handle
+	BindVertexArray,	// args: vertex array handle
+	DrawArrays,			// args: PrimitiveType, first, count
+	DrawElements,		// args: PrimitiveType | IndexType << 16, count, byte offset, base vertex
+	WriteTimestamp,		// args: profiler scope, end of scope
+};
+
+enum ClearFlags : uint32_t
+{
+	CLEAR_COLOUR = 1 << 0,
+	CLEAR_DEPTH = 1 << 1,
+};
+
+enum class RenderState : uint32_t { DepthTest, CullFace };
+enum class BlendMode : uint32_t { Opaque, Alpha };
+enum class TextureTarget : uint32_t { Texture2D, CubeMap, Buffer };
+enum class PrimitiveType : uint32_t { Triangles, TriangleStrip };
+enum class IndexType : uint32_t { UnsignedShort, UnsignedInt };
+
+struct RenderCommand
+{
+	RenderCommandType type;
+	uint32_t args[4];
+};
+
+// Records the commands for one frame.  The buffer keeps its memory between frames, so once it has grown to the
+// size of a typical frame recording does not allocate.
+class CRenderCommandBuffer
+{
+public:
+	void Reset();
+
+	void Clear(uint32_t flags);
+	void SetViewport(int x, int y, int width, int height);
+	void Enable(RenderState state);
+	void Disable(RenderState state);
+	void SetDepthMask(bool enabled);
+	void SetBlendMode(BlendMode mode);
+	void SetPolygonMode(bool wireframe);
+
+	void UseProgram(uint32_t program);
+	void BindTexture(TextureTarget target, int unit, uint32_t texture, uint32_t sampler);
+	void BindVertexArray(uint32_t vertexArray);
+	void DrawArrays(PrimitiveType primitive, int first, int count);
+	// The base vertex is added to every index, so geometry sharing a buffer can keep indices from 0
+	void DrawElements(PrimitiveType primitive, int count, IndexType indexType, size_t offset = 0, int baseVertex = 0);
+	// Replaces the buffer's contents, the driver gets a fresh store of the given capacity so draws still reading the
+	// old contents don't stall the upload
+	void UpdateBuffer(uint32_t buffer, size_t capacity, const void* data, size_t size);
+
+	// Marks the beginning or end of a profiled GPU scope, see CProfiler
+	void WriteTimestamp(uint32_t scope, bool end);
+
+	// Uniforms apply to the program bound by the last UseProgram
+	void SetUniform(UniformName name, const glm::vec2* vVectors, int iCount = 1);
+	void SetUniform(UniformName name, const glm::vec2& vVector);
+	void SetUniform(UniformName name, const glm::vec3* vVectors, int iCount = 1);
+	void SetUniform(UniformName name, const glm::vec3& vVector);
+	void SetUniform(UniformName name, const glm::vec4* vVectors, int iCount = 1);
+	void SetUniform(UniformName name, const glm::vec4& vVector);
+	void SetUniform(UniformName name, const float* fValues, int iCount = 1);
+	void SetUniform(UniformName name, const float fValue);
+	void SetUniform(UniformName name, const glm::mat3* mMatrices, int iCount = 1);
+	void SetUniform(UniformName name, const glm::mat3& mMatrix);
+	void SetUniform(UniformName name, const glm::mat4* mMatrices, int iCount = 1);
+	void SetUniform(UniformName name, const glm::mat4& mMatrix);
+	void SetUniform(UniformName name, const int* iValues, int iCount = 1);
+	void SetUniform(UniformName name, const int iValue);
+
+	// Uniform blocks stay bound across UseProgram, so programs drawn afterwards share them
+	void SetUniformBlock(UniformBlock block, const void* data, size_t size);
+	void SetUniformBlock(const FrameUniforms& uniforms) { SetUniformBlock(UniformBlock::Frame, &uniforms, sizeof(uniforms)); }
+	void SetUniformBlock(const DrawUniforms& uniforms) { SetUniformBlock(UniformBlock::Draw, &uniforms, sizeof(uniforms)); }
+	// Binds a whole buffer that outlives the frame to a block, e.g. the material table
+	void BindUniformBuffer(UniformBlock block, uint32_t buffer, size_t size);
+
+	const std::vector<RenderCommand>& GetCommands() const { return m_commands; }
+	const void* GetData(uint32_t offset) const { return m_payload.data() + offset; }
+	const std::vector<uint8_t>& GetBlockData() const { return m_blocks; }
+
+	// Blocks are placed at multiples of this, the largest GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT of current hardware, so
+	// the device can copy them into a uniform buffer in one go without knowing the alignment while recording
+	static const size_t UNIFORM_BLOCK_ALIGNMENT = 256;
+
+private:
+	std::vector<RenderCommand> m_commands;
+	std::vector<uint8_t> m_payload;		// Uniform values referenced by offset from the commands
+	std::vector<uint8_t> m_blocks;		// Uniform block contents laid out as in the uniform buffer
+
+	void Add(RenderCommandType type, uint32_t arg0 = 0, uint32_t arg1 = 0, uint32_t arg2 = 0, uint32_t arg3 = 0);
+	uint32_t AddPayload(const void* data, size_t size);
+	void AddUniform(UniformName name, UniformType type, const void* data, size_t size, int iCount);
+};
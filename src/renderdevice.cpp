@@ -0,0 +1,189 @@
+#include "renderdevice.h"
+#include "profiler.h"
+#include "glstatecache.h"
+#include "shaders.h"
+
+CRenderDevice::CRenderDevice()
+{
+	m_currentProgram = 0;
+	m_pCurrentUniforms = nullptr;
+	m_blockBase = 0;
+	m_stats = {};
+}
+
+void CRenderDevice::Release()
+{
+	m_uniformBuffer.Release();
+	m_pCurrentUniforms = nullptr;
+}
+
+// Translates every recorded command into the matching GL calls
+void CRenderDevice::Execute(const CRenderCommandBuffer& commands)
+{
+	const std::vector<uint8_t>& blocks = commands.GetBlockData();
+	m_blockBase = m_uniformBuffer.BeginFrame(blocks.data(), blocks.size());
+
+	CGLStateCache& state = CGLStateCache::Get();
+	const CGLStateCache::Counters counters = state.GetCounters();
+
+	for (const RenderCommand& command : commands.GetCommands()) {
+		const uint32_t* args = command.args;
+
+		switch (command.type) {
+			case RenderCommandType::Clear: {
+				GLbitfield mask = 0;
+				if (args[0] & CLEAR_COLOUR)
+					mask |= GL_COLOR_BUFFER_BIT;
+				if (args[0] & CLEAR_DEPTH)
+					mask |= GL_DEPTH_BUFFER_BIT;
+				glClear(mask);
+				break;
+			}
+			case RenderCommandType::SetViewport:
+				state.SetViewport(static_cast<GLint>(args[0]), static_cast<GLint>(args[1]), static_cast<GLsizei>(args[2]), static_cast<GLsizei>(args[3]));
+				break;
+			case RenderCommandType::Enable:
+				state.SetEnabled(GetState(static_cast<RenderState>(args[0])), true);
+				break;
+			case RenderCommandType::Disable:
+				state.SetEnabled(GetState(static_cast<RenderState>(args[0])), false);
+				break;
+			case RenderCommandType::SetDepthMask:
+				state.SetDepthMask(args[0] != 0);
+				break;
+			case RenderCommandType::SetBlendMode:
+				if (static_cast<BlendMode>(args[0]) == BlendMode::Alpha) {
+					state.SetEnabled(GL_BLEND, true);
+					state.SetBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+				} else {
+					state.SetEnabled(GL_BLEND, false);
+				}
+				break;
+			case RenderCommandType::SetPolygonMode:
+				state.SetPolygonMode(args[0] ? GL_LINE : GL_FILL);
+				break;
+			case RenderCommandType::UseProgram:
+				m_currentProgram = args[0];
+				state.UseProgram(m_currentProgram);
+				m_pCurrentUniforms = CShaderProgram::FindUniforms(m_currentProgram);
+				break;
+			case RenderCommandType::SetUniform:
+				SetUniform(commands, command);
+				break;
+			case RenderCommandType::BindUniformBlock:
+				state.BindUniformBuffer(args[0], m_uniformBuffer.GetBuffer(), m_blockBase + args[2], args[1]);
+				break;
+			case RenderCommandType::BindUniformBuffer:
+				state.BindUniformBuffer(args[0], args[1], 0, args[2]);
+				break;
+			case RenderCommandType::UpdateBuffer:
+				// Orphan the old store, then fill the new one.  The copy-write target isn't used for drawing.
+				glBindBuffer(GL_COPY_WRITE_BUFFER, args[0]);
+				glBufferData(GL_COPY_WRITE_BUFFER, args[1], nullptr, GL_STREAM_DRAW);
+				glBufferSubData(GL_COPY_WRITE_BUFFER, 0, args[3], commands.GetData(args[2]));
+				break;
+			case RenderCommandType::BindTexture:
+				state.BindTexture(args[1], GetTextureTarget(static_cast<TextureTarget>(args[0])), args[2]);
+				// Buffer textures are fetched without a sampler, binding one would only count as a filtered change
+				if (static_cast<TextureTarget>(args[0]) != TextureTarget::Buffer)
+					state.BindSampler(args[1], args[3]);
+				break;
+			case RenderCommandType::BindVertexArray:
+				state.BindVertexArray(args[0]);
+				break;
+			case RenderCommandType::DrawArrays:
+				// No program is bound while the one recorded is still being built
+				if (m_currentProgram == 0)
+					break;
+				glDrawArrays(GetPrimitive(static_cast<PrimitiveType>(args[0])), static_cast<GLint>(args[1]), static_cast<GLsizei>(args[2]));
+				CountDraw(static_cast<PrimitiveType>(args[0]), args[2]);
+				break;
+			case RenderCommandType::DrawElements: {
+				if (m_currentProgram == 0)
+					break;
+				auto primitive = static_cast<PrimitiveType>(args[0] & 0xFFFF);
+				glDrawElementsBaseVertex(GetPrimitive(primitive), static_cast<GLsizei>(args[1]), GetIndexType(static_cast<IndexType>(args[0] >> 16)),
+										 reinterpret_cast<const void*>(static_cast<uintptr_t>(args[2])), static_cast<GLint>(args[3]));
+				CountDraw(primitive, args[1]);
+				break;
+			}
+			case RenderCommandType::WriteTimestamp:
+				if (CProfiler* profiler = CProfiler::Get())
+					profiler->WriteGpuTimestamp(args[0], args[1] != 0);
+				break;
+		}
+	}
+
+	m_uniformBuffer.EndFrame();
+
+	m_stats.stateChanges += state.GetCounters().issued - counters.issued;
+	m_stats.filteredStateChanges += state.GetCounters().filtered - counters.filtered;
+}
+
+void CRenderDevice::ForgetProgram(GLuint program)
+{
+	CGLStateCache::Get().ForgetProgram(program);
+	if (m_currentProgram == program) {
+		m_currentProgram = 0;
+		m_pCurrentUniforms = nullptr;
+	}
+}
+
+void CRenderDevice::SetUniform(const CRenderCommandBuffer& commands, const RenderCommand& command)
+{
+	if (m_pCurrentUniforms == nullptr)
+		return;
+
+	// Like glUniform with location -1, uniforms the program doesn't use are ignored
+	int index = m_pCurrentUniforms->Find(UniformName{command.args[2]});
+	if (index < 0)
+		return;
+
+	m_pCurrentUniforms->Set(index, static_cast<UniformType>(command.args[0]), commands.GetData(command.args[3]), static_cast<int>(command.args[1]));
+}
+
+void CRenderDevice::CountDraw(PrimitiveType primitive, uint32_t count)
+{
+	m_stats.drawCalls++;
+	if (primitive == PrimitiveType::Triangles)
+		m_stats.triangles += count / 3;
+	else if (count >= 3)
+		m_stats.triangles += count - 2;
+}
+
+GLenum CRenderDevice::GetState(RenderState state)
+{
+	switch (state) {
+		case RenderState::DepthTest: return GL_DEPTH_TEST;
+		case RenderState::CullFace: return GL_CULL_FACE;
+	}
+	return GL_NONE;
+}
+
+GLenum CRenderDevice::GetPrimitive(PrimitiveType primitive)
+{
+	switch (primitive) {
+		case PrimitiveType::Triangles: return GL_TRIANGLES;
+		case PrimitiveType::TriangleStrip: return GL_TRIANGLE_STRIP;
+	}
+	return GL_NONE;
+}
+
+GLenum CRenderDevice::GetIndexType(IndexType indexType)
+{
+	switch (indexType) {
+		case IndexType::UnsignedShort: return GL_UNSIGNED_SHORT;
+		case IndexType::UnsignedInt: return GL_UNSIGNED_INT;
+	}
+	return GL_NONE;
+}
+
+GLenum CRenderDevice::GetTextureTarget(TextureTarget target)
+{
+	switch (target) {
+		case TextureTarget::Texture2D: return GL_TEXTURE_2D;
+		case TextureTarget::CubeMap: return GL_TEXTURE_CUBE_MAP;
+		case TextureTarget::Buffer: return GL_TEXTURE_BUFFER;
+	}
+	return GL_NONE;
+}
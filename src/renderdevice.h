@@ -0,0 +1,43 @@
+#pragma once
+
+#include "rendercommandbuffer.h"
+
+// OpenGL backend that replays recorded command buffers.  It must only be used on the thread that owns the GL context.
+class CRenderDevice
+{
+public:
+	CRenderDevice();
+
+	void Execute(const CRenderCommandBuffer& commands);
+	// Deletes the GL objects the device created, before the context goes away
+	void Release();
+	// Drops the state kept for a deleted program, GL may hand its ID out again
+	void ForgetProgram(GLuint program);
+
+	// Counts of the draws and state changes executed since the last ResetStats
+	struct Stats
+	{
+		uint32_t drawCalls;
+		uint64_t triangles;
+		uint32_t stateChanges;			// Passed on to GL by the state cache
+		uint32_t filteredStateChanges;	// Dropped by the state cache as redundant
+	};
+	void ResetStats() { m_stats = {}; }
+	const Stats& GetStats() const { return m_stats; }
+
+private:
+	GLuint m_currentProgram;	// Program bound by the last UseProgram
+	CUniformTable* m_pCurrentUniforms;	// Owned by the CShaderProgram of the current program, see CShaderProgram::FindUniforms
+	CUniformRingBuffer m_uniformBuffer;
+	GLintptr m_blockBase;		// Offset of the current frame's blocks in the uniform buffer
+	Stats m_stats;
+
+	void CountDraw(PrimitiveType primitive, uint32_t count);
+
+	void SetUniform(const CRenderCommandBuffer& commands, const RenderCommand& command);
+
+	static GLenum GetState(RenderState state);
+	static GLenum GetPrimitive(PrimitiveType primitive);
+	static GLenum GetIndexType(IndexType indexType);
+	static GLenum GetTextureTarget(TextureTarget target);
+};
@@ -0,0 +1,150 @@
+#include "renderqueue.h"
+
+void CRenderQueue::Reset()
+{
+	m_packets.clear();
+	m_drawUniforms.clear();
+}
+
+uint32_t CRenderQueue::AddDrawUniforms(const DrawUniforms& uniforms)
+{
+	m_drawUniforms.push_back(uniforms);
+	return static_cast<uint32_t>(m_drawUniforms.size() - 1);
+}
+
+void CRenderQueue::Submit(const DrawPacket& packet)
+{
+	assert(packet.drawUniforms < m_drawUniforms.size() && "Packet refers to uniforms that weren't added");
+	m_packets.push_back(packet);
+}
+
+void CRenderQueue::Execute(CRenderCommandBuffer& commands)
+{
+	Sort();
+
+	// The state set by the previous packet, so only what changes is recorded
+	static const uint32_t TRACKED_TEXTURE_UNITS = 16;
+	const DrawPacket* pPrevious = nullptr;
+	TextureBinding textures[TRACKED_TEXTURE_UNITS];
+
+	for (const SortEntry& entry : m_sorted) {
+		const DrawPacket& packet = m_packets[entry.packet];
+
+		if (pPrevious == nullptr || packet.pass != pPrevious->pass)
+			BeginPass(commands, packet.pass);
+		if (pPrevious == nullptr || packet.program != pPrevious->program)
+			commands.UseProgram(packet.program);
+		if (pPrevious == nullptr || packet.vertexArray != pPrevious->vertexArray)
+			commands.BindVertexArray(packet.vertexArray);
+		if (pPrevious == nullptr || packet.drawUniforms != pPrevious->drawUniforms || packet.material != pPrevious->material) {
+			DrawUniforms uniforms = m_drawUniforms[packet.drawUniforms];
+			uniforms.materialIndex = packet.material;
+			commands.SetUniformBlock(uniforms);
+		}
+
+		const TextureBinding& texture = packet.texture;
+		if (texture.texture != 0) {
+			bool tracked = texture.unit < TRACKED_TEXTURE_UNITS;
+			if (!tracked || textures[texture.unit].texture != texture.texture || textures[texture.unit].sampler != texture.sampler ||
+				textures[texture.unit].target != texture.target) {
+				commands.BindTexture(texture.target, static_cast<int>(texture.unit), texture.texture, texture.sampler);
+				if (tracked)
+					textures[texture.unit] = texture;
+			}
+		}
+
+		if (packet.indexed)
+			commands.DrawElements(packet.primitive, static_cast<int>(packet.count), packet.indexType, packet.first, packet.baseVertex);
+		else
+			commands.DrawArrays(packet.primitive, static_cast<int>(packet.first), static_cast<int>(packet.count));
+
+		pPrevious = &packet;
+	}
+
+	// Leave the state the rest of the frame is recorded with
+	if (pPrevious != nullptr && pPrevious->pass != RenderPass::Opaque)
+		BeginPass(commands, RenderPass::Opaque);
+}
+
+uint64_t CRenderQueue::MakeKey(const DrawPacket& packet)
+{
+	uint64_t pass = static_cast<uint64_t>(packet.pass) & 0xF;
+	uint64_t program = packet.program & 0xFFF;
+	uint64_t texture = packet.texture.texture & 0xFFFF;
+	uint64_t vertexArray = packet.vertexArray & 0xFFF;
+	uint64_t depth = QuantiseDepth(packet.depth);
+
+	if (packet.pass == RenderPass::Transparent)
+		return pass << 60 | (0xFFFFF - depth) << 40 | program << 28 | texture << 12 | vertexArray;
+	return pass << 60 | program << 48 | texture << 32 | vertexArray << 20 | depth;
+}
+
+// Non-negative floats order the same as their bit patterns, so the top 20 bits below the sign give a logarithmic
+// depth with about 12 bits of precision per power of two
+uint32_t CRenderQueue::QuantiseDepth(float depth)
+{
+	// Behind the eye, or NaN
+	if (!(depth > 0.0f))
+		return 0;
+
+	uint32_t bits;
+	std::memcpy(&bits, &depth, sizeof(bits));
+	return bits >> 11;
+}
+
+// Least significant digit first radix sort on bytes of the key.  Each pass is stable, so packets with equal keys
+// stay in submission order.
+void CRenderQueue::Sort()
+{
+	const size_t count = m_packets.size();
+	m_sorted.resize(count);
+	m_scratch.resize(count);
+
+	// All eight histograms are counted in one read of the keys
+	uint32_t histograms[8][256] = {};
+	for (size_t i = 0; i < count; i++) {
+		uint64_t key = MakeKey(m_packets[i]);
+		m_sorted[i] = {key, static_cast<uint32_t>(i)};
+		for (int digit = 0; digit < 8; digit++)
+			histograms[digit][(key >> (digit * 8)) & 0xFF]++;
+	}
+
+	for (int digit = 0; digit < 8; digit++) {
+		uint32_t* histogram = histograms[digit];
+		const int shift = digit * 8;
+
+		// Every key has the same byte here, a pass would leave the order as it is.  Most of the key's bytes are
+		// constant in a typical frame.
+		if (count == 0 || histogram[(m_sorted[0].key >> shift) & 0xFF] == count)
+			continue;
+
+		uint32_t offset = 0;
+		for (int bucket = 0; bucket < 256; bucket++) {
+			uint32_t bucketCount = histogram[bucket];
+			histogram[bucket] = offset;
+			offset += bucketCount;
+		}
+
+		for (const SortEntry& entry : m_sorted)
+			m_scratch[histogram[(entry.key >> shift) & 0xFF]++] = entry;
+		m_sorted.swap(m_scratch);
+	}
+}
+
+void CRenderQueue::BeginPass(CRenderCommandBuffer& commands, RenderPass pass)
+{
+	switch (pass) {
+		case RenderPass::Background:
+			commands.SetDepthMask(false);
+			commands.SetBlendMode(BlendMode::Opaque);
+			break;
+		case RenderPass::Opaque:
+			commands.SetDepthMask(true);
+			commands.SetBlendMode(BlendMode::Opaque);
+			break;
+		case RenderPass::Transparent:
+			commands.SetDepthMask(false);
+			commands.SetBlendMode(BlendMode::Alpha);
+			break;
+	}
+}
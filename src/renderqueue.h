@@ -0,0 +1,79 @@
+#pragma once
+
+#include "rendercommandbuffer.h"
+
+// Passes are drawn in this order, each with its own depth and blend state
+enum class RenderPass : uint8_t
+{
+	Background,		// Depth writes off, e.g. the skybox behind everything
+	Opaque,			// Grouped by state, then roughly front-to-back so early-z rejects hidden fragments
+	Transparent,	// Alpha blended back-to-front with depth writes off
+};
+
+struct TextureBinding
+{
+	TextureTarget target = TextureTarget::Texture2D;
+	uint32_t unit = 0;
+	uint32_t texture = 0;		// 0 leaves the unit as it is
+	uint32_t sampler = 0;
+};
+
+// Everything needed to issue one draw.  The caller fills in the pass, program, depth and uniforms and the object
+// drawn fills in its geometry and texture, see e.g. CPlane::Submit.
+struct DrawPacket
+{
+	RenderPass pass = RenderPass::Opaque;
+	float depth = 0.0f;			// Distance from the eye, used to order draws within the pass
+	uint32_t program = 0;		// Handle from CShaderProgram::GetDrawProgram
+	uint32_t drawUniforms = 0;	// Index returned by CRenderQueue::AddDrawUniforms
+	uint32_t material = 0;		// Index into CMaterialTable, written into the draw's uniforms
+	uint32_t vertexArray = 0;
+	TextureBinding texture;
+	PrimitiveType primitive = PrimitiveType::Triangles;
+	bool indexed = false;
+	IndexType indexType = IndexType::UnsignedInt;
+	uint32_t first = 0;			// First vertex, or byte offset into the index buffer when indexed
+	uint32_t count = 0;
+	int32_t baseVertex = 0;		// Added to every index when indexed
+};
+
+// Collects the frame's draws as packets, sorts them by a 64-bit key and records them into a command buffer with
+// only the state changes between neighbouring packets.  Like the command buffer, the queue keeps its memory
+// between frames.
+class CRenderQueue
+{
+public:
+	void Reset();
+
+	// Stores per-draw uniforms for packets to refer to, several packets may share them.  The material index is
+	// taken from each packet instead.
+	uint32_t AddDrawUniforms(const DrawUniforms& uniforms);
+	void Submit(const DrawPacket& packet);
+
+	// Sorts the packets and records them, leaving depth writes on and blending off afterwards
+	void Execute(CRenderCommandBuffer& commands);
+
+	size_t GetPacketCount() const { return m_packets.size(); }
+
+	// Key layout from the most significant bit.  Handles are truncated to their fields, which can only make
+	// packets that differ sort as if they were the same, never change what they draw.
+	//   Background and opaque: pass 4 | program 12 | texture 16 | vertex array 12 | depth 20
+	//   Transparent:           pass 4 | inverted depth 20 | program 12 | texture 16 | vertex array 12
+	static uint64_t MakeKey(const DrawPacket& packet);
+
+private:
+	struct SortEntry
+	{
+		uint64_t key;
+		uint32_t packet;
+	};
+
+	std::vector<DrawPacket> m_packets;
+	std::vector<DrawUniforms> m_drawUniforms;
+	std::vector<SortEntry> m_sorted;
+	std::vector<SortEntry> m_scratch;	// Ping-pong buffer for the radix sort
+
+	void Sort();
+	static void BeginPass(CRenderCommandBuffer& commands, RenderPass pass);
+	static uint32_t QuantiseDepth(float depth);
+};
@@ -0,0 +1,250 @@
+#include "renderthread.h"
+#include "window.h"
+#include "profiler.h"
+#include "shadercompiler.h"
+#include "vertexbufferobject.h"
+
+CRenderThread::CRenderThread()
+{
+	m_recordIndex = 0;
+	m_pWindow = nullptr;
+	m_pShaderCompiler = nullptr;
+	m_pSubmitted = nullptr;
+	m_running = false;
+	m_offscreenFramebuffer = 0;
+	m_offscreenColour = 0;
+	m_offscreenDepth = 0;
+	m_frameFence = nullptr;
+	m_collectStats = false;
+	m_frameIndex = 0;
+	for (auto& pending : m_pendingStats)
+		pending = {};
+}
+
+CRenderThread::~CRenderThread()
+{
+	Stop();
+}
+
+void CRenderThread::Start(Window& window)
+{
+	if (m_running)
+		return;
+
+	m_pWindow = &window;
+	m_running = true;
+
+	// A context can only be current on one thread at a time
+	glfwMakeContextCurrent(nullptr);
+	m_thread = std::thread(&CRenderThread::ThreadLoop, this);
+}
+
+void CRenderThread::Stop()
+{
+	if (!m_running)
+		return;
+
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_condition.wait(lock, [this] { return m_pSubmitted == nullptr; });
+		m_running = false;
+	}
+	m_condition.notify_all();
+	m_thread.join();
+
+	// Give the context back so resources can be released on the main thread
+	m_pWindow->MakeCurrent();
+}
+
+void CRenderThread::Submit()
+{
+	{
+		// The render thread may still be replaying the previous frame from the buffer we are about to reuse
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_condition.wait(lock, [this] { return m_pSubmitted == nullptr; });
+		m_pSubmitted = &m_buffers[m_recordIndex];
+		for (CVertexBufferObject* pBuffer : m_streamingBuffers)
+			pBuffer->FinishFrameWrites();
+
+		// The render thread is waiting for this frame, so programs it finished can be swapped in before we record the next
+		if (m_pShaderCompiler != nullptr)
+			m_pShaderCompiler->Publish();
+	}
+	m_condition.notify_all();
+
+	m_recordIndex ^= 1;
+	m_buffers[m_recordIndex].Reset();
+}
+
+void CRenderThread::ThreadLoop()
+{
+	m_pWindow->MakeCurrent();
+	Trace::SetThreadName("Render");
+
+	if (m_pWindow->Headless())
+		CreateOffscreenTarget(m_pWindow->GetWidth(), m_pWindow->GetHeight());
+
+	while (true) {
+		const CRenderCommandBuffer* pCommands;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_condition.wait(lock, [this] { return m_pSubmitted != nullptr || !m_running; });
+			if (m_pSubmitted == nullptr)
+				break;
+			pCommands = m_pSubmitted;
+		}
+
+		if (CProfiler* profiler = CProfiler::Get())
+			profiler->BeginGpuFrame();
+
+		// Programs finished here are published with the next submitted frame and used from the frame after it on
+		if (m_pShaderCompiler != nullptr) {
+			m_pShaderCompiler->Poll(m_deletedPrograms);
+			for (GLuint program : m_deletedPrograms)
+				m_device.ForgetProgram(program);
+			m_deletedPrograms.clear();
+		}
+
+		if (m_collectStats)
+			BeginFrameStats();
+
+		{
+			PROFILE_SCOPE("Replay");
+			for (CVertexBufferObject* pBuffer : m_streamingBuffers)
+				pBuffer->BeginFrameReads();
+			m_device.Execute(*pCommands);
+			// Waits for the GPU if it is still reading the region the main thread is about to write
+			for (CVertexBufferObject* pBuffer : m_streamingBuffers)
+				pBuffer->FinishFrameReads();
+		}
+
+		if (m_collectStats)
+			EndFrameStats();
+
+		Present();
+		m_frameIndex++;
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_pSubmitted = nullptr;
+		}
+		m_condition.notify_all();
+	}
+
+	// Wait for the frames still in flight so the stats cover every frame, oldest first
+	for (uint32_t i = 0; i < STATS_LATENCY; i++) {
+		PendingStats& pending = m_pendingStats[(m_frameIndex + i) % STATS_LATENCY];
+		ResolveFrameStats(pending);
+		if (pending.queries[0] != 0) {
+			glDeleteQueries(2, pending.queries);
+			pending.queries[0] = pending.queries[1] = 0;
+		}
+	}
+
+	m_device.Release();
+	ReleaseOffscreenTarget();
+	glfwMakeContextCurrent(nullptr);
+}
+
+std::vector<CRenderThread::FrameStats> CRenderThread::TakeFrameStats()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	std::vector<FrameStats> stats;
+	stats.swap(m_frameStats);
+	return stats;
+}
+
+// Reuses the query slot of the frame STATS_LATENCY frames ago, which the GPU has normally finished by now
+void CRenderThread::BeginFrameStats()
+{
+	PendingStats& pending = m_pendingStats[m_frameIndex % STATS_LATENCY];
+	ResolveFrameStats(pending);
+
+	if (pending.queries[0] == 0)
+		glGenQueries(2, pending.queries);
+
+	m_device.ResetStats();
+	glQueryCounter(pending.queries[0], GL_TIMESTAMP);
+}
+
+void CRenderThread::EndFrameStats()
+{
+	PendingStats& pending = m_pendingStats[m_frameIndex % STATS_LATENCY];
+	glQueryCounter(pending.queries[1], GL_TIMESTAMP);
+
+	const CRenderDevice::Stats& stats = m_device.GetStats();
+	pending.stats = {m_frameIndex, stats.drawCalls, stats.triangles, stats.stateChanges, stats.filteredStateChanges, 0.0};
+	pending.pending = true;
+}
+
+void CRenderThread::ResolveFrameStats(PendingStats& pending)
+{
+	if (!pending.pending)
+		return;
+
+	// Unlike the profiler this waits for the result if it is late, a benchmark must not lose frames
+	GLuint64 begin, end;
+	glGetQueryObjectui64v(pending.queries[0], GL_QUERY_RESULT, &begin);
+	glGetQueryObjectui64v(pending.queries[1], GL_QUERY_RESULT, &end);
+	pending.stats.gpuTime = static_cast<double>(end - begin) / 1000000.0;
+	pending.pending = false;
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_frameStats.push_back(pending.stats);
+}
+
+void CRenderThread::Present()
+{
+	if (m_offscreenFramebuffer == 0) {
+		m_pWindow->SwapBuffers();
+		return;
+	}
+
+	// Without a swap nothing throttles the driver, so keep at most one offscreen frame in flight on the GPU
+	if (m_frameFence != nullptr) {
+		glClientWaitSync(m_frameFence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+		glDeleteSync(m_frameFence);
+	}
+	m_frameFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void CRenderThread::CreateOffscreenTarget(int width, int height)
+{
+	glGenRenderbuffers(1, &m_offscreenColour);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_offscreenColour);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+	glGenRenderbuffers(1, &m_offscreenDepth);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_offscreenDepth);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+
+	glGenFramebuffers(1, &m_offscreenFramebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_offscreenFramebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_offscreenColour);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_offscreenDepth);
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+		std::cerr << "Offscreen framebuffer is incomplete, rendering to the default framebuffer" << std::endl;
+		ReleaseOffscreenTarget();
+		return;
+	}
+
+	// The command buffers never rebind the framebuffer, so it stays bound for every frame
+	std::cout << "Rendering offscreen [" << width << " " << height << "]" << std::endl;
+}
+
+void CRenderThread::ReleaseOffscreenTarget()
+{
+	if (m_frameFence != nullptr) {
+		glDeleteSync(m_frameFence);
+		m_frameFence = nullptr;
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glDeleteFramebuffers(1, &m_offscreenFramebuffer);
+	glDeleteRenderbuffers(1, &m_offscreenColour);
+	glDeleteRenderbuffers(1, &m_offscreenDepth);
+	m_offscreenFramebuffer = 0;
+	m_offscreenColour = 0;
+	m_offscreenDepth = 0;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "rendercommandbuffer.h"
+#include "renderdevice.h"
+
+class Window;
+class CShaderCompiler;
+class CVertexBufferObject;
+
+// Owns the GL context on a dedicated thread and replays the command buffers recorded by the main thread.
+// Two command buffers are used: while the render thread submits frame N to the driver, the main thread
+// simulates and records frame N+1 into the other one.
+class CRenderThread
+{
+public:
+	CRenderThread();
+	~CRenderThread();
+
+	// Moves the window's GL context from the calling thread to the render thread
+	void Start(Window& window);
+	// Waits for the last frame to be presented, stops the thread and makes the context current on the caller again
+	void Stop();
+
+	// The buffer the main thread records the current frame into
+	CRenderCommandBuffer& GetCommandBuffer() { return m_buffers[m_recordIndex]; }
+
+	// Hands the recorded frame to the render thread.  Blocks only while the previous frame is still being replayed.
+	void Submit();
+
+	struct FrameStats
+	{
+		uint32_t frame;			// Index of the frame in submission order
+		uint32_t drawCalls;
+		uint64_t triangles;
+		uint32_t stateChanges;
+		uint32_t filteredStateChanges;
+		double gpuTime;			// Milliseconds between the frame's first and last command on the GPU
+	};
+
+	// Finishes the programs built in the background before each frame, and publishes them as the next frame is
+	// submitted.  Must be called before Start.
+	void SetShaderCompiler(CShaderCompiler* pCompiler) { m_pShaderCompiler = pCompiler; }
+	// Moves a streaming vertex buffer on to its next region with every frame and keeps the main thread from writing
+	// to regions the GPU still reads.  Must be called before Start.
+	void AddStreamingBuffer(CVertexBufferObject* pBuffer) { m_streamingBuffers.push_back(pBuffer); }
+
+	// Measures every frame from now on.  Must be called before Start.
+	void EnableFrameStats() { m_collectStats = true; }
+	// Returns the stats of the frames the GPU has finished since the last call.  After Stop every frame is included.
+	std::vector<FrameStats> TakeFrameStats();
+
+private:
+	static const uint32_t STATS_LATENCY = 4;	// Frames between timing a frame on the GPU and reading the result back
+
+	struct PendingStats
+	{
+		FrameStats stats;
+		GLuint queries[2];
+		bool pending;
+	};
+
+	CRenderCommandBuffer m_buffers[2];
+	int m_recordIndex;
+
+	Window* m_pWindow;
+	CRenderDevice m_device;
+	CShaderCompiler* m_pShaderCompiler;
+	std::vector<GLuint> m_deletedPrograms;
+	std::vector<CVertexBufferObject*> m_streamingBuffers;
+	std::thread m_thread;
+
+	std::mutex m_mutex;
+	std::condition_variable m_condition;
+	const CRenderCommandBuffer* m_pSubmitted;	// Frame waiting for or being replayed, nullptr once it has been presented
+	bool m_running;
+
+	// Headless windows have nothing to present to, so frames are rendered into an offscreen framebuffer instead
+	GLuint m_offscreenFramebuffer;
+	GLuint m_offscreenColour;
+	GLuint m_offscreenDepth;
+	GLsync m_frameFence;						// Signalled when the GPU has finished the last offscreen frame
+
+	bool m_collectStats;
+	uint32_t m_frameIndex;						// Frames replayed so far, only used on the render thread
+	PendingStats m_pendingStats[STATS_LATENCY];	// Frames whose GPU timestamps have not been read back yet
+	std::vector<FrameStats> m_frameStats;		// Finished frames waiting for TakeFrameStats, guarded by m_mutex
+
+	void ThreadLoop();
+	void Present();
+	void BeginFrameStats();
+	void EndFrameStats();
+	void ResolveFrameStats(PendingStats& pending);
+	void CreateOffscreenTarget(int width, int height);
+	void ReleaseOffscreenTarget();
+};
@@ -0,0 +1,137 @@
+#include "shadercache.h"
+#include "trace.h"
+
+// Written at the start of every cache file, followed by the key, the binary format and the binary
+static const char CACHE_MAGIC[4] = {'P', 'R', 'G', '1'};
+
+CShaderCache::CShaderCache(std::filesystem::path directory)
+{
+	m_directory = std::move(directory);
+
+	// Core since 4.1, and offered as an extension by most drivers that give out the 3.3 context the window asks for.
+	// The extension has the same entry points, but the loader only fetches them for 4.1, so they are fetched here.
+	if (!GLAD_GL_VERSION_4_1 && glfwExtensionSupported("GL_ARB_get_program_binary")) {
+		glad_glGetProgramBinary = reinterpret_cast<PFNGLGETPROGRAMBINARYPROC>(glfwGetProcAddress("glGetProgramBinary"));
+		glad_glProgramBinary = reinterpret_cast<PFNGLPROGRAMBINARYPROC>(glfwGetProcAddress("glProgramBinary"));
+		glad_glProgramParameteri = reinterpret_cast<PFNGLPROGRAMPARAMETERIPROC>(glfwGetProcAddress("glProgramParameteri"));
+	}
+
+	// Drivers may support the entry points but no binary formats, e.g. some with a shader cache of their own
+	GLint iFormats = 0;
+	if (glGetProgramBinary != nullptr && glProgramBinary != nullptr && glProgramParameteri != nullptr)
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &iFormats);
+	m_bEnabled = iFormats > 0;
+
+	m_driverHash = 14695981039346656037ull;
+	for (GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+		const char* value = reinterpret_cast<const char*>(glGetString(name));
+		if (value != nullptr)
+			m_driverHash = AddToKey(m_driverHash, value, std::strlen(value) + 1);
+	}
+
+	if (!m_bEnabled) {
+		std::cout << "The driver can't save program binaries, shaders are compiled on every run" << std::endl;
+		return;
+	}
+
+	std::error_code error;
+	std::filesystem::create_directories(m_directory, error);
+	if (error) {
+		std::cerr << "Can't create the shader cache " << m_directory << ": " << error.message() << std::endl;
+		m_bEnabled = false;
+	}
+}
+
+// 64-bit FNV-1a
+uint64_t CShaderCache::AddToKey(uint64_t key, const void* data, size_t size)
+{
+	const auto* bytes = static_cast<const uint8_t*>(data);
+	for (size_t i = 0; i < size; i++) {
+		key ^= bytes[i];
+		key *= 1099511628211ull;
+	}
+	return key;
+}
+
+std::filesystem::path CShaderCache::GetPath(uint64_t key) const
+{
+	char name[32];
+	std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+	return m_directory / name;
+}
+
+bool CShaderCache::Load(uint64_t key, GLuint program) const
+{
+	TRACE_SCOPE("CShaderCache::Load");
+
+	if (!m_bEnabled)
+		return false;
+
+	std::ifstream file(GetPath(key), std::ios::binary);
+	if (!file)
+		return false;
+
+	char magic[sizeof(CACHE_MAGIC)];
+	uint64_t storedKey = 0;
+	GLenum format = 0;
+	file.read(magic, sizeof(magic));
+	file.read(reinterpret_cast<char*>(&storedKey), sizeof(storedKey));
+	file.read(reinterpret_cast<char*>(&format), sizeof(format));
+	if (!file || std::memcmp(magic, CACHE_MAGIC, sizeof(magic)) != 0 || storedKey != key)
+		return false;
+
+	// The binary is the rest of the file
+	const std::streamoff headerSize = file.tellg();
+	file.seekg(0, std::ios::end);
+	const std::streamoff binarySize = file.tellg() - headerSize;
+	if (!file || binarySize <= 0)
+		return false;
+
+	std::vector<char> binary(static_cast<size_t>(binarySize));
+	file.seekg(headerSize);
+	file.read(binary.data(), binarySize);
+	if (!file)
+		return false;
+
+	// The driver may refuse a binary even for the same version string, e.g. after a change in its configuration
+	glProgramBinary(program, format, binary.data(), static_cast<GLsizei>(binary.size()));
+	GLint iLinkStatus = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &iLinkStatus);
+	return iLinkStatus == GL_TRUE;
+}
+
+void CShaderCache::Store(uint64_t key, GLuint program) const
+{
+	if (!m_bEnabled)
+		return;
+
+	GLint iLength = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &iLength);
+	if (iLength <= 0)
+		return;
+
+	std::vector<char> binary(static_cast<size_t>(iLength));
+	GLenum format = 0;
+	glGetProgramBinary(program, iLength, &iLength, &format, binary.data());
+
+	// Written next to the final file and renamed, so a run that is killed half way never leaves a truncated entry
+	std::filesystem::path path = GetPath(key);
+	std::filesystem::path tempPath = path;
+	tempPath += ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		file.write(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+		file.write(reinterpret_cast<const char*>(&key), sizeof(key));
+		file.write(reinterpret_cast<const char*>(&format), sizeof(format));
+		file.write(binary.data(), iLength);
+		if (!file) {
+			std::cerr << "Can't write the shader cache entry " << tempPath << std::endl;
+			return;
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::rename(tempPath, path, error);
+	if (error)
+		std::cerr << "Can't write the shader cache entry " << path << ": " << error.message() << std::endl;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+// Stores linked program binaries on disk so later runs skip compiling and linking.  Entries are keyed by a hash of
+// everything the binary depends on: the shader sources, their defines and the driver that produced it.  A driver
+// update changes the key, and binaries the driver rejects anyway are rebuilt and replaced.
+class CShaderCache
+{
+public:
+	// Must be created with the GL context current
+	explicit CShaderCache(std::filesystem::path directory);
+
+	// False if the driver can't save program binaries, Load and Store then do nothing
+	bool IsEnabled() const { return m_bEnabled; }
+
+	// Starts a key with the driver's vendor, renderer and version, continue it with AddToKey
+	uint64_t BeginKey() const { return m_driverHash; }
+	static uint64_t AddToKey(uint64_t key, const void* data, size_t size);
+	static uint64_t AddToKey(uint64_t key, const std::string& data) { return AddToKey(key, data.data(), data.size()); }
+
+	// Loads the binary stored under key into program, returns false if there is none or the driver rejects it
+	bool Load(uint64_t key, GLuint program) const;
+	// Saves the binary of a linked program.  It must have been linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set.
+	void Store(uint64_t key, GLuint program) const;
+
+private:
+	std::filesystem::path m_directory;
+	uint64_t m_driverHash;
+	bool m_bEnabled;
+
+	std::filesystem::path GetPath(uint64_t key) const;
+};
@@ -0,0 +1,93 @@
+#include "shadercompiler.h"
+#include "shaders.h"
+#include "trace.h"
+
+// The loader is generated without extensions, so the entry point is fetched by hand
+using MaxShaderCompilerThreadsProc = void (APIENTRYP)(GLuint count);
+
+CShaderCompiler::CShaderCompiler()
+{
+	const char* setThreads = nullptr;
+	if (glfwExtensionSupported("GL_KHR_parallel_shader_compile"))
+		setThreads = "glMaxShaderCompilerThreadsKHR";
+	else if (glfwExtensionSupported("GL_ARB_parallel_shader_compile"))
+		setThreads = "glMaxShaderCompilerThreadsARB";
+	m_bParallel = setThreads != nullptr;
+
+	// Some drivers only compile on their own threads once asked to, 0xFFFFFFFF lets them choose how many
+	if (m_bParallel) {
+		auto maxShaderCompilerThreads = reinterpret_cast<MaxShaderCompilerThreadsProc>(glfwGetProcAddress(setThreads));
+		if (maxShaderCompilerThreads != nullptr)
+			maxShaderCompilerThreads(0xFFFFFFFF);
+	}
+}
+
+void CShaderCompiler::Add(CShaderProgram* pProgram)
+{
+	m_pending.push_back(pProgram);
+}
+
+void CShaderCompiler::Request(CShaderProgram* pProgram)
+{
+	m_requested.push_back(pProgram);
+}
+
+void CShaderCompiler::Publish()
+{
+	for (CShaderProgram* pProgram : m_finished) {
+		if (pProgram->Publish() != 0)
+			m_retired.push_back({pProgram, RETIRE_FRAMES});
+	}
+	m_finished.clear();
+
+	m_submitting.insert(m_submitting.end(), m_requested.begin(), m_requested.end());
+	m_requested.clear();
+}
+
+void CShaderCompiler::Poll(std::vector<GLuint>& deletedPrograms)
+{
+	for (RetiredProgram& retired : m_retired) {
+		if (--retired.framesLeft == 0)
+			deletedPrograms.push_back(retired.pProgram->DeleteRetiredProgram());
+	}
+	m_retired.erase(std::remove_if(m_retired.begin(), m_retired.end(), [](const RetiredProgram& retired) { return retired.framesLeft == 0; }),
+					m_retired.end());
+
+	for (CShaderProgram* pProgram : m_submitting) {
+		pProgram->SubmitRebuild();
+		m_pending.push_back(pProgram);
+	}
+	m_submitting.clear();
+
+	if (m_pending.empty())
+		return;
+
+	TRACE_SCOPE("CShaderCompiler::Poll");
+
+	if (!m_bParallel) {
+		auto start = std::chrono::steady_clock::now();
+		size_t finished = 0;
+		do {
+			Finish(m_pending[finished++]);
+		} while (finished < m_pending.size() && std::chrono::steady_clock::now() - start < POLL_BUDGET);
+		m_pending.erase(m_pending.begin(), m_pending.begin() + finished);
+		return;
+	}
+
+	auto done = std::remove_if(m_pending.begin(), m_pending.end(), [this](CShaderProgram* pProgram) {
+		GLint iComplete = GL_FALSE;
+		glGetProgramiv(pProgram->GetBuildProgramID(), COMPLETION_STATUS, &iComplete);
+		if (iComplete == GL_FALSE)
+			return false;
+		Finish(pProgram);
+		return true;
+	});
+	m_pending.erase(done, m_pending.end());
+}
+
+// Failed builds are published as well, which lets the main thread rebuild the program again
+void CShaderCompiler::Finish(CShaderProgram* pProgram)
+{
+	pProgram->FinishBuild();
+	m_finished.push_back(pProgram);
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+class CShaderProgram;
+
+// Lets programs compile and link in the background.  Programs are submitted with CShaderProgram::Build without
+// checking their status, which would make the driver finish each compile before the next one starts.  Poll then
+// finishes the ones that are done.
+// With GL_KHR_parallel_shader_compile the driver compiles on its own threads and Poll never blocks.  Without it every
+// status query waits for its program, so Poll finishes programs until POLL_BUDGET is spent and leaves the rest for the
+// next frames.
+// Finished programs aren't drawn with straight away.  Publish swaps them in between two recorded frames, so the main
+// thread never sees a program change while it records a frame.
+class CShaderCompiler
+{
+public:
+	// Must be created with the GL context current
+	CShaderCompiler();
+
+	bool IsParallel() const { return m_bParallel; }
+
+	// Called by CShaderProgram::Build for programs whose link has been submitted
+	void Add(CShaderProgram* pProgram);
+	// Called by CShaderProgram::Rebuild on the main thread for programs whose sources have been prepared.  Poll
+	// hands them to the driver once Publish has passed them on.
+	void Request(CShaderProgram* pProgram);
+
+	// Finishes the programs the driver has completed.  Call once per frame, between frames, on the thread that owns
+	// the GL context.  Programs replaced by a rebuild are deleted a few frames later, their IDs are appended to
+	// deletedPrograms so anything else keeping state per program can drop it.
+	void Poll(std::vector<GLuint>& deletedPrograms);
+
+	// Publishes the programs finished since the last call and passes on the rebuilds requested since.  Call between
+	// recording two frames while the GL thread isn't polling or replaying, e.g. under the frame handoff lock.
+	void Publish();
+
+private:
+	static const GLenum COMPLETION_STATUS = 0x91B1;		// GL_COMPLETION_STATUS_KHR, not in the generated loader
+	// Time Poll may spend waiting for programs per frame without parallel compiles.  At least one program is finished
+	// per call, however long it takes.
+	static constexpr std::chrono::microseconds POLL_BUDGET{2000};
+
+	// Programs are published as a frame is submitted, and that frame was recorded with the replaced program.  It is
+	// deleted by the Poll before the frame after it, counting the Poll before the submitted frame as the first.
+	static const int RETIRE_FRAMES = 2;
+
+	struct RetiredProgram
+	{
+		CShaderProgram* pProgram;	// Whose replaced program is deleted
+		int framesLeft;
+	};
+
+	bool m_bParallel;
+	std::vector<CShaderProgram*> m_requested;	// Main thread side, waiting for Publish
+	std::vector<CShaderProgram*> m_submitting;	// Passed on by Publish, waiting for Poll to hand them to the driver
+	std::vector<CShaderProgram*> m_pending;
+	std::vector<CShaderProgram*> m_finished;	// Waiting for Publish
+	std::vector<RetiredProgram> m_retired;
+
+	void Finish(CShaderProgram* pProgram);
+};
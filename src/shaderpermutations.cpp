@@ -0,0 +1,62 @@
+#include "shaderpermutations.h"
+#include "shaders.h"
+
+CShaderPermutations::CShaderPermutations(std::vector<std::string> files, std::vector<std::string> features, const CShaderCache* pCache,
+										 CShaderCompiler* pCompiler, CShaderPermutations* pPlaceholders)
+{
+	m_files = std::move(files);
+	m_features = std::move(features);
+	m_pCache = pCache;
+	m_pCompiler = pCompiler;
+	m_pPlaceholders = pPlaceholders;
+	assert(m_features.size() <= 32 && "A feature mask has 32 bits");
+}
+
+CShaderPermutations::~CShaderPermutations()
+{
+	for (auto& [features, pProgram] : m_programs)
+		delete pProgram;
+}
+
+CShaderProgram* CShaderPermutations::Prepare(uint32_t features)
+{
+	auto [it, inserted] = m_programs.try_emplace(features, nullptr);
+	if (!inserted)
+		return it->second;
+
+	std::vector<std::string> defines;
+	for (size_t i = 0; i < m_features.size(); i++) {
+		if (features & (1u << i))
+			defines.push_back(m_features[i]);
+	}
+
+	auto* pProgram = new CShaderProgram;
+	if (m_pPlaceholders != nullptr)
+		pProgram->SetPlaceholder(m_pPlaceholders->Prepare(GetPlaceholderFeatures(features)));
+	pProgram->Build(m_files, defines, m_pCache, m_pCompiler);
+	it->second = pProgram;
+	return pProgram;
+}
+
+// Translates a feature mask into the placeholder family's bits, by define name.  Features it doesn't have are dropped.
+uint32_t CShaderPermutations::GetPlaceholderFeatures(uint32_t features) const
+{
+	const std::vector<std::string>& placeholderFeatures = m_pPlaceholders->m_features;
+
+	uint32_t mask = 0;
+	for (size_t i = 0; i < m_features.size(); i++) {
+		if (!(features & (1u << i)))
+			continue;
+		auto it = std::find(placeholderFeatures.begin(), placeholderFeatures.end(), m_features[i]);
+		if (it != placeholderFeatures.end())
+			mask |= 1u << (it - placeholderFeatures.begin());
+	}
+	return mask;
+}
+
+CShaderProgram* CShaderPermutations::Get(uint32_t features) const
+{
+	auto it = m_programs.find(features);
+	assert(it != m_programs.end() && "Shader variant wasn't prepared");
+	return it != m_programs.end() ? it->second : nullptr;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+class CShaderProgram;
+class CShaderCache;
+class CShaderCompiler;
+
+// A family of programs built from the same shader files with different features switched on.  Each feature is a bit
+// of a mask and a #define in the sources, so every variant only contains the code for its own features instead of
+// branching on uniforms for every vertex and fragment.
+class CShaderPermutations
+{
+public:
+	// features[i] is the name of the define switched on by bit i.  Variants built in the background draw with the
+	// placeholder variant that has the features both families know, e.g. the same vertex layout, until they are
+	// ready.  The placeholders should be built without a compiler so they are ready right away.
+	CShaderPermutations(std::vector<std::string> files, std::vector<std::string> features, const CShaderCache* pCache,
+						CShaderCompiler* pCompiler, CShaderPermutations* pPlaceholders = nullptr);
+	~CShaderPermutations();
+
+	// Builds the variant with the given features, unless it has been built already.  Building needs the GL context,
+	// so every variant that will be drawn with has to be prepared before rendering moves to the render thread.
+	CShaderProgram* Prepare(uint32_t features);
+
+	// Returns a variant built by Prepare
+	CShaderProgram* Get(uint32_t features) const;
+	const std::unordered_map<uint32_t, CShaderProgram*>& GetPrograms() const { return m_programs; }
+
+private:
+	std::vector<std::string> m_files;
+	std::vector<std::string> m_features;
+	const CShaderCache* m_pCache;
+	CShaderCompiler* m_pCompiler;
+	CShaderPermutations* m_pPlaceholders;
+	std::unordered_map<uint32_t, CShaderProgram*> m_programs;	// By feature mask
+
+	uint32_t GetPlaceholderFeatures(uint32_t features) const;
+};
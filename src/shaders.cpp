@@ -1,7 +1,14 @@
 #include "shaders.h"
+#include "glstatecache.h"
+#include "rendercommandbuffer.h"
+#include "shadercache.h"
+#include "shadercompiler.h"
+#include "trace.h"
 
 CShader::CShader()
 {
+	m_uiShader = 0;
+	m_iType = 0;
 	m_bLoaded = false;
 }
 
@@ -10,14 +17,37 @@ CShader::~CShader()
 
 // Loads a shader, stored as a text file with filename sFile.  The shader is of type iType (vertex, fragment, geometry, etc.)
 bool CShader::LoadShader(const std::string& sFile, int iType)
+{
+    TRACE_SCOPE("CShader::LoadShader");
+
+    std::string sSource;
+    if (!Preprocess(sFile, {}, sSource))
+        return false;
+    return CompileShader(sSource, iType, sFile);
+}
+
+// Compiles a shader from source.  sName identifies it in error messages.
+bool CShader::CompileShader(const std::string& sSource, int iType, const std::string& sName)
+{
+	SubmitShader(sSource, iType);
+	return CheckCompiled(sName);
+}
+
+// Starts compiling a shader without waiting for the result, see CheckCompiled
+void CShader::SubmitShader(const std::string& sSource, int iType)
 {
     m_uiShader = glCreateShader(iType);
+	m_iType = iType;
 
-    std::string sShaderCode = ReadFile(sFile);
-    const GLchar* code = sShaderCode.c_str();
+    const GLchar* code = sSource.c_str();
     glShaderSource(m_uiShader, 1, &code, nullptr);
 	glCompileShader(m_uiShader);
+}
 
+// Waits for a submitted shader to compile, prints the log if it failed
+bool CShader::CheckCompiled(const std::string& sName)
+{
+	int iType = m_iType;
     GLint iCompilationStatus;
 	glGetShaderiv(m_uiShader, GL_COMPILE_STATUS, &iCompilationStatus);
 
@@ -40,28 +70,103 @@ bool CShader::LoadShader(const std::string& sFile, int iType)
 		else
             sShaderType = "unknown shader type";
 
-		std::cout << "Error in " << sShaderType << '\n' << sFile << '\n' << "Shader file not compiled. The compiler returned:\n\n" << sInfoLog << std::endl;
+		std::cout << "Error in " << sShaderType << '\n' << sName << '\n' << "Shader file not compiled. The compiler returned:\n\n" << sInfoLog << std::endl;
 		return false;
 	}
-	m_iType = iType;
 	m_bLoaded = true;
 
 	return true;
 }
 
-// Loads a file into a vector of std::strings (vResult)
-std::string CShader::ReadFile(const std::string& path)
+// Returns the type of a shader from the extension of its file name
+int CShader::GetShaderType(const std::string& sFile)
+{
+	std::string sExt = sFile.substr(sFile.size() >= 4 ? sFile.size() - 4 : 0);
+	if (sExt == "vert") return GL_VERTEX_SHADER;
+	else if (sExt == "frag") return GL_FRAGMENT_SHADER;
+	else if (sExt == "geom") return GL_GEOMETRY_SHADER;
+	else if (sExt == "tcnl") return GL_TESS_CONTROL_SHADER;
+	else return GL_TESS_EVALUATION_SHADER;
+}
+
+// Reads a whole file into sContents, returns false if it can't be opened
+bool CShader::ReadFile(const std::string& path, std::string& sContents)
 {
     std::ifstream file(path);
-    if (file) {
-        std::stringstream stream;
-        stream << file.rdbuf();
-        file.close();
-        return stream.str();
-    } else {
-        std::cerr << "Can't open file: " << path << std::endl;
-        std::abort();
+    if (!file) {
+        std::cerr << "Error! Can't open file: " << path << std::endl;
+        return false;
     }
+
+    std::stringstream stream;
+    stream << file.rdbuf();
+    sContents = stream.str();
+    return true;
+}
+
+// Reads a shader file and resolves its #include "file" directives, which are relative to the including file.  A
+// #define for each of defines is added after the #version line, which has to be the first line of the file.  The
+// paths of the included files are appended to pIncludes if it isn't null, also when preprocessing fails, so a
+// missing include is watched for.  Returns false if a file can't be read or a directive is malformed.
+bool CShader::Preprocess(const std::string& sFile, const std::vector<std::string>& defines, std::string& sOutput,
+						 std::vector<std::string>* pIncludes)
+{
+	std::string sSource;
+	if (!ReadFile(sFile, sSource))
+		return false;
+
+	size_t versionEnd = sSource.find('\n');
+	if (sSource.compare(0, 8, "#version") != 0 || versionEnd == std::string::npos) {
+		std::cerr << "Error! " << sFile << " doesn't start with a #version line" << std::endl;
+		return false;
+	}
+	versionEnd++;
+
+	sOutput = sSource.substr(0, versionEnd);
+	for (const std::string& define : defines)
+		sOutput += "#define " + define + '\n';
+	sOutput += "#line 2\n";
+	return AppendSource(sSource.substr(versionEnd), std::filesystem::path(sFile).parent_path(), 2, 0, sOutput, pIncludes);
+}
+
+// Appends source line by line, replacing each #include with the file's contents.  Line numbers are reset after an
+// include so compiler errors point at the right line of the including file.  Returns false on the first include
+// that can't be resolved.
+bool CShader::AppendSource(const std::string& sSource, const std::filesystem::path& directory, int iFirstLine, int iDepth, std::string& sOutput,
+						   std::vector<std::string>* pIncludes)
+{
+	std::istringstream stream(sSource);
+	std::string sLine;
+	for (int iLine = iFirstLine; std::getline(stream, sLine); iLine++) {
+		if (sLine.compare(0, 8, "#include") != 0) {
+			sOutput += sLine;
+			sOutput += '\n';
+			continue;
+		}
+
+		size_t first = sLine.find('"');
+		size_t last = sLine.rfind('"');
+		if (first == std::string::npos || last <= first) {
+			std::cerr << "Error! Malformed #include: " << sLine << std::endl;
+			return false;
+		}
+		if (iDepth >= MAX_INCLUDE_DEPTH) {
+			std::cerr << "Error! Includes nested too deeply at " << sLine << ", is a file including itself?" << std::endl;
+			return false;
+		}
+
+		std::filesystem::path path = directory / sLine.substr(first + 1, last - first - 1);
+		if (pIncludes != nullptr)
+			pIncludes->push_back(path.string());
+		std::string sInclude;
+		if (!ReadFile(path.string(), sInclude))
+			return false;
+		sOutput += "#line 1\n";
+		if (!AppendSource(sInclude, path.parent_path(), 1, iDepth + 1, sOutput, pIncludes))
+			return false;
+		sOutput += "#line " + std::to_string(iLine + 1) + '\n';
+	}
+	return true;
 }
 
 // Returns true if the shader was loaded and compiled
@@ -79,15 +184,30 @@ GLuint CShader::GetShaderID()
 // Deletes the shader and frees GPU memory
 void CShader::DeleteShader()
 {
-	if(!IsLoaded())
+	if(m_uiShader == 0)
 		return;
 	m_bLoaded = false;
 	glDeleteShader(m_uiShader);
+	m_uiShader = 0;
 }
 
+// Linked programs by GL ID, so the render device can find the table of the program a command uses.  Only touched on
+// the thread that owns the GL context.
+static std::unordered_map<GLuint, CShaderProgram*> s_programs;
+
 CShaderProgram::CShaderProgram()
 {
+	m_uiProgram = 0;
+	m_uiRetiredProgram = 0;
 	m_bLinked = false;
+	m_pPlaceholder = nullptr;
+	m_pCache = nullptr;
+	m_uiBuildProgram = 0;
+	m_pendingKey = 0;
+	m_pPendingCache = nullptr;
+	m_buildKey = 0;
+	m_uiFinishedProgram = 0;
+	m_bBuilding = false;
 }
 
 // Creates a new shader program
@@ -111,36 +231,314 @@ bool CShaderProgram::AddShaderToProgram(CShader* shShader)
 bool CShaderProgram::LinkProgram()
 {
 	glLinkProgram(m_uiProgram);
+	if (!CheckLinked(m_uiProgram))
+		return false;
+
+	OnLinked(m_uiProgram, m_uniforms);
+	m_bLinked.store(true, std::memory_order_release);
+	return true;
+}
+
+// Waits for the link to finish, prints the log if it failed
+bool CShaderProgram::CheckLinked(GLuint uiProgram)
+{
 	int iLinkStatus;
-	glGetProgramiv(m_uiProgram, GL_LINK_STATUS, &iLinkStatus);
+	glGetProgramiv(uiProgram, GL_LINK_STATUS, &iLinkStatus);
 
 	if (iLinkStatus == GL_FALSE) 
 	{
         int iLogLength;
         char sInfoLog[1024];
-		glGetProgramInfoLog(m_uiProgram, 1024, &iLogLength, sInfoLog);
+		glGetProgramInfoLog(uiProgram, 1024, &iLogLength, sInfoLog);
 		std::cerr << "Error! Shader program wasn't linked! The linker returned: " << sInfoLog << std::endl;
 		return false;
 	}
+	return true;
+}
+
+// Sets up the state every linked program needs, whether it was linked from source or loaded as a binary.  The
+// uniforms are reflected into the table that goes with the program once it is published.
+void CShaderProgram::OnLinked(GLuint uiProgram, CUniformTable& uniforms)
+{
+	BindUniformBlocks(uiProgram);
+	uniforms.Reflect(uiProgram);
+	s_programs[uiProgram] = this;
+}
+
+// Creates and links a program from shader files, whose types are taken from their extensions, with the given defines.
+// With a cache, the binary linked by an earlier run is loaded instead when the preprocessed sources, which include
+// the defines and included files, and the driver haven't changed.  With a compiler, Build returns as soon as the
+// work has been handed to the driver.  The program is finished later by CShaderCompiler::Poll and published between
+// two frames, until then drawing with it uses the placeholder.  The result is only known without one.
+bool CShaderProgram::Build(const std::vector<std::string>& files, const std::vector<std::string>& defines,
+						   const CShaderCache* pCache, CShaderCompiler* pCompiler)
+{
+	m_files = files;
+	m_defines = defines;
+	m_pCache = pCache;
+
+	CreateProgram();
+	if (!PrepareBuild())
+		return false;
+
+	m_uiBuildProgram = m_uiProgram;
+	SubmitBuild();
+
+	if (pCompiler != nullptr) {
+		m_bBuilding = true;
+		pCompiler->Add(this);
+		return true;
+	}
+
+	bool bLinked = FinishBuild();
+	Publish();
+	return bLinked;
+}
+
+// Builds the program again from the same files into a new GL program.  Runs on the main thread, which reads and
+// preprocesses the files, and leaves the GL work to the compiler on the thread that owns the context.  The current
+// program stays in use until the new one is published, and is kept if the new one fails.  Returns false if a build
+// is already in progress or the files can't be preprocessed, which also keeps the current one.
+bool CShaderProgram::Rebuild(CShaderCompiler& compiler)
+{
+	if (IsBuilding())
+		return false;
+
+	// Nothing is compiled from incomplete sources, e.g. a file saved half way.  The next change to one of the files
+	// tries again.
+	if (!PrepareBuild()) {
+		std::cerr << "Keeping the previous version of " << m_files.front() << std::endl;
+		return false;
+	}
+
+	m_bBuilding = true;
+	compiler.Request(this);
+	return true;
+}
+
+// Starts a rebuild prepared by Rebuild.  Called by CShaderCompiler::Poll on the thread that owns the GL context.
+void CShaderProgram::SubmitRebuild()
+{
+	m_uiBuildProgram = glCreateProgram();
+	SubmitBuild();
+}
+
+// Returns true if the program is built from the file, directly or through an #include
+bool CShaderProgram::DependsOn(const std::filesystem::path& file) const
+{
+	return std::find(m_dependencies.begin(), m_dependencies.end(), file) != m_dependencies.end();
+}
+
+// Reads and preprocesses the files and works out the cache key, everything a build does before GL is involved
+bool CShaderProgram::PrepareBuild()
+{
+	TRACE_SCOPE("CShaderProgram::PrepareBuild");
+
+	std::vector<std::string> sources;
+	std::vector<std::string> includes;
+	uint64_t key = m_pCache != nullptr ? m_pCache->BeginKey() : 0;
+	bool bPreprocessed = true;
+	for (const std::string& file : m_files) {
+		int iType = CShader::GetShaderType(file);
+		sources.emplace_back();
+		bPreprocessed = CShader::Preprocess(file, m_defines, sources.back(), &includes) && bPreprocessed;
+		key = CShaderCache::AddToKey(key, &iType, sizeof(iType));
+		key = CShaderCache::AddToKey(key, sources.back());
+		includes.push_back(file);
+	}
+
+	// Canonical, so paths reported by a file watcher can be compared with them
+	m_dependencies.clear();
+	for (const std::string& file : includes) {
+		std::error_code error;
+		m_dependencies.push_back(std::filesystem::weakly_canonical(file, error));
+	}
+
+	if (!bPreprocessed)
+		return false;
+
+	m_buildSources = std::move(sources);
+	m_buildKey = key;
+	return true;
+}
+
+// Hands the prepared sources of m_uiBuildProgram to the driver
+void CShaderProgram::SubmitBuild()
+{
+	TRACE_SCOPE("CShaderProgram::Build");
+
+	// A binary from the cache is already linked and goes through the same checks as a program linked from source
+	if (m_pCache == nullptr || !m_pCache->Load(m_buildKey, m_uiBuildProgram)) {
+		// Nothing below asks for a status, so the driver is free to work on all of it at once
+		m_pendingShaders.resize(m_files.size());
+		for (size_t i = 0; i < m_files.size(); i++) {
+			m_pendingShaders[i].SubmitShader(m_buildSources[i], CShader::GetShaderType(m_files[i]));
+			glAttachShader(m_uiBuildProgram, m_pendingShaders[i].GetShaderID());
+		}
+
+		// The hint has to be given before linking for the binary to be retrievable
+		if (m_pCache != nullptr && m_pCache->IsEnabled()) {
+			glProgramParameteri(m_uiBuildProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+			m_pendingKey = m_buildKey;
+			m_pPendingCache = m_pCache;
+		}
+		glLinkProgram(m_uiBuildProgram);
+	}
+
+	m_buildSources.clear();
+}
+
+// Checks the result of a build handed to the driver, waiting for it if it hasn't finished yet.  A program that
+// linked is kept for Publish to swap in, one that didn't is deleted unless it is the program's first build.
+bool CShaderProgram::FinishBuild()
+{
+	// Every shader is checked so all their errors are printed, not just the first
+	bool bCompiled = true;
+	for (size_t i = 0; i < m_pendingShaders.size(); i++)
+		bCompiled = m_pendingShaders[i].CheckCompiled(m_files[i]) && bCompiled;
+
+	bool bLinked = bCompiled && CheckLinked(m_uiBuildProgram);
+	if (bLinked && m_pPendingCache != nullptr)
+		m_pPendingCache->Store(m_pendingKey, m_uiBuildProgram);
+
+	// The linked program keeps everything it needs from the shaders
+	for (CShader& shader : m_pendingShaders) {
+		glDetachShader(m_uiBuildProgram, shader.GetShaderID());
+		shader.DeleteShader();
+	}
+	m_pendingShaders.clear();
+	m_pPendingCache = nullptr;
+
+	GLuint uiBuilt = m_uiBuildProgram;
+	m_uiBuildProgram = 0;
+	if (uiBuilt == m_uiProgram) {
+		if (bLinked) {
+			OnLinked(uiBuilt, m_uniforms);
+			m_uiFinishedProgram = uiBuilt;
+		}
+		return bLinked;
+	}
+
+	if (!bLinked) {
+		std::cerr << "Keeping the previous version of " << m_files.front() << std::endl;
+		glDeleteProgram(uiBuilt);
+		return false;
+	}
+
+	OnLinked(uiBuilt, m_finishedUniforms);
+	m_uiFinishedProgram = uiBuilt;
+	return true;
+}
+
+// Makes the program finished by the last build the one that is drawn with.  Called between recording two frames
+// while the GL thread isn't replaying, see CShaderCompiler::Publish, so every frame draws with a single version of
+// the program.  When a rebuild replaces the current program its ID is returned, and the program is kept until
+// DeleteRetiredProgram, as the frame submitted with the swap still uses it.  Otherwise 0 is returned.
+GLuint CShaderProgram::Publish()
+{
+	GLuint uiFinished = m_uiFinishedProgram;
+	m_uiFinishedProgram = 0;
+	m_bBuilding = false;
+
+	if (uiFinished == 0)
+		return 0;
+
+	if (uiFinished == m_uiProgram) {
+		m_bLinked.store(true, std::memory_order_release);
+		return 0;
+	}
 
-	m_bLinked = iLinkStatus == GL_TRUE;
-	return m_bLinked;
+	assert(m_uiRetiredProgram == 0 && "The program replaced by the previous rebuild hasn't been deleted yet");
+	GLuint uiReplaced = m_uiProgram;
+	m_uiRetiredProgram = uiReplaced;
+	m_retiredUniforms = std::move(m_uniforms);
+	m_uniforms = std::move(m_finishedUniforms);
+	m_finishedUniforms = CUniformTable{};
+	m_uiProgram.store(uiFinished, std::memory_order_release);
+	std::cout << "Reloaded " << m_files.front() << std::endl;
+	return uiReplaced;
 }
 
 // Deletes the program and frees memory on the GPU
 void CShaderProgram::DeleteProgram()
 {
+	if (m_uiBuildProgram != 0 && m_uiBuildProgram != m_uiProgram)
+		glDeleteProgram(m_uiBuildProgram);
+	m_uiBuildProgram = 0;
+
+	// A build that finished but was never published
+	if (m_uiFinishedProgram != 0 && m_uiFinishedProgram == m_uiProgram) {
+		m_bLinked = true;
+	} else if (m_uiFinishedProgram != 0) {
+		m_finishedUniforms.Clear();
+		s_programs.erase(m_uiFinishedProgram);
+		glDeleteProgram(m_uiFinishedProgram);
+	}
+	m_uiFinishedProgram = 0;
+	m_bBuilding = false;
+
+	DeleteRetiredProgram();
+
 	if(!m_bLinked)
 		return;
 	m_bLinked = false;
+	m_uniforms.Clear();
+	s_programs.erase(m_uiProgram);
+	CGLStateCache::Get().ForgetProgram(m_uiProgram);
 	glDeleteProgram(m_uiProgram);
 }
 
+GLuint CShaderProgram::DeleteRetiredProgram()
+{
+	GLuint uiRetired = m_uiRetiredProgram;
+	if (uiRetired == 0)
+		return 0;
+
+	m_uiRetiredProgram = 0;
+	m_retiredUniforms.Clear();
+	s_programs.erase(uiRetired);
+	CGLStateCache::Get().ForgetProgram(uiRetired);
+	glDeleteProgram(uiRetired);
+	return uiRetired;
+}
+
+CUniformTable* CShaderProgram::FindUniforms(GLuint uiProgram)
+{
+	auto it = s_programs.find(uiProgram);
+	if (it == s_programs.end())
+		return nullptr;
+
+	CShaderProgram* pProgram = it->second;
+	if (uiProgram == pProgram->m_uiRetiredProgram)
+		return &pProgram->m_retiredUniforms;
+	if (uiProgram != pProgram->m_uiProgram)
+		return &pProgram->m_finishedUniforms;
+	return &pProgram->m_uniforms;
+}
+
 // Instructs OpenGL to use this program
 void CShaderProgram::UseProgram()
 {
 	if(m_bLinked)
-		glUseProgram(m_uiProgram);
+		CGLStateCache::Get().UseProgram(m_uiProgram);
+}
+
+// Records using this program, subsequent uniforms recorded into the buffer apply to it.  While the program is
+// still being built the placeholder is used, or no program at all, which makes the device skip the draws.
+void CShaderProgram::UseProgram(CRenderCommandBuffer& commands) const
+{
+	commands.UseProgram(GetDrawProgram());
+}
+
+// Returns the handle draws are recorded with, the placeholder's or 0 while the program is still being built
+uint32_t CShaderProgram::GetDrawProgram() const
+{
+	if(m_bLinked.load(std::memory_order_acquire))
+		return m_uiProgram.load(std::memory_order_acquire);
+	else if(m_pPlaceholder != nullptr)
+		return m_pPlaceholder->GetDrawProgram();
+	else
+		return 0;
 }
 
 // Returns the OpenGL program ID
@@ -149,98 +547,92 @@ GLuint CShaderProgram::GetProgramID()
 	return m_uiProgram;
 }
 
-// A collection of functions to set uniform variables inside shaders
+// A collection of functions to set uniform variables inside shaders.  Names are looked up in the table reflected at
+// link time and values equal to the last upload are skipped.
+
+void CShaderProgram::SetUniformData(UniformName name, UniformType type, const void* data, int iCount) const
+{
+	int index = m_uniforms.Find(name);
+	if (index >= 0)
+		m_uniforms.Set(index, type, data, iCount);
+}
 
 // Setting floats
 
-void CShaderProgram::SetUniform(const std::string& sName, float* fValues, int iCount) const
+void CShaderProgram::SetUniform(UniformName name, float* fValues, int iCount) const
 {
-	int iLoc = glGetUniformLocation(m_uiProgram, sName.c_str());
-	glUniform1fv(iLoc, iCount, fValues);
+	SetUniformData(name, UniformType::Float, fValues, iCount);
 }
 
-void CShaderProgram::SetUniform(const std::string& sName, const float fValue) const
+void CShaderProgram::SetUniform(UniformName name, const float fValue) const
 {
-	int iLoc = glGetUniformLocation(m_uiProgram, sName.c_str());
-	glUniform1fv(iLoc, 1, &fValue);
+	SetUniformData(name, UniformType::Float, &fValue, 1);
 }
 
 // Setting vectors
 
-void CShaderProgram::SetUniform(const std::string& sName, glm::vec2* vVectors, int iCount) const
+void CShaderProgram::SetUniform(UniformName name, glm::vec2* vVectors, int iCount) const
 {
-	int iLoc = glGetUniformLocation(m_uiProgram, sName.c_str());
-	glUniform2fv(iLoc, iCount, (GLfloat*)vVectors);
+	SetUniformData(name, UniformType::Vec2, vVectors, iCount);
 }
 
-void CShaderProgram::SetUniform(const std::string& sName, const glm::vec2& vVector) const
+void CShaderProgram::SetUniform(UniformName name, const glm::vec2& vVector) const
 {
-	int iLoc = glGetUniformLocation(m_uiProgram, sName.c_str());
-	glUniform2fv(iLoc, 1, (GLfloat*)&vVector);
+	SetUniformData(name, UniformType::Vec2, &vVector, 1);
 }
 
-void CShaderProgram::SetUniform(const std::string& sName, glm::vec3* vVectors, int iCount) const
+void CShaderProgram::SetUniform(UniformName name, glm::vec3* vVectors, int iCount) const
 {
-	int iLoc = glGetUniformLocation(m_uiProgram, sName.c_str());
-	glUniform3fv(iLoc, iCount, (GLfloat*)vVectors);
+	SetUniformData(name, UniformType::Vec3, vVectors, iCount);
 }
 
-void CShaderProgram::SetUniform(const std::string& sName, const glm::vec3& vVector) const
+void CShaderProgram::SetUniform(UniformName name, const glm::vec3& vVector) const
 {
-	int iLoc = glGetUniformLocation(m_uiProgram, sName.c_str());
-	glUniform3fv(iLoc, 1, (GLfloat*)&vVector);
+	SetUniformData(name, UniformType::Vec3, &vVector, 1);
 }
 
-void CShaderProgram::SetUniform(const std::string& sName, glm::vec4* vVectors, int iCount) const
+void CShaderProgram::SetUniform(UniformName name, glm::vec4* vVectors, int iCount) const
 {
-	int iLoc = glGetUniformLocation(m_uiProgram, sName.c_str());
-	glUniform4fv(iLoc, iCount, (GLfloat*)vVectors);
+	SetUniformData(name, UniformType::Vec4, vVectors, iCount);
 }
 
-void CShaderProgram::SetUniform(const std::string& sName, const glm::vec4& vVector) const
+void CShaderProgram::SetUniform(UniformName name, const glm::vec4& vVector) const
 {
-	int iLoc = glGetUniformLocation(m_uiProgram, sName.c_str());
-	glUniform4fv(iLoc, 1, (GLfloat*)&vVector);
+	SetUniformData(name, UniformType::Vec4, &vVector, 1);
 }
 
 // Setting 3x3 matrices
 
-void CShaderProgram::SetUniform(const std::string& sName, glm::mat3* mMatrices, int iCount) const
+void CShaderProgram::SetUniform(UniformName name, glm::mat3* mMatrices, int iCount) const
 {
-	int iLoc = glGetUniformLocation(m_uiProgram, sName.c_str());
-	glUniformMatrix3fv(iLoc, iCount, GL_FALSE, (GLfloat*)mMatrices);
+	SetUniformData(name, UniformType::Mat3, mMatrices, iCount);
 }
 
-void CShaderProgram::SetUniform(const std::string& sName, const glm::mat3& mMatrix) const
+void CShaderProgram::SetUniform(UniformName name, const glm::mat3& mMatrix) const
 {
-	int iLoc = glGetUniformLocation(m_uiProgram, sName.c_str());
-	glUniformMatrix3fv(iLoc, 1, GL_FALSE, (GLfloat*)&mMatrix);
+	SetUniformData(name, UniformType::Mat3, &mMatrix, 1);
 }
 
 // Setting 4x4 matrices
 
-void CShaderProgram::SetUniform(const std::string& sName, glm::mat4* mMatrices, int iCount) const
+void CShaderProgram::SetUniform(UniformName name, glm::mat4* mMatrices, int iCount) const
 {
-	int iLoc = glGetUniformLocation(m_uiProgram, sName.c_str());
-	glUniformMatrix4fv(iLoc, iCount, GL_FALSE, (GLfloat*)mMatrices);
+	SetUniformData(name, UniformType::Mat4, mMatrices, iCount);
 }
 
-void CShaderProgram::SetUniform(const std::string& sName, const glm::mat4& mMatrix) const
+void CShaderProgram::SetUniform(UniformName name, const glm::mat4& mMatrix) const
 {
-	int iLoc = glGetUniformLocation(m_uiProgram, sName.c_str());
-	glUniformMatrix4fv(iLoc, 1, GL_FALSE, (GLfloat*)&mMatrix);
+	SetUniformData(name, UniformType::Mat4, &mMatrix, 1);
 }
 
 // Setting integers
 
-void CShaderProgram::SetUniform(const std::string& sName, int* iValues, int iCount) const
+void CShaderProgram::SetUniform(UniformName name, int* iValues, int iCount) const
 {
-	int iLoc = glGetUniformLocation(m_uiProgram, sName.c_str());
-	glUniform1iv(iLoc, iCount, iValues);
+	SetUniformData(name, UniformType::Int, iValues, iCount);
 }
 
-void CShaderProgram::SetUniform(const std::string& sName, const int iValue) const
+void CShaderProgram::SetUniform(UniformName name, const int iValue) const
 {
-	int iLoc = glGetUniformLocation(m_uiProgram, sName.c_str());
-	glUniform1i(iLoc, iValue);
+	SetUniformData(name, UniformType::Int, &iValue, 1);
 }
\ No newline at end of file
@@ -1,5 +1,11 @@
 #pragma once
 
+#include "uniforms.h"
+
+class CRenderCommandBuffer;
+class CShaderCache;
+class CShaderCompiler;
+
 // A class that provides a wrapper around an OpenGL shader
 class CShader
 {
@@ -8,18 +14,28 @@ public:
 	~CShader();
 
 	bool LoadShader(const std::string& sFile, int iType);
+	bool CompileShader(const std::string& sSource, int iType, const std::string& sName);
+	void SubmitShader(const std::string& sSource, int iType);
+	bool CheckCompiled(const std::string& sName);
 	void DeleteShader();
 
 	bool IsLoaded();
 	GLuint GetShaderID();
 
+	static int GetShaderType(const std::string& sFile);
+    static bool ReadFile(const std::string& path, std::string& sContents);
+	static bool Preprocess(const std::string& sFile, const std::vector<std::string>& defines, std::string& sOutput,
+						   std::vector<std::string>* pIncludes = nullptr);
 
 private:
+	static bool AppendSource(const std::string& sSource, const std::filesystem::path& directory, int iFirstLine, int iDepth, std::string& sOutput,
+							 std::vector<std::string>* pIncludes);
+
+	static const int MAX_INCLUDE_DEPTH = 16;
+
 	GLuint m_uiShader; // ID of shader
 	int m_iType; // GL_VERTEX_SHADER, GL_FRAGMENT_SHADER...
 	bool m_bLoaded; // Whether shader was loaded and compiled
-
-    static std::string ReadFile(const std::string& path);
 };
 
 // A class the provides a wrapper around an OpenGL shader program
@@ -34,36 +50,113 @@ public:
 	bool AddShaderToProgram(CShader* shShader);
 	bool LinkProgram();
 
+	bool Build(const std::vector<std::string>& files, const std::vector<std::string>& defines,
+			   const CShaderCache* pCache = nullptr, CShaderCompiler* pCompiler = nullptr);
+	bool Rebuild(CShaderCompiler& compiler);
+	// Main thread side: true from the start of a background build until CShaderCompiler::Publish has published it
+	bool IsBuilding() const { return m_bBuilding; }
+
+	// GL thread side, used by CShaderCompiler
+	void SubmitRebuild();
+	bool FinishBuild();
+	GLuint GetBuildProgramID() const { return m_uiBuildProgram; }
+	GLuint Publish();
+
+	bool DependsOn(const std::filesystem::path& file) const;
+	const std::vector<std::filesystem::path>& GetDependencies() const { return m_dependencies; }
+	// Program drawn with in place of this one until it has been built in the background
+	void SetPlaceholder(const CShaderProgram* pPlaceholder) { m_pPlaceholder = pPlaceholder; }
+
 	void UseProgram();
+	void UseProgram(CRenderCommandBuffer& commands) const;
+	uint32_t GetDrawProgram() const;
 
 	GLuint GetProgramID();
 
+	// Returns the uniform table of a linked program, or nullptr if no CShaderProgram owns it.  Only for the thread
+	// that owns the GL context.
+	static CUniformTable* FindUniforms(GLuint uiProgram);
+	// Deletes the program replaced by the last rebuild, once no recorded frame uses it.  Returns its ID, 0 if none.
+	GLuint DeleteRetiredProgram();
+
 	// Setting vectors
-	void SetUniform(const std::string& sName, glm::vec2* vVectors, int iCount = 1) const;
-	void SetUniform(const std::string& sName, const glm::vec2& vVector) const;
-	void SetUniform(const std::string& sName, glm::vec3* vVectors, int iCount = 1) const;
-	void SetUniform(const std::string& sName, const glm::vec3& vVector) const;
-	void SetUniform(const std::string& sName, glm::vec4* vVectors, int iCount = 1) const;
-	void SetUniform(const std::string& sName, const glm::vec4& vVector) const;
+	void SetUniform(UniformName name, glm::vec2* vVectors, int iCount = 1) const;
+	void SetUniform(UniformName name, const glm::vec2& vVector) const;
+	void SetUniform(UniformName name, glm::vec3* vVectors, int iCount = 1) const;
+	void SetUniform(UniformName name, const glm::vec3& vVector) const;
+	void SetUniform(UniformName name, glm::vec4* vVectors, int iCount = 1) const;
+	void SetUniform(UniformName name, const glm::vec4& vVector) const;
 
 	// Setting floats
-	void SetUniform(const std::string& sName, float* fValues, int iCount = 1) const;
-	void SetUniform(const std::string& sName, const float fValue) const;
+	void SetUniform(UniformName name, float* fValues, int iCount = 1) const;
+	void SetUniform(UniformName name, const float fValue) const;
 
 	// Setting 3x3 matrices
-	void SetUniform(const std::string& sName, glm::mat3* mMatrices, int iCount = 1) const;
-	void SetUniform(const std::string& sName, const glm::mat3& mMatrix) const;
+	void SetUniform(UniformName name, glm::mat3* mMatrices, int iCount = 1) const;
+	void SetUniform(UniformName name, const glm::mat3& mMatrix) const;
 
 	// Setting 4x4 matrices
-	void SetUniform(const std::string& sName, glm::mat4* mMatrices, int iCount = 1) const;
-	void SetUniform(const std::string& sName, const glm::mat4& mMatrix) const;
+	void SetUniform(UniformName name, glm::mat4* mMatrices, int iCount = 1) const;
+	void SetUniform(UniformName name, const glm::mat4& mMatrix) const;
 
 	// Setting integers
-	void SetUniform(const std::string& sName, int* iValues, int iCount = 1) const;
-	void SetUniform(const std::string& sName, const int iValue) const;
-
+	void SetUniform(UniformName name, int* iValues, int iCount = 1) const;
+	void SetUniform(UniformName name, const int iValue) const;
+
+	// Typed handle to a uniform, resolved once so that setting it skips the name lookup as well
+	template <typename T>
+	struct Uniform
+	{
+		int index = -1;		// -1 if the program has no such active uniform, setting it does nothing
+	};
+
+	template <typename T>
+	Uniform<T> GetUniform(UniformName name) const
+	{
+		int index = m_uniforms.Find(name);
+		assert((index < 0 || m_uniforms.GetType(index) == UniformTypeOf<T>::value) && "Uniform handle of the wrong type");
+		return {index};
+	}
+
+	template <typename T>
+	void SetUniform(Uniform<T> uniform, const T& value) const
+	{
+		if (uniform.index >= 0)
+			m_uniforms.Set(uniform.index, UniformTypeOf<T>::value, &value, 1);
+	}
 
 private:
-	GLuint m_uiProgram; // ID of program
-	bool m_bLinked; // Whether program was linked and is ready to use
+	std::atomic<GLuint> m_uiProgram; // ID of program, replaced when a finished rebuild is published
+	std::atomic<bool> m_bLinked; // Whether program was linked and is ready to use, set when a background build is published
+	mutable CUniformTable m_uniforms; // Active uniforms and the values last uploaded to them
+	GLuint m_uiRetiredProgram; // Replaced by the last rebuild, still drawn by frames recorded before the swap
+	CUniformTable m_retiredUniforms;
+	const CShaderProgram* m_pPlaceholder;
+
+	// What the program is built from, kept to rebuild it
+	std::vector<std::string> m_files;
+	std::vector<std::string> m_defines;
+	const CShaderCache* m_pCache;
+	std::vector<std::filesystem::path> m_dependencies; // The files and everything they include, canonical
+	bool m_bBuilding;
+
+	// Sources prepared on the main thread, waiting to be handed to the driver
+	std::vector<std::string> m_buildSources;
+	uint64_t m_buildKey;
+
+	// A build handed to the driver that FinishBuild hasn't checked yet
+	GLuint m_uiBuildProgram; // 0 if there is none, the same as m_uiProgram for the first build
+	std::vector<CShader> m_pendingShaders;
+	uint64_t m_pendingKey;
+	const CShaderCache* m_pPendingCache; // Cache to store the binary in once linked, if any
+
+	// A build FinishBuild has linked, waiting for Publish
+	GLuint m_uiFinishedProgram; // 0 if there is none, the same as m_uiProgram for the first build
+	CUniformTable m_finishedUniforms; // Only used by rebuilds, the first build reflects into m_uniforms
+
+	bool PrepareBuild();
+	void SubmitBuild();
+	static bool CheckLinked(GLuint uiProgram);
+	void OnLinked(GLuint uiProgram, CUniformTable& uniforms);
+	void SetUniformData(UniformName name, UniformType type, const void* data, int iCount) const;
 };
\ No newline at end of file
@@ -0,0 +1,120 @@
+#include "shaderwatcher.h"
+#include "shadercompiler.h"
+#include "shaders.h"
+#include "trace.h"
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+CShaderWatcher::CShaderWatcher(CShaderCompiler& compiler) : m_compiler{compiler}
+{
+#ifdef __linux__
+	m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (m_fd < 0)
+		std::cerr << "Can't watch shaders for changes: " << std::strerror(errno) << std::endl;
+#else
+	m_fd = -1;
+#endif
+}
+
+CShaderWatcher::~CShaderWatcher()
+{
+#ifdef __linux__
+	if (m_fd >= 0)
+		close(m_fd);
+#endif
+}
+
+void CShaderWatcher::Watch(CShaderProgram* pProgram)
+{
+	m_programs.push_back(pProgram);
+	for (const std::filesystem::path& file : pProgram->GetDependencies())
+		WatchDirectory(file.parent_path());
+}
+
+// Directories are watched rather than files, because editors often save by writing a new file and renaming it over
+// the old one, which ends a watch on the file itself
+void CShaderWatcher::WatchDirectory(const std::filesystem::path& directory)
+{
+#ifdef __linux__
+	if (m_fd < 0)
+		return;
+
+	for (const auto& [wd, watched] : m_directories) {
+		if (watched == directory)
+			return;
+	}
+
+	int wd = inotify_add_watch(m_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+	if (wd < 0) {
+		std::cerr << "Can't watch " << directory << " for changes: " << std::strerror(errno) << std::endl;
+		return;
+	}
+	m_directories[wd] = directory;
+#endif
+}
+
+void CShaderWatcher::Poll()
+{
+	// Retry the programs that changed again while they were being built
+	for (auto it = m_queued.begin(); it != m_queued.end(); ) {
+		if ((*it)->IsBuilding()) {
+			++it;
+			continue;
+		}
+		Rebuild(*it);
+		it = m_queued.erase(it);
+	}
+
+#ifdef __linux__
+	if (m_fd < 0)
+		return;
+
+	alignas(inotify_event) char buffer[4096];
+	while (true) {
+		ssize_t length = read(m_fd, buffer, sizeof(buffer));
+		if (length <= 0)
+			break;
+
+		TRACE_SCOPE("CShaderWatcher::Poll");
+		for (ssize_t offset = 0; offset < length; ) {
+			const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+			offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+
+			auto directory = m_directories.find(event->wd);
+			if (event->len > 0 && directory != m_directories.end())
+				OnFileChanged(directory->second / event->name);
+		}
+	}
+#endif
+}
+
+void CShaderWatcher::OnFileChanged(const std::filesystem::path& file)
+{
+	std::error_code error;
+	std::filesystem::path canonical = std::filesystem::weakly_canonical(file, error);
+
+	for (CShaderProgram* pProgram : m_programs) {
+		if (!pProgram->DependsOn(canonical))
+			continue;
+
+		std::cout << "Rebuilding after a change to " << file << std::endl;
+		if (!pProgram->IsBuilding())
+			Rebuild(pProgram);
+		else if (std::find(m_queued.begin(), m_queued.end(), pProgram) == m_queued.end())
+			m_queued.push_back(pProgram);
+	}
+}
+
+// A rebuild that fails, e.g. on a file saved half way, keeps the current program and isn't retried until one of its
+// files changes again
+void CShaderWatcher::Rebuild(CShaderProgram* pProgram)
+{
+	if (pProgram->Rebuild(m_compiler)) {
+		// The edit may have added an include from somewhere else
+		for (const std::filesystem::path& dependency : pProgram->GetDependencies())
+			WatchDirectory(dependency.parent_path());
+	}
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+class CShaderProgram;
+class CShaderCompiler;
+
+// Watches the files programs are built from and rebuilds the programs whose files change, so shaders can be edited
+// while the game runs.  The changed files are read on the main thread and the rebuilds go through the compiler, which
+// swaps each new program in between frames once it has linked and keeps the old one if it fails.  Uses inotify, on
+// other platforms nothing is watched.
+class CShaderWatcher
+{
+public:
+	explicit CShaderWatcher(CShaderCompiler& compiler);
+	~CShaderWatcher();
+
+	// Watches the directories of the program's files and includes.  Call after the program has been built.
+	void Watch(CShaderProgram* pProgram);
+
+	// Starts rebuilding the programs whose files changed since the last call, reading and preprocessing their files.
+	// Never waits for a build.  Call once per frame on the main thread, while recording.
+	void Poll();
+
+private:
+	CShaderCompiler& m_compiler;
+	int m_fd;														// inotify instance, -1 if unavailable
+	std::unordered_map<int, std::filesystem::path> m_directories;	// By watch descriptor
+	std::vector<CShaderProgram*> m_programs;
+	std::vector<CShaderProgram*> m_queued;	// Changed while a build was in progress, rebuilt once it has finished
+
+	void WatchDirectory(const std::filesystem::path& directory);
+	void OnFileChanged(const std::filesystem::path& file);
+	void Rebuild(CShaderProgram* pProgram);
+};
@@ -1,13 +1,20 @@
 #include "skybox.h"
+#include "renderqueue.h"
 
 CSkybox::CSkybox()
-{}
+{
+	m_pGeometry = nullptr;
+}
 
+// Gives the geometry's range back to the arena, which outlives the objects drawn from it
 CSkybox::~CSkybox()
-{}
+{
+	if (m_pGeometry != nullptr)
+		m_pGeometry->Remove(m_geometry);
+}
 
 // Create a skybox of a given size with six textures
-void CSkybox::Create(float size)
+void CSkybox::Create(CGeometryArena& geometry, float size)
 {
 	m_cubemapTexture.Create(
         "resources/skyboxes/jajdarkland1/flipped/jajdarkland1_rt.jpg",
@@ -18,12 +25,6 @@ void CSkybox::Create(float size)
         "resources/skyboxes/jajdarkland1/flipped/jajdarkland1_ft.jpg"
     );
 
-	glGenVertexArrays(1, &m_vao);
-	glBindVertexArray(m_vao);
-
-	m_vbo.Create();
-	m_vbo.Bind();
-
 	glm::vec3 vSkyBoxVertices[24] = 
 	{
 		// Front face
@@ -54,41 +55,29 @@ void CSkybox::Create(float size)
 		glm::vec3{0.0f, 1.0f, 0.0f}
 	};
 
-	glm::vec4 vColour = glm::vec4{1};
+	CVertexBuilder<Vertex> vertices(24);
 	for (int i = 0; i < 24; i++) {
-		m_vbo.AddData(&vSkyBoxVertices[i], sizeof(glm::vec3));
-		m_vbo.AddData(&vSkyBoxTexCoords[i%4], sizeof(glm::vec2));
-		m_vbo.AddData(&vSkyBoxNormals[i/4], sizeof(glm::vec3));
+		vertices.AddVertex({vSkyBoxVertices[i], vSkyBoxTexCoords[i%4], vSkyBoxNormals[i/4]});
 	}
 
-	m_vbo.UploadDataToGPU(GL_STATIC_DRAW);
-
-	// Set the vertex attribute locations
-	GLsizei istride = 2 * sizeof(glm::vec3 ) + sizeof(glm::vec2);
-
-	// Vertex positions
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, istride, 0);
-	// Texture coordinates
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, istride, (void*)sizeof(glm::vec3));
-	// Normal vectors
-	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, istride, (void*)(sizeof(glm::vec3)+sizeof(glm::vec2)));
-	
+	// Copy the vertices into the shared geometry buffers
+	m_pGeometry = &geometry;
+	m_geometry = geometry.Add(vertices);
 }
 
-// Render the skybox
-void CSkybox::Render(int textureUnit)
+// Submits the skybox as one packet per face
+void CSkybox::Submit(CRenderQueue& queue, const DrawPacket& packet, int textureUnit)
 {
-	glDepthMask(0);
-	glBindVertexArray(m_vao);
-	m_cubemapTexture.Bind(textureUnit);
+	DrawPacket face = packet;
+	m_pGeometry->SetDrawRange(face, m_geometry);
+	face.texture = m_cubemapTexture.GetBinding(textureUnit);
+	face.primitive = PrimitiveType::TriangleStrip;
+	face.count = 4;
 	for (int i = 0; i < 6; i++) {
 		//m_textures[i].Bind();
-		glDrawArrays(GL_TRIANGLE_STRIP, i*4, 4);
+		face.first = m_geometry.firstVertex + i*4;
+		queue.Submit(face);
 	}
-	glDepthMask(1);
 }
 
 // Release the storage assocaited with the skybox
@@ -97,6 +86,7 @@ void CSkybox::Release()
 	//for (int i = 0; i < 6; i++)
 		//m_textures[i].Release();
 	m_cubemapTexture.Release();
-	glDeleteVertexArrays(1, &m_vao);
-	m_vbo.Release();
+	if (m_pGeometry != nullptr)
+		m_pGeometry->Remove(m_geometry);
+	m_geometry = {};
 }
\ No newline at end of file
@@ -1,7 +1,7 @@
 #pragma once
 
 #include "texture.h"
-#include "vertexbufferobject.h"
+#include "geometryarena.h"
 #include "cubemap.h"
 
 // This is a class for creating and rendering a skybox
@@ -10,12 +10,12 @@ class CSkybox
 public:
 	CSkybox();
 	~CSkybox();
-	void Create(float size);
-	void Render(int textureUnit);
+	void Create(CGeometryArena& geometry, float size);
+	void Submit(CRenderQueue& queue, const DrawPacket& packet, int textureUnit);
 	void Release();
 
 private:
-	GLuint m_vao;
-	CVertexBufferObject m_vbo;
+	CGeometryArena* m_pGeometry;
+	GeometryRange m_geometry;
 	CCubemap m_cubemapTexture;
 };
\ No newline at end of file
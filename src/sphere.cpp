@@ -3,15 +3,22 @@
 #define BUFFER_OFFSET(i) ((char *)nullptr + (i))
 
 #include "sphere.h"
+#include "renderqueue.h"
 
 CSphere::CSphere()
-{}
+{
+	m_pGeometry = nullptr;
+}
 
+// Gives the geometry's range back to the arena, which outlives the objects drawn from it
 CSphere::~CSphere()
-{}
+{
+	if (m_pGeometry != nullptr)
+		m_pGeometry->Remove(m_geometry);
+}
 
 // Create a unit sphere 
-void CSphere::Create(const std::string& a_sDirectory, const std::string& a_sFilename, int slicesIn, int stacksIn)
+void CSphere::Create(CGeometryArena& geometryArena, const std::string& a_sDirectory, const std::string& a_sFilename, int slicesIn, int stacksIn)
 {
 	// check if filename passed in -- if so, load texture
 
@@ -25,14 +32,10 @@ void CSphere::Create(const std::string& a_sDirectory, const std::string& a_sFile
 	m_texture.SetSamplerObjectParameter(GL_TEXTURE_WRAP_S, GL_REPEAT);
 	m_texture.SetSamplerObjectParameter(GL_TEXTURE_WRAP_T, GL_REPEAT);
 	
-	glGenVertexArrays(1, &m_vao);
-	glBindVertexArray(m_vao);
-
-	m_vbo.Create();
-	m_vbo.Bind();
+	// Both counts are known, so the builder reserves its storage once
+	CVertexBuilder<Vertex> geometry(size_t(stacksIn) * (slicesIn + 1), size_t(stacksIn) * slicesIn * 6);
 
-	// Compute vertex attributes and store in VBO
-	int vertexCount = 0;
+	// Compute vertex attributes
 	for (int stacks = 0; stacks < stacksIn; stacks++) {
 		float phi = (stacks / (float) (stacksIn - 1)) * (float) M_PI;
 		for (int slices = 0; slices <= slicesIn; slices++) {
@@ -42,16 +45,11 @@ void CSphere::Create(const std::string& a_sDirectory, const std::string& a_sFile
 			glm::vec2 t = glm::vec2{slices / (float) slicesIn, stacks / (float) stacksIn};
 			glm::vec3 n = v;
 
-			m_vbo.AddVertexData(&v, sizeof(glm::vec3));
-			m_vbo.AddVertexData(&t, sizeof(glm::vec2));
-			m_vbo.AddVertexData(&n, sizeof(glm::vec3));
-
-			vertexCount++;
-
+			geometry.AddVertex({v, t, n});
 		}
 	}
 
-	// Compute indices and store in VBO
+	// Compute indices
 	m_numTriangles = 0;
 	for (int stacks = 0; stacks < stacksIn; stacks++) {
 		for (int slices = 0; slices < slicesIn; slices++) {
@@ -63,47 +61,35 @@ void CSphere::Create(const std::string& a_sDirectory, const std::string& a_sFile
 			uint32_t index2 = stacks * (slicesIn+1) + nextSlice;
 			uint32_t index3 = nextStack * (slicesIn+1) + nextSlice;
 
-			m_vbo.AddIndexData(&index0, sizeof(uint32_t));
-			m_vbo.AddIndexData(&index1, sizeof(uint32_t));
-			m_vbo.AddIndexData(&index2, sizeof(uint32_t));
+			geometry.AddTriangle(index0, index1, index2);
 			m_numTriangles++;
 
-			m_vbo.AddIndexData(&index2, sizeof(uint32_t));
-			m_vbo.AddIndexData(&index1, sizeof(uint32_t));
-			m_vbo.AddIndexData(&index3, sizeof(uint32_t));
+			geometry.AddTriangle(index2, index1, index3);
 			m_numTriangles++;
 
 		}
 	}
 
-	m_vbo.UploadDataToGPU(GL_STATIC_DRAW);
-
-	GLsizei stride = 2*sizeof(glm::vec3)+sizeof(glm::vec2);
-
-	// Vertex positions
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, 0);
-	// Texture coordinates
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, stride, (void*)sizeof(glm::vec3));
-	// Normal vectors
-	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(glm::vec3)+sizeof(glm::vec2)));
-	
+	// Copy the vertices and indices into the shared geometry buffers
+	m_pGeometry = &geometryArena;
+	m_geometry = geometryArena.Add(geometry);
 }
 
-// Render the sphere as a set of triangles
-void CSphere::Render()
+// Submits the sphere as a set of triangles
+void CSphere::Submit(CRenderQueue& queue, const DrawPacket& packet)
 {
-	glBindVertexArray(m_vao);
-	m_texture.Bind();
-	glDrawElements(GL_TRIANGLES, m_numTriangles*3, GL_UNSIGNED_INT, 0);
+	DrawPacket draw = packet;
+	m_pGeometry->SetDrawRange(draw, m_geometry);
+	draw.texture = m_texture.GetBinding();
+	draw.primitive = PrimitiveType::Triangles;
+	queue.Submit(draw);
 }
 
 // Release memory on the GPU 
 void CSphere::Release()
 {
 	m_texture.Release();
-	glDeleteVertexArrays(1, &m_vao);
-	m_vbo.Release();
+	if (m_pGeometry != nullptr)
+		m_pGeometry->Remove(m_geometry);
+	m_geometry = {};
 }
\ No newline at end of file
@@ -1,7 +1,7 @@
 #pragma once
 
 #include "texture.h"
-#include "vertexbufferobjectindexed.h"
+#include "geometryarena.h"
 
 // Class for generating a unit sphere
 class CSphere
@@ -9,13 +9,13 @@ class CSphere
 public:
 	CSphere();
 	~CSphere();
-	void Create(const std::string& directory, const std::string& front, int slicesIn, int stacksIn);
-	void Render();
+	void Create(CGeometryArena& geometry, const std::string& directory, const std::string& front, int slicesIn, int stacksIn);
+	void Submit(CRenderQueue& queue, const DrawPacket& packet);
 	void Release();
 
 private:
-	GLuint m_vao;
-	CVertexBufferObjectIndexed m_vbo;
+	CGeometryArena* m_pGeometry;
+	GeometryRange m_geometry;
 	CTexture m_texture;
 	std::string m_directory;
 	std::string m_filename;
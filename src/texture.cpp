@@ -1,5 +1,7 @@
 #include "texture.h"
+#include "glstatecache.h"
 #include "image.h"
+#include "renderqueue.h"
 
 CTexture::CTexture()
 {
@@ -12,9 +14,8 @@ CTexture::~CTexture()
 void CTexture::CreateFromData(uint8_t* data, int width, int height, int channels, GLenum internalFormat, GLenum dataFormat, bool generateMipMaps)
 {
 	// Generate an OpenGL texture ID for this texture
-    glEnable(GL_TEXTURE_2D);
 	glGenTextures(1, &m_textureID);
-	glBindTexture(GL_TEXTURE_2D, m_textureID);
+	CGLStateCache::Get().BindTexture(0, GL_TEXTURE_2D, m_textureID);
     glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, dataFormat, GL_UNSIGNED_BYTE, data);
 
 	if(generateMipMaps) {
@@ -35,6 +36,12 @@ bool CTexture::Load(const std::string& path, bool generateMipMaps)
 {
 	Image image {path};
 
+	return CreateFromImage(image, generateMipMaps);
+}
+
+// Creates a 2D texture from an already decoded image, so decoding can happen off the thread that owns the GL context
+bool CTexture::CreateFromImage(const Image& image, bool generateMipMaps)
+{
 	// If somehow one of these failed (they shouldn't), return failure
 	if (image.pixels == nullptr || image.height == 0 || image.width == 0)
 		return false;
@@ -52,8 +59,7 @@ bool CTexture::Load(const std::string& path, bool generateMipMaps)
     }
 
 	CreateFromData(image.pixels, image.width, image.height, image.channels, internalFormat, dataFormat, generateMipMaps);
-
-	m_path = path;
+	m_path = image.path;
 
 	return true; // Success
 }
@@ -68,17 +74,23 @@ void CTexture::SetSamplerObjectParameterf(GLenum parameter, float value)
 	glSamplerParameterf(m_samplerObjectID, parameter, value);
 }
 
-// Binds a texture for rendering
-void CTexture::Bind(int iTextureUnit)
+// Records binding the texture for rendering
+void CTexture::Bind(CRenderCommandBuffer& commands, int iTextureUnit)
+{
+	commands.BindTexture(TextureTarget::Texture2D, iTextureUnit, m_textureID, m_samplerObjectID);
+}
+
+// Returns how to bind the texture in a draw packet
+TextureBinding CTexture::GetBinding(int iTextureUnit) const
 {
-	glActiveTexture(GL_TEXTURE0+iTextureUnit);
-	glBindTexture(GL_TEXTURE_2D, m_textureID);
-	glBindSampler(iTextureUnit, m_samplerObjectID);
+	return {TextureTarget::Texture2D, static_cast<uint32_t>(iTextureUnit), m_textureID, m_samplerObjectID};
 }
 
 // Frees memory on the GPU of the texture
 void CTexture::Release()
 {
+	CGLStateCache::Get().ForgetSampler(m_samplerObjectID);
+	CGLStateCache::Get().ForgetTexture(m_textureID);
 	glDeleteSamplers(1, &m_samplerObjectID);
 	glDeleteTextures(1, &m_textureID);
 }
@@ -1,5 +1,11 @@
 #pragma once
 
+struct Image;
+struct TextureBinding;
+struct DrawPacket;
+class CRenderCommandBuffer;
+class CRenderQueue;
+
 // Class that provides a texture for texture mapping in OpenGL
 class CTexture
 {
@@ -9,7 +15,9 @@ public:
 
 	void CreateFromData(uint8_t* data, int width, int height, int channels, GLenum internalFormat, GLenum dataFormat, bool generateMipMaps = false);
 	bool Load(const std::string& path, bool generateMipMaps = true);
-	void Bind(int textureUnit = 0);
+	bool CreateFromImage(const Image& image, bool generateMipMaps = true);
+	void Bind(CRenderCommandBuffer& commands, int textureUnit = 0);
+	TextureBinding GetBinding(int textureUnit = 0) const;
 
 	void SetSamplerObjectParameter(GLenum parameter, GLenum value);
 	void SetSamplerObjectParameterf(GLenum parameter, float value);
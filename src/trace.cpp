@@ -0,0 +1,160 @@
+#include "trace.h"
+
+#ifdef ENABLE_TRACING
+
+namespace {
+    constexpr uint64_t BUFFER_EVENTS = 1 << 16;    // Events kept per thread, about 1.5 MB each
+
+    struct Event {
+        const char* name;
+        uint64_t begin;
+        uint64_t end;
+    };
+
+    // A reader may copy a slot while its owner overwrites it, so the fields are relaxed atomics.  These compile to
+    // plain moves; torn copies are detected afterwards from the write count and thrown away.
+    struct EventSlot {
+        std::atomic<const char*> name;
+        std::atomic<uint64_t> begin;
+        std::atomic<uint64_t> end;
+    };
+
+    // Written only by its own thread.  The count is published with release so a reader sees complete events.
+    struct ThreadBuffer {
+        std::unique_ptr<EventSlot[]> events = std::make_unique<EventSlot[]>(BUFFER_EVENTS);
+        std::atomic<uint64_t> written{0};
+        uint32_t id = 0;
+        std::string name;
+    };
+
+    const auto epoch = std::chrono::steady_clock::now();
+
+    std::mutex registryMutex;                       // Guards the list of buffers and their names, never taken while recording
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    ThreadBuffer* gpuBuffer = nullptr;              // Only touched by the thread adding GPU events
+
+    // A thread only gets a buffer once it records its first event, until then its name is kept here
+    thread_local ThreadBuffer* t_buffer = nullptr;
+    thread_local std::string t_name;
+
+    ThreadBuffer* RegisterBuffer(const std::string& name)
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        auto buffer = std::make_unique<ThreadBuffer>();
+        buffer->id = static_cast<uint32_t>(buffers.size()) + 1;
+        buffer->name = name.empty() ? "Thread " + std::to_string(buffer->id) : name;
+        buffers.push_back(std::move(buffer));
+        return buffers.back().get();
+    }
+
+    void Push(ThreadBuffer& buffer, const char* name, uint64_t begin, uint64_t end)
+    {
+        uint64_t index = buffer.written.load(std::memory_order_relaxed);
+
+        // Pairs with the fence in Write: a reader that sees any part of this event also sees the count from before it
+        std::atomic_thread_fence(std::memory_order_release);
+        EventSlot& slot = buffer.events[index % BUFFER_EVENTS];
+        slot.name.store(name, std::memory_order_relaxed);
+        slot.begin.store(begin, std::memory_order_relaxed);
+        slot.end.store(end, std::memory_order_relaxed);
+        buffer.written.store(index + 1, std::memory_order_release);
+    }
+
+    void WriteString(std::ostream& out, const std::string& text)
+    {
+        out << '"';
+        for (char c : text) {
+            if (c == '"' || c == '\\')
+                out << '\\';
+            out << c;
+        }
+        out << '"';
+    }
+}
+
+std::atomic<bool> Trace::enabled{false};
+
+void Trace::Enable(bool enable) {
+    enabled.store(enable, std::memory_order_relaxed);
+}
+
+void Trace::SetThreadName(const char* name) {
+    if (t_buffer == nullptr) {
+        t_name = name;
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    t_buffer->name = name;
+}
+
+uint64_t Trace::Now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+void Trace::AddEvent(const char* name, uint64_t begin, uint64_t end) {
+    if (t_buffer == nullptr)
+        t_buffer = RegisterBuffer(t_name);
+
+    Push(*t_buffer, name, begin, end);
+}
+
+void Trace::AddGpuEvent(const char* name, uint64_t begin, uint64_t end) {
+    if (gpuBuffer == nullptr)
+        gpuBuffer = RegisterBuffer("GPU");
+
+    Push(*gpuBuffer, name, begin, end);
+}
+
+bool Trace::Write(const std::filesystem::path& path) {
+    std::ofstream file(path);
+    if (!file) {
+        std::cerr << "Cannot write trace to " << path << std::endl;
+        return false;
+    }
+
+    file << std::fixed << std::setprecision(3);
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+
+    bool first = true;
+    std::vector<Event> events;
+    for (auto& buffer : buffers) {
+        file << (first ? "" : ",\n") << R"({"name":"thread_name","ph":"M","pid":1,"tid":)" << buffer->id << R"(,"args":{"name":)";
+        WriteString(file, buffer->name);
+        file << "}}";
+        first = false;
+
+        // Copy the newest events, then drop any the owner overwrote while we were copying
+        uint64_t end = buffer->written.load(std::memory_order_acquire);
+        uint64_t begin = end > BUFFER_EVENTS ? end - BUFFER_EVENTS : 0;
+        events.clear();
+        for (uint64_t i = begin; i < end; i++) {
+            const EventSlot& slot = buffer->events[i % BUFFER_EVENTS];
+            events.push_back({slot.name.load(std::memory_order_relaxed), slot.begin.load(std::memory_order_relaxed),
+                              slot.end.load(std::memory_order_relaxed)});
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t written = buffer->written.load(std::memory_order_relaxed);
+        // The slot after the last published event may be mid-write, so it counts as overwritten too
+        uint64_t overwritten = written + 1 > BUFFER_EVENTS ? written + 1 - BUFFER_EVENTS : 0;
+        size_t skip = static_cast<size_t>(std::min(end, std::max(begin, overwritten)) - begin);
+
+        for (size_t i = skip; i < events.size(); i++) {
+            const Event& event = events[i];
+            file << ",\n" << R"({"name":)";
+            WriteString(file, event.name);
+            file << R"(,"ph":"X","pid":1,"tid":)" << buffer->id
+                 << R"(,"ts":)" << event.begin / 1000.0
+                 << R"(,"dur":)" << (event.end - event.begin) / 1000.0 << '}';
+        }
+    }
+
+    file << "\n]}\n";
+    std::cout << "Trace written to " << path << std::endl;
+    return file.good();
+}
+
+#endif
@@ -0,0 +1,64 @@
+#pragma once
+
+// Timeline recorder that writes Chrome trace-event JSON, viewable in chrome://tracing or ui.perfetto.dev.
+//
+// Every thread records into its own ring buffer with no locking, so tracing can stay on in normal runs: when the
+// buffer is full the oldest events are overwritten and a dump always holds the most recent part of the timeline.
+// Recording is off until Enable is called; a disabled scope costs a single relaxed load.  Configuring with
+// ENABLE_TRACING=OFF removes the recorder entirely and the TRACE_SCOPE macro expands to nothing.
+class Trace {
+public:
+#ifdef ENABLE_TRACING
+    static void Enable(bool enabled);
+    static bool IsEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+    // Names the calling thread's track in the timeline
+    static void SetThreadName(const char* name);
+
+    // Nanoseconds on the clock used for all events
+    static uint64_t Now();
+
+    // Records a completed event on the calling thread.  The name must outlive the recorder, e.g. a string literal.
+    static void AddEvent(const char* name, uint64_t begin, uint64_t end);
+
+    // Records an event on the GPU track.  Only one thread, the one replaying frames, may add GPU events.
+    static void AddGpuEvent(const char* name, uint64_t begin, uint64_t end);
+
+    // Writes everything currently held in the buffers as a JSON trace, returns false if the file can't be written
+    static bool Write(const std::filesystem::path& path);
+#else
+    static void Enable(bool) {}
+    static bool IsEnabled() { return false; }
+    static void SetThreadName(const char*) {}
+    static uint64_t Now() { return 0; }
+    static void AddEvent(const char*, uint64_t, uint64_t) {}
+    static void AddGpuEvent(const char*, uint64_t, uint64_t) {}
+    static bool Write(const std::filesystem::path&) { return false; }
+#endif
+
+    // Records the enclosing block as an event, see TRACE_SCOPE
+    class Scope {
+    public:
+        explicit Scope(const char* eventName) : name{IsEnabled() ? eventName : nullptr}, begin{name ? Now() : 0} {}
+        ~Scope() { if (name) AddEvent(name, begin, Now()); }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    private:
+        const char* name;
+        uint64_t begin;
+    };
+
+private:
+#ifdef ENABLE_TRACING
+    static std::atomic<bool> enabled;
+#endif
+};
+
+#define TRACE_CONCAT_IMPL(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+
+#ifdef ENABLE_TRACING
+#define TRACE_SCOPE(name) Trace::Scope TRACE_CONCAT(traceScope, __LINE__){ name }
+#else
+#define TRACE_SCOPE(name)
+#endif
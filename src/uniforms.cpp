@@ -0,0 +1,256 @@
+#include "uniforms.h"
+#include "glstatecache.h"
+#include "rendercommandbuffer.h"
+
+// Converts the type reported by glGetActiveUniform, returns false for types that can't be set through the table
+static bool GetUniformType(GLenum glType, UniformType& type)
+{
+	switch (glType) {
+		case GL_INT:
+		case GL_BOOL:
+		case GL_SAMPLER_1D:
+		case GL_SAMPLER_2D:
+		case GL_SAMPLER_3D:
+		case GL_SAMPLER_CUBE:
+		case GL_SAMPLER_2D_SHADOW:
+		case GL_SAMPLER_2D_ARRAY:
+		case GL_SAMPLER_BUFFER:
+		case GL_INT_SAMPLER_BUFFER:
+		case GL_UNSIGNED_INT_SAMPLER_BUFFER:
+			type = UniformType::Int;
+			return true;
+		case GL_FLOAT:
+			type = UniformType::Float;
+			return true;
+		case GL_FLOAT_VEC2:
+			type = UniformType::Vec2;
+			return true;
+		case GL_FLOAT_VEC3:
+			type = UniformType::Vec3;
+			return true;
+		case GL_FLOAT_VEC4:
+			type = UniformType::Vec4;
+			return true;
+		case GL_FLOAT_MAT3:
+			type = UniformType::Mat3;
+			return true;
+		case GL_FLOAT_MAT4:
+			type = UniformType::Mat4;
+			return true;
+		default:
+			return false;
+	}
+}
+
+size_t CUniformTable::GetElementSize(UniformType type)
+{
+	switch (type) {
+		case UniformType::Int: return sizeof(GLint);
+		case UniformType::Float: return sizeof(GLfloat);
+		case UniformType::Vec2: return sizeof(glm::vec2);
+		case UniformType::Vec3: return sizeof(glm::vec3);
+		case UniformType::Vec4: return sizeof(glm::vec4);
+		case UniformType::Mat3: return sizeof(glm::mat3);
+		case UniformType::Mat4: return sizeof(glm::mat4);
+	}
+	return 0;
+}
+
+// Builds the table from the program's active uniforms.  Arrays are found by their name without the "[0]".
+void CUniformTable::Reflect(GLuint program)
+{
+	Clear();
+
+	GLint count = 0, maxLength = 0;
+	glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+	glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+	std::vector<char> name(std::max(maxLength, 1));
+	uint32_t offset = 0;
+	for (GLint i = 0; i < count; i++) {
+		GLsizei length = 0;
+		GLint size = 0;
+		GLenum glType = 0;
+		glGetActiveUniform(program, static_cast<GLuint>(i), maxLength, &length, &size, &glType, name.data());
+
+		// Members of uniform blocks have no location and are set through their buffer instead
+		GLint location = glGetUniformLocation(program, name.data());
+		UniformType type;
+		if (location < 0 || !GetUniformType(glType, type))
+			continue;
+
+		if (length > 3 && std::strcmp(name.data() + length - 3, "[0]") == 0)
+			name[length - 3] = '\0';
+
+		m_uniforms.push_back({HashUniformName(name.data()), location, type, size, offset, false});
+		offset += static_cast<uint32_t>(GetElementSize(type) * size);
+	}
+
+	std::sort(m_uniforms.begin(), m_uniforms.end(), [](const Uniform& a, const Uniform& b) { return a.hash < b.hash; });
+	for (size_t i = 1; i < m_uniforms.size(); i++) {
+		if (m_uniforms[i].hash == m_uniforms[i - 1].hash)
+			std::cerr << "Error! Two uniforms of program " << program << " have the same name hash, rename one of them" << std::endl;
+	}
+
+	m_shadow.assign(offset, 0);
+}
+
+void CUniformTable::Clear()
+{
+	m_uniforms.clear();
+	m_shadow.clear();
+}
+
+int CUniformTable::Find(UniformName name) const
+{
+	auto it = std::lower_bound(m_uniforms.begin(), m_uniforms.end(), name.hash, [](const Uniform& uniform, uint32_t hash) { return uniform.hash < hash; });
+	if (it == m_uniforms.end() || it->hash != name.hash)
+		return -1;
+	return static_cast<int>(it - m_uniforms.begin());
+}
+
+void CUniformTable::Set(int index, UniformType type, const void* data, int count)
+{
+	Uniform& uniform = m_uniforms[index];
+
+	// The driver would reject the upload as well
+	assert(uniform.type == type && "Uniform set with the wrong type");
+	if (uniform.type != type)
+		return;
+
+	count = std::min(count, uniform.size);
+	size_t size = GetElementSize(type) * count;
+	uint8_t* shadow = m_shadow.data() + uniform.offset;
+	if (uniform.uploaded && std::memcmp(shadow, data, size) == 0)
+		return;
+
+	std::memcpy(shadow, data, size);
+	uniform.uploaded = true;
+	Upload(uniform.location, type, data, count);
+}
+
+void CUniformTable::Upload(GLint location, UniformType type, const void* data, int count)
+{
+	switch (type) {
+		case UniformType::Int:
+			glUniform1iv(location, count, static_cast<const GLint*>(data));
+			break;
+		case UniformType::Float:
+			glUniform1fv(location, count, static_cast<const GLfloat*>(data));
+			break;
+		case UniformType::Vec2:
+			glUniform2fv(location, count, static_cast<const GLfloat*>(data));
+			break;
+		case UniformType::Vec3:
+			glUniform3fv(location, count, static_cast<const GLfloat*>(data));
+			break;
+		case UniformType::Vec4:
+			glUniform4fv(location, count, static_cast<const GLfloat*>(data));
+			break;
+		case UniformType::Mat3:
+			glUniformMatrix3fv(location, count, GL_FALSE, static_cast<const GLfloat*>(data));
+			break;
+		case UniformType::Mat4:
+			glUniformMatrix4fv(location, count, GL_FALSE, static_cast<const GLfloat*>(data));
+			break;
+	}
+}
+
+void BindUniformBlocks(GLuint program)
+{
+	static const char* const BLOCK_NAMES[] = {"PerFrame", "PerDraw", "Materials"};
+	static_assert(std::size(BLOCK_NAMES) == static_cast<size_t>(UniformBlock::Count), "Missing uniform block name");
+
+	for (size_t i = 0; i < std::size(BLOCK_NAMES); i++) {
+		GLuint blockIndex = glGetUniformBlockIndex(program, BLOCK_NAMES[i]);
+		if (blockIndex != GL_INVALID_INDEX)
+			glUniformBlockBinding(program, blockIndex, static_cast<GLuint>(i));
+	}
+}
+
+CUniformRingBuffer::CUniformRingBuffer()
+{
+	m_buffer = 0;
+	m_regionSize = 0;
+	m_region = 0;
+	for (GLsync& fence : m_fences)
+		fence = nullptr;
+}
+
+GLint CUniformRingBuffer::GetOffsetAlignment()
+{
+	GLint alignment = 0;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	return alignment;
+}
+
+void CUniformRingBuffer::Create(size_t regionSize)
+{
+	Release();
+
+	// Regions start at multiples of the region size and blocks are recorded at multiples of UNIFORM_BLOCK_ALIGNMENT
+	// within them.  Both offsets are passed to glBindBufferRange, so both have to suit this GPU.
+	assert(CRenderCommandBuffer::UNIFORM_BLOCK_ALIGNMENT % GetOffsetAlignment() == 0 && regionSize % CRenderCommandBuffer::UNIFORM_BLOCK_ALIGNMENT == 0 &&
+		   "The GPU's uniform buffer offset alignment isn't met");
+
+	m_regionSize = regionSize;
+	glGenBuffers(1, &m_buffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+	glBufferData(GL_UNIFORM_BUFFER, static_cast<GLsizeiptr>(m_regionSize * FRAMES), nullptr, GL_STREAM_DRAW);
+}
+
+void CUniformRingBuffer::Release()
+{
+	for (GLsync& fence : m_fences) {
+		if (fence != nullptr) {
+			glDeleteSync(fence);
+			fence = nullptr;
+		}
+	}
+
+	CGLStateCache::Get().ForgetBuffer(m_buffer);
+	glDeleteBuffers(1, &m_buffer);
+	m_buffer = 0;
+	m_regionSize = 0;
+}
+
+GLintptr CUniformRingBuffer::BeginFrame(const void* data, size_t size)
+{
+	// The old buffer is released with glDeleteBuffers, which keeps it alive until the GPU is done with it
+	if (size > m_regionSize) {
+		size_t regionSize = std::max(m_regionSize, MIN_REGION_SIZE);
+		while (regionSize < size)
+			regionSize *= 2;
+		Create(regionSize);
+	}
+
+	m_region = (m_region + 1) % FRAMES;
+	GLsync& fence = m_fences[m_region];
+	if (fence != nullptr) {
+		glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+		glDeleteSync(fence);
+		fence = nullptr;
+	}
+
+	GLintptr offset = static_cast<GLintptr>(m_region * m_regionSize);
+	if (size == 0)
+		return offset;
+
+	// The fence has already synchronised with the GPU, so the driver needn't
+	glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+	void* pMapped = glMapBufferRange(GL_UNIFORM_BUFFER, offset, static_cast<GLsizeiptr>(size),
+									 GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+	if (pMapped == nullptr) {
+		std::cerr << "Error! Failed to map the uniform buffer" << std::endl;
+		return offset;
+	}
+	std::memcpy(pMapped, data, size);
+	glUnmapBuffer(GL_UNIFORM_BUFFER);
+	return offset;
+}
+
+void CUniformRingBuffer::EndFrame()
+{
+	if (m_buffer != 0)
+		m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
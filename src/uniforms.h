@@ -0,0 +1,161 @@
+#pragma once
+
+enum class UniformType : uint32_t { Int, Float, Vec2, Vec3, Vec4, Mat3, Mat4 };
+
+// FNV-1a hash of a uniform name.  It is constexpr, so a name stored in a constexpr UniformName is hashed by the
+// compiler.  Names passed straight to SetUniform are hashed when the call runs, unless the optimiser folds them.
+constexpr uint32_t HashUniformName(const char* name)
+{
+	uint32_t hash = 2166136261u;
+	while (*name != '\0') {
+		hash ^= static_cast<uint8_t>(*name++);
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+// Identifies a uniform by the hash of its name.  Converts implicitly from literals and strings, so call sites keep
+// passing names while lookups compare integers instead of strings.
+struct UniformName
+{
+	constexpr UniformName(const char* name) : hash{HashUniformName(name)} {}
+	UniformName(const std::string& name) : hash{HashUniformName(name.c_str())} {}
+	// From a hash computed earlier, e.g. one stored in a recorded command
+	explicit constexpr UniformName(uint32_t nameHash) : hash{nameHash} {}
+
+	uint32_t hash;
+};
+
+// Maps the C++ types uniforms are set from to their UniformType
+template <typename T> struct UniformTypeOf;
+template <> struct UniformTypeOf<int> { static constexpr UniformType value = UniformType::Int; };
+template <> struct UniformTypeOf<float> { static constexpr UniformType value = UniformType::Float; };
+template <> struct UniformTypeOf<glm::vec2> { static constexpr UniformType value = UniformType::Vec2; };
+template <> struct UniformTypeOf<glm::vec3> { static constexpr UniformType value = UniformType::Vec3; };
+template <> struct UniformTypeOf<glm::vec4> { static constexpr UniformType value = UniformType::Vec4; };
+template <> struct UniformTypeOf<glm::mat3> { static constexpr UniformType value = UniformType::Mat3; };
+template <> struct UniformTypeOf<glm::mat4> { static constexpr UniformType value = UniformType::Mat4; };
+
+// The active uniforms of a linked program, found with glGetActiveUniform, together with a shadow copy of the last
+// value uploaded to each.  Setting a uniform to the value it already has costs a memcmp instead of a GL call.
+// The shadow copies are only correct if every upload to the program goes through the same table, which is why the
+// render device uses the table of the CShaderProgram that owns the program instead of keeping its own.
+class CUniformTable
+{
+public:
+	void Reflect(GLuint program);
+	void Clear();
+
+	// Returns the index of the uniform, or -1 if the program has no active uniform with that name
+	int Find(UniformName name) const;
+	UniformType GetType(int index) const { return m_uniforms[index].type; }
+
+	// Uploads count elements of data to the uniform at index, unless they match the shadow copy
+	void Set(int index, UniformType type, const void* data, int count);
+
+	static size_t GetElementSize(UniformType type);
+
+private:
+	struct Uniform
+	{
+		uint32_t hash;
+		GLint location;
+		UniformType type;
+		GLint size;					// Number of array elements, 1 for plain uniforms
+		uint32_t offset;			// Start of the uniform's shadow copy
+		bool uploaded;				// Whether the shadow copy holds a value yet
+	};
+
+	std::vector<Uniform> m_uniforms;	// Sorted by hash
+	std::vector<uint8_t> m_shadow;
+
+	static void Upload(GLint location, UniformType type, const void* data, int count);
+};
+
+// Binding points of the uniform blocks shared by all programs.  Blocks are matched by name when a program is linked,
+// since GLSL 4.00 can't give them a binding in the shader.
+enum class UniformBlock : uint32_t { Frame, Draw, Materials, Count };
+
+// Binds the program's uniform blocks to their binding points, blocks the program doesn't declare are skipped
+void BindUniformBlocks(GLuint program);
+
+// Mirrors of the std140 blocks declared in the shaders.  vec3 members take 16 bytes unless a float follows them,
+// and a mat3 is stored as three vec4 columns.
+struct LightUniforms
+{
+	glm::vec4 position;			// In eye coordinates
+	glm::vec3 La;				// Ambient colour
+	float pad0;
+	glm::vec3 Ld;				// Diffuse colour
+	float pad1;
+	glm::vec3 Ls;				// Specular colour
+	float pad2;
+};
+
+// An entry of "Materials", the table all draws pick their material from, see CMaterialTable
+struct MaterialUniforms
+{
+	glm::vec3 Ma;				// Ambient reflectance
+	float pad0;
+	glm::vec3 Md;				// Diffuse reflectance
+	float pad1;
+	glm::vec3 Ms;				// Specular reflectance
+	float shininess;
+	uint32_t textures;			// Bit per MaterialTexture slot the material has a texture in
+	uint32_t pad2[3];
+};
+
+// "PerFrame", set once and shared by every program drawn in the frame
+struct FrameUniforms
+{
+	glm::mat4 projMatrix;
+	glm::mat4 orthoMatrix;		// For 2D drawing in window coordinates
+	glm::mat4 viewMatrix;
+	LightUniforms light1;
+	glm::vec4 clusterScale;		// Tiles per pixel in x and y, then the scale and bias giving the depth slice from log depth
+	glm::uvec4 clusterCount;	// Clusters in x, y and z, then the number of point lights
+};
+
+// "PerDraw", set before each draw
+struct DrawUniforms
+{
+	glm::mat4 modelViewMatrix;
+	glm::mat3x4 normalMatrix;
+	uint32_t materialIndex;		// Into the material table
+	uint32_t pad0[3];
+};
+
+static_assert(sizeof(LightUniforms) == 64 && sizeof(MaterialUniforms) == 64, "Uniform structs don't match std140");
+static_assert(offsetof(FrameUniforms, light1) == 192 && offsetof(FrameUniforms, clusterScale) == 256 && sizeof(FrameUniforms) == 288,
+			  "FrameUniforms doesn't match std140");
+static_assert(offsetof(DrawUniforms, normalMatrix) == 64 && offsetof(DrawUniforms, materialIndex) == 112 && sizeof(DrawUniforms) == 128,
+			  "DrawUniforms doesn't match std140");
+
+// Uniform buffer the blocks of each frame are copied into, split into one region per frame in flight.  A fence per
+// region keeps a frame from overwriting blocks the GPU may still be reading.  Must only be used on the GL thread.
+class CUniformRingBuffer
+{
+public:
+	CUniformRingBuffer();
+
+	// Copies a frame's blocks into the next region with a single memcpy and returns the offset they start at.  The
+	// buffer grows if the frame doesn't fit.
+	GLintptr BeginFrame(const void* data, size_t size);
+	// Fences the region once all draws reading from it have been submitted
+	void EndFrame();
+	void Release();
+
+	GLuint GetBuffer() const { return m_buffer; }
+	static GLint GetOffsetAlignment();
+
+private:
+	static const int FRAMES = 3;						// Frames the GPU may be behind the CPU
+	static const size_t MIN_REGION_SIZE = 64 * 1024;
+
+	GLuint m_buffer;
+	size_t m_regionSize;
+	int m_region;										// Region of the current frame
+	GLsync m_fences[FRAMES];
+
+	void Create(size_t regionSize);
+};
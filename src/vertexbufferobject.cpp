@@ -4,7 +4,18 @@
 // Constructor -- initialise member variable m_bDataUploaded to false
 CVertexBufferObject::CVertexBufferObject()
 {
+	m_vbo = 0;
 	m_dataUploaded = false;
+	m_frameSize = 0;
+	m_pMapped = nullptr;
+	m_writeRegion = 0;
+	m_writeOffset = 0;
+	m_readRegion = 0;
+	m_reportedOverflow = false;
+	for (int i = 0; i < STREAM_FRAMES; i++) {
+		m_frameBytes[i] = 0;
+		m_fences[i] = nullptr;
+	}
 }
 
 CVertexBufferObject::~CVertexBufferObject()
@@ -20,7 +31,18 @@ void CVertexBufferObject::Create()
 // Release the VBO and any associated data
 void CVertexBufferObject::Release()
 {
+	for (GLsync& fence : m_fences) {
+		if (fence != nullptr) {
+			glDeleteSync(fence);
+			fence = nullptr;
+		}
+	}
+
+	// Deleting a buffer unmaps it
 	glDeleteBuffers(1, &m_vbo);
+	m_vbo = 0;
+	m_pMapped = nullptr;
+	m_frameSize = 0;
 	m_dataUploaded = false;
 	m_data.clear();
 }
@@ -33,20 +55,95 @@ void CVertexBufferObject::Bind()
 }
 
 
-// Uploads the data to the GPU.  Afterwards, the data can be cleared.  
-// iUsageHint - GL_STATIC_DRAW, GL_DYNAMIC_DRAW...
-void CVertexBufferObject::UploadDataToGPU(int usageHint)
+// Creates the buffer with STREAM_FRAMES regions of frameSize bytes and leaves it bound
+void CVertexBufferObject::CreateStreaming(size_t frameSize)
 {
-	glBufferData(GL_ARRAY_BUFFER, m_data.size(), m_data.data(), usageHint);
-	m_dataUploaded = true;
-	m_data.clear();
+	Create();
+	Bind();
+
+	m_frameSize = frameSize;
+	const GLsizeiptr size = static_cast<GLsizeiptr>(frameSize * STREAM_FRAMES);
+
+	// Coherent, so writes reach the GPU without flushing.  The fences keep the CPU and GPU out of each other's regions.
+	if (GLAD_GL_VERSION_4_4) {
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_ARRAY_BUFFER, size, nullptr, flags);
+		m_pMapped = static_cast<uint8_t*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags));
+		if (m_pMapped == nullptr)
+			std::cerr << "Error! Failed to map the streaming vertex buffer, falling back to uploads" << std::endl;
+	}
+
+	// The store of a buffer created with glBufferStorage can't be orphaned, so the fallback needs a new buffer
+	if (m_pMapped == nullptr) {
+		if (GLAD_GL_VERSION_4_4) {
+			glDeleteBuffers(1, &m_vbo);
+			Create();
+			Bind();
+		}
+		glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_STREAM_DRAW);
+		m_data.assign(static_cast<size_t>(size), 0);
+	}
+}
+
+// Bump allocates from the current frame's region.  The offset is from the start of the buffer.
+void* CVertexBufferObject::Allocate(size_t size, size_t alignment, GLintptr& offset)
+{
+	assert(m_frameSize > 0 && "Only streaming buffers can allocate");
+
+	const size_t regionStart = m_writeRegion * m_frameSize;
+	size_t start = (regionStart + m_writeOffset + alignment - 1) / alignment * alignment;
+	if (start + size > regionStart + m_frameSize) {
+		if (!m_reportedOverflow) {
+			std::cerr << "Error! Streaming vertex buffer of " << m_frameSize << " bytes per frame is full" << std::endl;
+			m_reportedOverflow = true;
+		}
+		offset = 0;
+		return nullptr;
+	}
+
+	m_writeOffset = start + size - regionStart;
+	offset = static_cast<GLintptr>(start);
+	return (m_pMapped != nullptr ? m_pMapped : m_data.data()) + start;
+}
+
+// The render thread has taken the frame, the next one goes to the next region.  The render thread made sure the GPU
+// has finished with it before letting the main thread record again.
+void CVertexBufferObject::FinishFrameWrites()
+{
+	m_frameBytes[m_writeRegion] = m_writeOffset;
+	m_writeRegion = (m_writeRegion + 1) % STREAM_FRAMES;
+	m_writeOffset = 0;
 }
 
-// Adds data to the VBO.  
-void CVertexBufferObject::AddData(void* ptrData, GLuint dataSize)
+void CVertexBufferObject::BeginFrameReads()
 {
-	m_data.insert(m_data.end(), (uint8_t*)ptrData, (uint8_t*)ptrData+dataSize);
+	if (m_pMapped != nullptr)
+		return;
+
+	// Orphan the old store and upload only what this frame wrote, at the same offsets it was written to
+	const size_t bytes = m_frameBytes[m_readRegion];
+	const size_t regionStart = m_readRegion * m_frameSize;
+	Bind();
+	glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(m_data.size()), nullptr, GL_STREAM_DRAW);
+	if (bytes > 0)
+		glBufferSubData(GL_ARRAY_BUFFER, static_cast<GLintptr>(regionStart), static_cast<GLsizeiptr>(bytes), m_data.data() + regionStart);
 }
 
+// Fences the region the frame was drawn from, then waits until the GPU has finished with the region the main thread
+// writes to next.  With the main thread one frame ahead, that is the region read STREAM_FRAMES - 2 frames ago.
+void CVertexBufferObject::FinishFrameReads()
+{
+	const int region = m_readRegion;
+	m_readRegion = (m_readRegion + 1) % STREAM_FRAMES;
+	if (m_pMapped == nullptr)
+		return;
 
+	m_fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
 
+	GLsync& fence = m_fences[(m_readRegion + 1) % STREAM_FRAMES];
+	if (fence != nullptr) {
+		glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+		glDeleteSync(fence);
+		fence = nullptr;
+	}
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "vertexbuilder.h"
+
 // This class provides a wrapper around an OpenGL Vertex Buffer Object
 class CVertexBufferObject
 {
@@ -11,12 +13,51 @@ public:
 	void Bind();									// Binds the VBO
 	void Release();									// Releases the VBO
 
-	void AddData(void* ptrData, GLuint dataSize);	// Adds data to the VBO
-	void UploadDataToGPU(int usageHint);			// Uploads the VBO to the GPU
+	// Uploads the VBO to the GPU and points the bound vertex array's attributes at it
+	template <typename VertexType>
+	void UploadDataToGPU(const CVertexBuilder<VertexType>& builder, int usageHint)
+	{
+		glBufferData(GL_ARRAY_BUFFER, builder.GetVertexDataSize(), builder.GetVertices().data(), usageHint);
+		SetVertexAttributes<VertexType>();
+		m_dataUploaded = true;
+	}
+
+	// Streaming mode, for vertices that change every frame.  The buffer is a ring of STREAM_FRAMES regions: the main
+	// thread writes a frame's vertices straight into one region while the GPU still reads earlier frames from the
+	// others.  With GL 4.4 the regions are persistently mapped, otherwise they are staged in memory and uploaded by
+	// orphaning.  The buffer must be added to the render thread with CRenderThread::AddStreamingBuffer.
+	static const int STREAM_FRAMES = 3;
+	void CreateStreaming(size_t frameSize);			// Creates a streaming VBO taking up to frameSize bytes per frame
+
+	// Reserves count vertices in the current frame's region and returns where to write them, or nullptr if the
+	// frame is full.  firstVertex is the index to draw them from, with the attributes starting at offset 0.
+	template <typename T>
+	T* Allocate(size_t count, GLint& firstVertex)
+	{
+		GLintptr offset = 0;
+		T* pVertices = static_cast<T*>(Allocate(count * sizeof(T), sizeof(T), offset));
+		firstVertex = static_cast<GLint>(offset / static_cast<GLintptr>(sizeof(T)));
+		return pVertices;
+	}
+	void* Allocate(size_t size, size_t alignment, GLintptr& offset);
+
+	// Called by the render thread: on the main thread once a frame has been handed over, on the render thread
+	// around replaying it
+	void FinishFrameWrites();
+	void BeginFrameReads();
+	void FinishFrameReads();
 
-	
 private:
 	GLuint m_vbo;									// VBO id
-	std::vector<uint8_t> m_data;					// Data to be put in the VBO
+	std::vector<uint8_t> m_data;					// Regions staged for upload when streaming without mapping
 	bool m_dataUploaded;							// A flag indicating if the data has been sent to the GPU
-};
\ No newline at end of file
+
+	size_t m_frameSize;								// Bytes in each region, 0 unless streaming
+	uint8_t* m_pMapped;								// Persistently mapped regions, nullptr when they are staged in m_data
+	int m_writeRegion;								// Region the main thread writes the current frame into
+	size_t m_writeOffset;							// Bytes written to it so far
+	size_t m_frameBytes[STREAM_FRAMES];				// Bytes written to each region for its last frame
+	int m_readRegion;								// Region the render thread replays the next frame from
+	GLsync m_fences[STREAM_FRAMES];					// Signalled when the GPU has finished with each region
+	bool m_reportedOverflow;
+};
@@ -0,0 +1,130 @@
+#pragma once
+
+// One attribute of an interleaved vertex, as passed to glVertexAttribPointer
+struct VertexAttribute
+{
+	GLuint location;
+	GLint components;
+	GLenum type;
+	GLboolean normalised;
+	size_t offset;			// Bytes from the start of the vertex
+};
+
+// Vertex types specialise this with their attributes in a constexpr ATTRIBUTES array.  Types stored in a
+// CGeometryArena also give their FORMAT.
+template <typename VertexType>
+struct VertexLayout;
+
+// Formats of static geometry, one CGeometryArena holds one of them
+enum class VertexFormat : uint8_t
+{
+	Full,		// Vertex
+	Compact,	// CompactVertex
+};
+
+// Position, texture coordinate and normal, the inputs of the main shader
+struct Vertex
+{
+    glm::vec3 m_pos;
+    glm::vec2 m_tex;
+    glm::vec3 m_normal;
+
+    Vertex() {}
+
+    Vertex(const glm::vec3& pos, const glm::vec2& tex, const glm::vec3& normal)
+    {
+        m_pos    = pos;
+        m_tex    = tex;
+        m_normal = normal;
+    }
+};
+
+template <>
+struct VertexLayout<Vertex>
+{
+	static constexpr VertexFormat FORMAT = VertexFormat::Full;
+	static constexpr VertexAttribute ATTRIBUTES[] = {
+		{0, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, m_pos)},
+		{1, 2, GL_FLOAT, GL_FALSE, offsetof(Vertex, m_tex)},
+		{2, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, m_normal)},
+	};
+};
+
+// Half the size of Vertex, made from one by CVertexCompressor.  Positions are integers read as floats, scaled back
+// to object space by the transform of the compressor's quantisation, normals are octahedral-encoded and read by
+// the main shader's COMPACT variant.
+struct CompactVertex
+{
+	int16_t m_pos[4];		// The fourth is padding, so the other attributes start 4-byte aligned
+	uint16_t m_tex[2];		// Half floats
+	int16_t m_normal[2];	// Normalised to [-1, 1]
+};
+
+static_assert(sizeof(CompactVertex) == 16, "CompactVertex should be tightly packed");
+
+template <>
+struct VertexLayout<CompactVertex>
+{
+	static constexpr VertexFormat FORMAT = VertexFormat::Compact;
+	static constexpr VertexAttribute ATTRIBUTES[] = {
+		{0, 3, GL_SHORT, GL_FALSE, offsetof(CompactVertex, m_pos)},
+		{1, 2, GL_HALF_FLOAT, GL_FALSE, offsetof(CompactVertex, m_tex)},
+		{2, 2, GL_SHORT, GL_TRUE, offsetof(CompactVertex, m_normal)},
+	};
+};
+
+// Enables the attributes of the bound vertex array and points them at the bound array buffer, whose vertices start
+// at baseOffset
+template <typename VertexType>
+void SetVertexAttributes(GLintptr baseOffset = 0)
+{
+	for (const VertexAttribute& attribute : VertexLayout<VertexType>::ATTRIBUTES) {
+		glEnableVertexAttribArray(attribute.location);
+		glVertexAttribPointer(attribute.location, attribute.components, attribute.type, attribute.normalised,
+							  sizeof(VertexType), reinterpret_cast<const void*>(baseOffset + attribute.offset));
+	}
+}
+
+// Collects interleaved vertices, and the indices drawing them, ready to be uploaded as they are.  The counts are
+// known up front, so the storage is reserved once and never grows.
+template <typename VertexType>
+class CVertexBuilder
+{
+public:
+	CVertexBuilder() = default;
+	CVertexBuilder(size_t vertexCount, size_t indexCount = 0) { Reserve(vertexCount, indexCount); }
+
+	void Reserve(size_t vertexCount, size_t indexCount = 0)
+	{
+		m_vertices.reserve(vertexCount);
+		m_indices.reserve(indexCount);
+	}
+
+	// Returns the index of the vertex
+	uint32_t AddVertex(const VertexType& vertex)
+	{
+		assert(m_vertices.size() < m_vertices.capacity() && "More vertices than reserved");
+		m_vertices.push_back(vertex);
+		return static_cast<uint32_t>(m_vertices.size() - 1);
+	}
+
+	void AddTriangle(uint32_t index0, uint32_t index1, uint32_t index2)
+	{
+		assert(m_indices.size() + 3 <= m_indices.capacity() && "More indices than reserved");
+		m_indices.push_back(index0);
+		m_indices.push_back(index1);
+		m_indices.push_back(index2);
+	}
+
+	const std::vector<VertexType>& GetVertices() const { return m_vertices; }
+	const std::vector<uint32_t>& GetIndices() const { return m_indices; }
+	// For reordering the geometry once it is built, see CMeshOptimiser
+	std::vector<VertexType>& GetVertices() { return m_vertices; }
+	std::vector<uint32_t>& GetIndices() { return m_indices; }
+	size_t GetVertexDataSize() const { return m_vertices.size() * sizeof(VertexType); }
+	size_t GetIndexDataSize() const { return m_indices.size() * sizeof(uint32_t); }
+
+private:
+	std::vector<VertexType> m_vertices;
+	std::vector<uint32_t> m_indices;
+};
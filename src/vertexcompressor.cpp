@@ -0,0 +1,93 @@
+#include "vertexcompressor.h"
+
+glm::mat4 CVertexCompressor::Quantisation::GetTransform() const
+{
+	return glm::scale(glm::translate(glm::mat4(1.0f), centre), glm::vec3(step));
+}
+
+void CVertexCompressor::MakeEmptyBounds(glm::vec3& minimum, glm::vec3& maximum)
+{
+	minimum = glm::vec3(std::numeric_limits<float>::max());
+	maximum = glm::vec3(-std::numeric_limits<float>::max());
+}
+
+void CVertexCompressor::ExpandBounds(const std::vector<Vertex>& vertices, glm::vec3& minimum, glm::vec3& maximum)
+{
+	for (const Vertex& vertex : vertices) {
+		minimum = glm::min(minimum, vertex.m_pos);
+		maximum = glm::max(maximum, vertex.m_pos);
+	}
+}
+
+CVertexCompressor::Quantisation CVertexCompressor::Quantise(const glm::vec3& minimum, const glm::vec3& maximum)
+{
+	Quantisation quantisation;
+
+	// An empty box, nothing will be compressed with it
+	if (minimum.x > maximum.x)
+		return quantisation;
+
+	// The longest axis spans the whole grid, the others only part of it
+	const glm::vec3 extent = maximum - minimum;
+	const float longest = std::max(extent.x, std::max(extent.y, extent.z));
+	quantisation.centre = (minimum + maximum) * 0.5f;
+	if (longest > 0.0f)
+		quantisation.step = longest / (2.0f * GRID_EXTENT);
+	return quantisation;
+}
+
+void CVertexCompressor::Compress(const CVertexBuilder<Vertex>& geometry, const Quantisation& quantisation,
+								 CVertexBuilder<CompactVertex>& compressed)
+{
+	const std::vector<Vertex>& vertices = geometry.GetVertices();
+	const std::vector<uint32_t>& indices = geometry.GetIndices();
+
+	compressed.Reserve(vertices.size(), indices.size());
+	for (const Vertex& vertex : vertices) {
+		compressed.AddVertex(Compress(vertex, quantisation));
+	}
+	for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+		compressed.AddTriangle(indices[i], indices[i + 1], indices[i + 2]);
+	}
+}
+
+CompactVertex CVertexCompressor::Compress(const Vertex& vertex, const Quantisation& quantisation)
+{
+	CompactVertex compact;
+
+	const glm::vec3 grid = (vertex.m_pos - quantisation.centre) / quantisation.step;
+	for (int i = 0; i < 3; i++) {
+		compact.m_pos[i] = static_cast<int16_t>(std::lround(std::clamp(grid[i], -float(GRID_EXTENT), float(GRID_EXTENT))));
+	}
+	compact.m_pos[3] = 0;
+
+	compact.m_tex[0] = glm::packHalf1x16(vertex.m_tex.x);
+	compact.m_tex[1] = glm::packHalf1x16(vertex.m_tex.y);
+
+	const glm::vec2 normal = EncodeOctahedral(vertex.m_normal);
+	compact.m_normal[0] = QuantiseSnorm(normal.x);
+	compact.m_normal[1] = QuantiseSnorm(normal.y);
+
+	return compact;
+}
+
+glm::vec2 CVertexCompressor::EncodeOctahedral(const glm::vec3& normal)
+{
+	const float length = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+	if (length == 0.0f)
+		return glm::vec2(0.0f);
+
+	// Project onto the octahedron, then fold its lower half over the upper one's corners
+	glm::vec2 encoded = glm::vec2(normal.x, normal.y) / length;
+	if (normal.z < 0.0f) {
+		encoded = glm::vec2((1.0f - std::abs(encoded.y)) * (encoded.x >= 0.0f ? 1.0f : -1.0f),
+							(1.0f - std::abs(encoded.x)) * (encoded.y >= 0.0f ? 1.0f : -1.0f));
+	}
+	return encoded;
+}
+
+// Rounds a value in [-1, 1] to a 16-bit normalised integer, as GL reads it back for normalised GL_SHORT attributes
+int16_t CVertexCompressor::QuantiseSnorm(float value)
+{
+	return static_cast<int16_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+}
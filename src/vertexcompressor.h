@@ -0,0 +1,40 @@
+#pragma once
+
+#include "vertexbuilder.h"
+
+// Turns full precision geometry into CompactVertex: positions are rounded to a grid of 16-bit integers covering the
+// bounds, normals are octahedral-encoded into two 16-bit components and texture coordinates become half floats.
+// Nothing here touches GL, so geometry can be compressed on the job system.
+class CVertexCompressor
+{
+public:
+	// The grid positions are rounded to.  Its spacing is the same on every axis, so the transform back to object
+	// space only translates and scales uniformly, and the normal matrix made from it still keeps normals
+	// perpendicular.
+	struct Quantisation
+	{
+		glm::vec3 centre{0.0f};
+		float step = 1.0f;		// Object space distance between neighbouring grid positions
+
+		// Takes grid positions back to object space, applied before the object's own model matrix
+		glm::mat4 GetTransform() const;
+	};
+
+	// Grows the box from minimum to maximum to hold every vertex, start with an empty box from MakeEmptyBounds
+	static void MakeEmptyBounds(glm::vec3& minimum, glm::vec3& maximum);
+	static void ExpandBounds(const std::vector<Vertex>& vertices, glm::vec3& minimum, glm::vec3& maximum);
+	// The finest grid covering the box, several meshes quantised with it share one transform
+	static Quantisation Quantise(const glm::vec3& minimum, const glm::vec3& maximum);
+
+	static void Compress(const CVertexBuilder<Vertex>& geometry, const Quantisation& quantisation,
+						 CVertexBuilder<CompactVertex>& compressed);
+	static CompactVertex Compress(const Vertex& vertex, const Quantisation& quantisation);
+
+	// Folds the unit sphere onto the [-1, 1] square, see DecodeOctahedral in octahedral.glsl for the way back
+	static glm::vec2 EncodeOctahedral(const glm::vec3& normal);
+
+private:
+	static const int GRID_EXTENT = 32767;	// Grid positions go from -GRID_EXTENT to GRID_EXTENT on every axis
+
+	static int16_t QuantiseSnorm(float value);
+};
@@ -3,11 +3,12 @@
 std::vector<GLFWwindow*> Window::instances;
 Window* Window::instance; // default window ptr
 
-Window::Window(std::string title, const glm::ivec2& size, const glm::ivec2& position)
+Window::Window(std::string title, const glm::ivec2& size, const glm::ivec2& position, bool headless)
     : width{size.x}
     , height{size.y}
     , title{std::move(title)}
     , position{position}
+    , headless{headless}
 {
     initGLFW();
     initWindow(false);
@@ -44,18 +45,76 @@ void Window::initGLFW() {
     }
 
     if (instances.empty()) {
+        glfwSetErrorCallback(ErrorCallback);
+
+#ifdef GLFW_PLATFORM_NULL
+        // Headless runs prefer GLFW's null platform, which needs no display server and renders through OSMesa
+        // (llvmpipe on GPU-less machines).  If that is not available fall back to a hidden window on the default platform.
+        if (headless) {
+            glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+            if (glfwInit()) {
+                return;
+            }
+            std::cerr << "Null platform unavailable, falling back to a hidden window" << std::endl;
+            glfwInitHint(GLFW_PLATFORM, GLFW_ANY_PLATFORM);
+        }
+#endif
+
         int success = glfwInit();
         assert(success && "Failed to initialize GLFW!");
-        glfwSetErrorCallback(ErrorCallback);
     }
 }
 
 void Window::initWindow(bool fullscreen) {
     std::cout << "Creating window: " << title << " [" << width << " " << height << "]" << std::endl;
 
+    bool created = createWindow(fullscreen);
+
+#ifdef GLFW_PLATFORM_NULL
+    // The null platform can initialise even when OSMesa is missing, in which case only window or context creation fails.
+    // As long as no other window shares GLFW, restart it on the default platform and use a hidden window instead.
+    if (!created && headless && instances.empty() && glfwGetPlatform() == GLFW_PLATFORM_NULL) {
+        std::cerr << "Null platform can't create a context, falling back to a hidden window" << std::endl;
+        glfwTerminate();
+        glfwInitHint(GLFW_PLATFORM, GLFW_ANY_PLATFORM);
+        glfwSetErrorCallback(ErrorCallback);
+        created = glfwInit() && createWindow(fullscreen);
+    }
+#endif
+    assert(created && "Failed to create window!");
+
+    glfwSwapInterval(headless ? 0 : 1); // enable vsync, unless nothing is presented anyway
+    glViewport(0, 0, width, height);
+
+    if (position != glm::ivec2{ 0, 0 }) {
+        glfwSetWindowPos(window, position.x, position.y);
+    }
+
+    glfwSetWindowUserPointer(window, this);
+    glfwSetWindowPosCallback(window, PosCallback);
+    glfwSetFramebufferSizeCallback(window, FramebufferSizeCallback);
+    glfwSetWindowIconifyCallback(window, IconifyCallback);
+    glfwSetWindowFocusCallback(window, FocusCallback);
+
+    if (instance == nullptr) {
+        instance = this;
+    }
+}
+
+bool Window::createWindow(bool fullscreen) {
+    glfwDefaultWindowHints();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
 
+    if (headless) {
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+#ifdef GLFW_PLATFORM_NULL
+        if (glfwGetPlatform() == GLFW_PLATFORM_NULL) {
+            glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API);
+        }
+#endif
+    }
+
     if (fullscreen) {
         auto monitor = glfwGetPrimaryMonitor();
         auto mode = glfwGetVideoMode(monitor);
@@ -66,27 +125,22 @@ void Window::initWindow(bool fullscreen) {
     } else {
         window = glfwCreateWindow(width, height, title.c_str(), nullptr, nullptr);
     }
-    assert(window && "Failed to create window!");
-
-    glfwMakeContextCurrent(window);
-
-    int glad = gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress));
-    assert(glad && "Failed to initialize GLAD!");
-
-    glfwSwapInterval(1); // enable vsync
-    glViewport(0, 0, width, height);
 
-    if (position != glm::ivec2{ 0, 0 }) {
-        glfwSetWindowPos(window, position.x, position.y);
+    if (window == nullptr) {
+        return false;
     }
 
-    glfwSetWindowUserPointer(window, this);
-    glfwSetWindowPosCallback(window, PosCallback);
-    glfwSetFramebufferSizeCallback(window, FramebufferSizeCallback);
+    glfwMakeContextCurrent(window);
 
-    if (instance == nullptr) {
-        instance = this;
+    if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress))) {
+        std::cerr << "Error! Failed to initialize GLAD" << std::endl;
+        glfwMakeContextCurrent(nullptr);
+        glfwDestroyWindow(window);
+        window = nullptr;
+        return false;
     }
+
+    return true;
 }
 
 void Window::PosCallback(GLFWwindow* handle, int x, int y) {
@@ -95,11 +149,20 @@ void Window::PosCallback(GLFWwindow* handle, int x, int y) {
     window.position = {x, y};
 }
 
+void Window::IconifyCallback(GLFWwindow* handle, int iconified) {
+    auto& window = *reinterpret_cast<Window *>(glfwGetWindowUserPointer(handle));
+    window.iconified = iconified == GLFW_TRUE;
+}
+
+void Window::FocusCallback(GLFWwindow* handle, int focused) {
+    auto& window = *reinterpret_cast<Window *>(glfwGetWindowUserPointer(handle));
+    window.focused = focused == GLFW_TRUE;
+}
+
 void Window::FramebufferSizeCallback(GLFWwindow* handle, int width, int height) {
     auto& window = *reinterpret_cast<Window *>(glfwGetWindowUserPointer(handle));
     window.width = width;
     window.height = height;
-    glViewport(0, 0, width, height);
 }
 
 void Window::ErrorCallback(int error, const char* description) {
@@ -2,7 +2,8 @@
 
 class Window {
 public:
-    Window(std::string title, const glm::ivec2& size, const glm::ivec2& position = {});
+    // A headless window is never shown and has vsync off, see initGLFW for how its context is created
+    Window(std::string title, const glm::ivec2& size, const glm::ivec2& position = {}, bool headless = false);
     Window(std::string title);
     ~Window();
 
@@ -19,6 +20,8 @@ public:
 
     void MakeCurrent() const { glfwMakeContextCurrent(window); }
     void SwapBuffers() const { glfwSwapBuffers(window); }
+    // Applies to the context current on the calling thread
+    void SetVSync(bool enabled) const { glfwSwapInterval(enabled ? 1 : 0); }
 
     void ShowWindow(bool show = true) {
         if (show) {
@@ -51,18 +54,25 @@ public:
         glfwWaitEvents();
     }
 
+    void WaitEvents(double timeout) const {
+        glfwWaitEventsTimeout(timeout);
+    }
+
     void ToggleCursor() {
         locked = !locked;
         glfwSetInputMode(window, GLFW_CURSOR, locked ? GLFW_CURSOR_DISABLED : GLFW_CURSOR_NORMAL);
     }
 
+    // Only flips the flag, the polygon mode is applied by the frame's command buffer on the render thread
     void ToggleWireframe() {
         wireframe = !wireframe;
-        glPolygonMode(GL_FRONT_AND_BACK, wireframe ? GL_LINE : GL_FILL);
     }
 
     bool Locked() const { return locked; }
     bool Wireframe() const { return wireframe; }
+    bool Headless() const { return headless; }
+    bool Iconified() const { return iconified; }
+    bool Focused() const { return focused; }
 
 private:
     GLFWwindow* window;
@@ -73,14 +83,21 @@ private:
 
     bool locked{ false };
     bool wireframe{ false };
+    bool headless{ false };
+    bool iconified{ false };
+    bool focused{ true };
 
     void initGLFW();
     void initWindow(bool fullscreen);
+    // Creates the window and loads GL through its context, false if either step failed
+    bool createWindow(bool fullscreen);
 
     static Window* instance;
     static std::vector<GLFWwindow*> instances;
 
     static void FramebufferSizeCallback(GLFWwindow* window, int width, int height);
     static void PosCallback(GLFWwindow* window, int x, int y);
+    static void IconifyCallback(GLFWwindow* window, int iconified);
+    static void FocusCallback(GLFWwindow* window, int focused);
     static void ErrorCallback(int error, const char* description);
 };
@@ -0,0 +1,143 @@
+// Correctness tests for CMeshOptimiser: welding, the vertex cache order and the fetch order
+
+#include <random>
+
+#include "meshoptimiser.h"
+#include "test.h"
+
+using Triangle = std::array<float, 9>;
+
+static Vertex MakeVertex(float x, float y, const glm::vec3& normal = glm::vec3(0.0f, 0.0f, 1.0f))
+{
+    return Vertex(glm::vec3(x, y, 0.0f), glm::vec2(x, y), normal);
+}
+
+// A square grid of quads split in two triangles each, with the triangles in random order so the cache order has
+// something to do.  Shared corners are already welded.
+static void MakeShuffledGrid(uint32_t size, CVertexBuilder<Vertex>& grid)
+{
+    grid.Reserve((size + 1) * (size + 1), size * size * 6);
+    for (uint32_t y = 0; y <= size; y++) {
+        for (uint32_t x = 0; x <= size; x++)
+            grid.AddVertex(MakeVertex(float(x), float(y)));
+    }
+
+    std::vector<std::array<uint32_t, 3>> triangles;
+    for (uint32_t y = 0; y < size; y++) {
+        for (uint32_t x = 0; x < size; x++) {
+            uint32_t corner = y * (size + 1) + x;
+            triangles.push_back({corner, corner + 1, corner + size + 1});
+            triangles.push_back({corner + 1, corner + size + 2, corner + size + 1});
+        }
+    }
+    std::shuffle(triangles.begin(), triangles.end(), std::mt19937(1234));
+    for (const auto& triangle : triangles)
+        grid.AddTriangle(triangle[0], triangle[1], triangle[2]);
+}
+
+// The positions of every triangle's corners in order, sorted, to compare meshes whatever their vertex and triangle order
+static std::vector<Triangle> GetTriangles(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
+{
+    std::vector<Triangle> triangles(indices.size() / 3);
+    for (size_t t = 0; t < triangles.size(); t++) {
+        for (int k = 0; k < 3; k++) {
+            const glm::vec3& position = vertices[indices[t * 3 + k]].m_pos;
+            triangles[t][k * 3] = position.x;
+            triangles[t][k * 3 + 1] = position.y;
+            triangles[t][k * 3 + 2] = position.z;
+        }
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+// Copies are joined in the order they are first seen, also when the only difference is the sign of a zero
+static void TestWeld()
+{
+    std::vector<Vertex> vertices = {
+        MakeVertex(0.0f, 0.0f),
+        MakeVertex(1.0f, 0.0f),
+        MakeVertex(0.0f, 1.0f),
+        MakeVertex(0.0f, 1.0f, glm::vec3(-0.0f, 0.0f, 1.0f)),
+        MakeVertex(1.0f, 0.0f),
+        MakeVertex(1.0f, 1.0f),
+        MakeVertex(1.0f, 1.0f, glm::vec3(0.0f, 1.0f, 0.0f)),
+    };
+    std::vector<uint32_t> remap;
+    CHECK(CMeshOptimiser::GenerateWeldRemap(vertices, remap) == 5);
+    CHECK(remap == std::vector<uint32_t>({0, 1, 2, 2, 1, 3, 4}));
+
+    CHECK(CMeshOptimiser::GenerateWeldRemap({}, remap) == 0);
+    CHECK(remap.empty());
+}
+
+// The Forsyth order keeps every triangle and its winding, and does much better than random order on a grid
+static void TestVertexCacheOrder()
+{
+    CVertexBuilder<Vertex> grid;
+    MakeShuffledGrid(20, grid);
+    const auto vertexCount = static_cast<uint32_t>(grid.GetVertices().size());
+    std::vector<uint32_t> indices = grid.GetIndices();
+
+    CMeshOptimiser::OptimiseVertexCache(indices, vertexCount);
+    CHECK(indices.size() == grid.GetIndices().size());
+    CHECK(GetTriangles(grid.GetVertices(), indices) == GetTriangles(grid.GetVertices(), grid.GetIndices()));
+
+    const VertexCacheStats before = CMeshOptimiser::AnalyseVertexCache(grid.GetIndices(), vertexCount);
+    const VertexCacheStats after = CMeshOptimiser::AnalyseVertexCache(indices, vertexCount);
+    CHECK(after.triangles == before.triangles);
+    CHECK(after.GetACMR() < before.GetACMR());
+    CHECK(after.GetACMR() < 1.0f);
+
+    std::vector<uint32_t> empty;
+    CMeshOptimiser::OptimiseVertexCache(empty, 0);
+    CHECK(empty.empty());
+}
+
+// Vertices are numbered by first use and the ones no triangle uses are dropped
+static void TestFetchRemap()
+{
+    std::vector<uint32_t> remap;
+    CHECK(CMeshOptimiser::GenerateFetchRemap({5, 2, 5, 0, 2, 7}, 8, remap) == 4);
+    CHECK(remap == std::vector<uint32_t>({2, ~0u, 1, ~0u, ~0u, 0, ~0u, 3}));
+}
+
+// Every stage together leaves the same triangles, with the vertices in the order the indices first use them
+static void TestOptimise()
+{
+    CVertexBuilder<Vertex> grid;
+    MakeShuffledGrid(20, grid);
+    // Split the first triangle's corners off, as importers do, for the weld to join again
+    const auto splitCount = static_cast<uint32_t>(grid.GetVertices().size());
+    grid.Reserve(splitCount + 3, grid.GetIndices().size());
+    for (int k = 0; k < 3; k++) {
+        uint32_t& index = grid.GetIndices()[k];
+        grid.AddVertex(grid.GetVertices()[index]);
+        index = splitCount + k;
+    }
+    const std::vector<Triangle> triangles = GetTriangles(grid.GetVertices(), grid.GetIndices());
+
+    const CMeshOptimiser::Report report = CMeshOptimiser::Optimise(grid);
+    CHECK(report.before.vertices == splitCount + 3);
+    CHECK(report.after.vertices == splitCount);
+    CHECK(grid.GetVertices().size() == splitCount);
+    CHECK(report.after.GetACMR() < report.before.GetACMR());
+    CHECK(GetTriangles(grid.GetVertices(), grid.GetIndices()) == triangles);
+
+    uint32_t next = 0;
+    for (uint32_t index : grid.GetIndices()) {
+        CHECK(index <= next);
+        if (index == next)
+            next++;
+    }
+    CHECK(next == splitCount);
+}
+
+int main()
+{
+    TestWeld();
+    TestVertexCacheOrder();
+    TestFetchRemap();
+    TestOptimise();
+    return Finish("CMeshOptimiser");
+}
@@ -0,0 +1,99 @@
+// Correctness tests for CRangeAllocator, the free list of CGeometryArena's buffers
+
+#include "geometryarena.h"
+#include "test.h"
+
+static const uint32_t INVALID = CRangeAllocator::INVALID;
+
+// Each allocation takes the first free range large enough, holes before the end are reused
+static void TestFirstFit()
+{
+    CRangeAllocator allocator;
+    allocator.Reset(100);
+    CHECK(allocator.Allocate(10) == 0);
+    CHECK(allocator.Allocate(20) == 10);
+    CHECK(allocator.Allocate(30) == 30);
+    CHECK(allocator.GetFreeCount() == 40);
+
+    allocator.Free(10, 20);
+    CHECK(allocator.Allocate(5) == 10);
+    CHECK(allocator.Allocate(40) == 60);
+    CHECK(allocator.Allocate(1) == 15);
+    CHECK(allocator.Allocate(15) == INVALID);
+    CHECK(allocator.Allocate(14) == 16);
+    CHECK(allocator.GetFreeCount() == 0);
+    CHECK(allocator.Allocate(1) == INVALID);
+
+    CHECK(allocator.Allocate(0) == 0);
+}
+
+// Aligned allocations skip to the next multiple and the padding before them stays free
+static void TestAlignment()
+{
+    CRangeAllocator allocator;
+    allocator.Reset(16);
+    CHECK(allocator.Allocate(1) == 0);
+    CHECK(allocator.Allocate(4, 2) == 2);
+    CHECK(allocator.GetFreeCount() == 11);
+    CHECK(allocator.Allocate(1) == 1);
+    CHECK(allocator.Allocate(3, 4) == 8);
+    CHECK(allocator.Allocate(2) == 6);
+}
+
+// Freed ranges join their free neighbours on both sides, so the whole buffer can be allocated again
+static void TestMergeOnFree()
+{
+    CRangeAllocator allocator;
+    allocator.Reset(30);
+    CHECK(allocator.Allocate(10) == 0);
+    CHECK(allocator.Allocate(10) == 10);
+    CHECK(allocator.Allocate(10) == 20);
+
+    allocator.Free(0, 10);
+    allocator.Free(20, 10);
+    CHECK(allocator.GetFreeCount() == 20);
+    CHECK(allocator.Allocate(15) == INVALID);
+
+    allocator.Free(10, 10);
+    CHECK(allocator.GetFreeCount() == 30);
+    CHECK(allocator.Allocate(30) == 0);
+
+    // Freed in the other order, each range joins the one before it
+    allocator.Free(0, 10);
+    allocator.Free(10, 10);
+    allocator.Free(20, 10);
+    CHECK(allocator.Allocate(30) == 0);
+}
+
+// Growing adds the new elements to the free list, joined with a free range at the old end
+static void TestGrowth()
+{
+    CRangeAllocator allocator;
+    allocator.Reset(10);
+    CHECK(allocator.Allocate(8) == 0);
+    CHECK(allocator.Allocate(4) == INVALID);
+
+    allocator.Grow(20);
+    CHECK(allocator.GetCapacity() == 20);
+    CHECK(allocator.GetFreeCount() == 12);
+    CHECK(allocator.Allocate(12) == 8);
+
+    // Shrinking isn't possible
+    allocator.Grow(5);
+    CHECK(allocator.GetCapacity() == 20);
+    CHECK(allocator.GetFreeCount() == 0);
+
+    CRangeAllocator empty;
+    CHECK(empty.Allocate(1) == INVALID);
+    empty.Grow(5);
+    CHECK(empty.Allocate(5) == 0);
+}
+
+int main()
+{
+    TestFirstFit();
+    TestAlignment();
+    TestMergeOnFree();
+    TestGrowth();
+    return Finish("CRangeAllocator");
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+// Minimal checks for the correctness tests.  A failed check reports where it is and the test carries on, so one run
+// shows every failure.  Each test's main returns Finish.
+
+inline int s_failures = 0;
+
+#define CHECK(condition)                                                                        \
+    do {                                                                                        \
+        if (!(condition)) {                                                                     \
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            s_failures++;                                                                       \
+        }                                                                                       \
+    } while (false)
+
+// Reports the result and returns the exit code for it
+inline int Finish(const char* name)
+{
+    if (s_failures > 0) {
+        std::printf("%s: %d checks failed\n", name, s_failures);
+        return EXIT_FAILURE;
+    }
+    std::printf("%s: passed\n", name);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,127 @@
+// Correctness tests for CVertexCompressor: position quantisation, octahedral normals and half float texture coordinates
+
+#include "vertexcompressor.h"
+#include "test.h"
+
+static Vertex MakeVertex(const glm::vec3& position, const glm::vec2& tex = glm::vec2(0.0f),
+                         const glm::vec3& normal = glm::vec3(0.0f, 0.0f, 1.0f))
+{
+    return Vertex(position, tex, normal);
+}
+
+// The object space position of a compressed vertex, as the vertex shader computes it
+static glm::vec3 DecodePosition(const CompactVertex& compact, const CVertexCompressor::Quantisation& quantisation)
+{
+    const glm::vec4 grid(float(compact.m_pos[0]), float(compact.m_pos[1]), float(compact.m_pos[2]), 1.0f);
+    return glm::vec3(quantisation.GetTransform() * grid);
+}
+
+// DecodeOctahedral of octahedral.glsl, reading the components as GL reads normalised shorts
+static glm::vec3 DecodeNormal(const CompactVertex& compact)
+{
+    const glm::vec2 e(std::max(compact.m_normal[0] / 32767.0f, -1.0f), std::max(compact.m_normal[1] / 32767.0f, -1.0f));
+    glm::vec3 n(e.x, e.y, 1.0f - std::abs(e.x) - std::abs(e.y));
+    const float t = std::max(-n.z, 0.0f);
+    n.x += n.x >= 0.0f ? -t : t;
+    n.y += n.y >= 0.0f ? -t : t;
+    return glm::normalize(n);
+}
+
+// Positions come back within half a grid step, the box's corners land on the ends of the grid's longest axis
+static void TestQuantise()
+{
+    const std::vector<Vertex> vertices = {
+        MakeVertex(glm::vec3(-1.0f, -2.0f, 0.0f)),
+        MakeVertex(glm::vec3(3.0f, 2.0f, 1.0f)),
+        MakeVertex(glm::vec3(0.123f, -1.987f, 0.5f)),
+        MakeVertex(glm::vec3(2.999f, 0.001f, 0.75f)),
+    };
+    glm::vec3 minimum, maximum;
+    CVertexCompressor::MakeEmptyBounds(minimum, maximum);
+    CVertexCompressor::ExpandBounds(vertices, minimum, maximum);
+    CHECK(minimum == glm::vec3(-1.0f, -2.0f, 0.0f));
+    CHECK(maximum == glm::vec3(3.0f, 2.0f, 1.0f));
+
+    const CVertexCompressor::Quantisation quantisation = CVertexCompressor::Quantise(minimum, maximum);
+    CHECK(quantisation.centre == glm::vec3(1.0f, 0.0f, 0.5f));
+    CHECK(std::abs(quantisation.step - 4.0f / 65534.0f) < 1e-9f);
+
+    const CompactVertex low = CVertexCompressor::Compress(vertices[0], quantisation);
+    const CompactVertex high = CVertexCompressor::Compress(vertices[1], quantisation);
+    CHECK(low.m_pos[0] == -32767 && high.m_pos[0] == 32767);
+    CHECK(low.m_pos[1] == -32767 && high.m_pos[1] == 32767);
+    CHECK(low.m_pos[3] == 0);
+
+    // Half a step, and a little for the float arithmetic of the transform
+    const float tolerance = quantisation.step * 0.5f + 1e-6f;
+    for (const Vertex& vertex : vertices) {
+        const glm::vec3 error = glm::abs(DecodePosition(CVertexCompressor::Compress(vertex, quantisation), quantisation) - vertex.m_pos);
+        CHECK(error.x <= tolerance && error.y <= tolerance && error.z <= tolerance);
+    }
+
+    // A single point quantises to the centre of the grid, and an empty box leaves the transform the identity
+    const CVertexCompressor::Quantisation point = CVertexCompressor::Quantise(glm::vec3(2.0f), glm::vec3(2.0f));
+    CHECK(point.step == 1.0f);
+    CHECK(CVertexCompressor::Compress(MakeVertex(glm::vec3(2.0f)), point).m_pos[0] == 0);
+
+    CVertexCompressor::MakeEmptyBounds(minimum, maximum);
+    const CVertexCompressor::Quantisation empty = CVertexCompressor::Quantise(minimum, maximum);
+    CHECK(empty.centre == glm::vec3(0.0f) && empty.step == 1.0f);
+}
+
+// Unit normals all over the sphere, including both poles and the folded lower half, decode to within 1e-4 radians
+static void TestOctahedralRoundTrip()
+{
+    std::vector<glm::vec3> normals = {
+        glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f),
+        glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f),
+        glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f),
+    };
+    for (int i = 0; i < 64; i++) {
+        // A spiral from pole to pole
+        const float z = 1.0f - (i + 0.5f) / 32.0f;
+        const float radius = std::sqrt(1.0f - z * z);
+        const float angle = float(i) * 2.39996f;
+        normals.push_back(glm::vec3(radius * std::cos(angle), radius * std::sin(angle), z));
+    }
+
+    for (const glm::vec3& normal : normals) {
+        const glm::vec2 encoded = CVertexCompressor::EncodeOctahedral(normal);
+        CHECK(std::abs(encoded.x) <= 1.0f && std::abs(encoded.y) <= 1.0f);
+
+        const glm::vec3 decoded = DecodeNormal(CVertexCompressor::Compress(MakeVertex(glm::vec3(0.0f), glm::vec2(0.0f), normal),
+                                                                            CVertexCompressor::Quantisation()));
+        // For angles this small the distance between the unit vectors is the angle between them
+        CHECK(glm::length(decoded - normal) < 1e-4f);
+    }
+
+    CHECK(CVertexCompressor::EncodeOctahedral(glm::vec3(0.0f)) == glm::vec2(0.0f));
+}
+
+// Texture coordinates come back exactly when a half float holds them, otherwise to half float precision
+static void TestHalfRoundTrip()
+{
+    const float exact[] = {0.0f, 0.5f, 1.0f, -2.75f, 0.25f, 1024.0f};
+    for (float value : exact) {
+        const CompactVertex compact = CVertexCompressor::Compress(MakeVertex(glm::vec3(0.0f), glm::vec2(value, -value)),
+                                                                  CVertexCompressor::Quantisation());
+        CHECK(glm::unpackHalf1x16(compact.m_tex[0]) == value);
+        CHECK(glm::unpackHalf1x16(compact.m_tex[1]) == -value);
+    }
+
+    const float rounded[] = {0.1f, 0.333f, 0.9999f, 3.14159f};
+    for (float value : rounded) {
+        const CompactVertex compact = CVertexCompressor::Compress(MakeVertex(glm::vec3(0.0f), glm::vec2(value, 0.0f)),
+                                                                  CVertexCompressor::Quantisation());
+        // Half floats have 11 significant bits, so rounding is off by at most 2^-11 of the value
+        CHECK(std::abs(glm::unpackHalf1x16(compact.m_tex[0]) - value) <= value * (1.0f / 2048.0f));
+    }
+}
+
+int main()
+{
+    TestQuantise();
+    TestOctahedralRoundTrip();
+    TestHalfRoundTrip();
+    return Finish("CVertexCompressor");
+}